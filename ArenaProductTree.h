@@ -0,0 +1,449 @@
+// ArenaProductTree.h
+#ifndef ARENAPRODUCTTREE_H
+#define ARENAPRODUCTTREE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Metrics.h"
+#include "Product.h"
+
+// AVL index over products whose nodes live in contiguous pools.
+// Child links are 32-bit indices instead of pointers. The hot part of each
+// node (links, height) and its key are kept apart from the cold Product
+// payload, so a lookup touches two small arrays and only reads the payload
+// it returns. Freed slots are recycled through a free list. Inserts and
+// removes walk down keeping the path on a fixed-size stack and rebalance
+// back up it, so updates neither recurse nor allocate beyond the pools.
+//
+// Layout::Eytzinger additionally keeps the keys in BFS (Eytzinger) order for
+// branch-light, prefetch-friendly lookups on read-mostly catalogs. A bulk
+// build lays it out at once; after an insert or remove it is rebuilt by the
+// first lookup, under a mutex, so concurrent readers (which only hold the
+// catalog's shared lock) never see it half built.
+class ArenaProductTree {
+public:
+    enum class Layout { Avl, Eytzinger };
+
+private:
+    static constexpr std::uint32_t NIL = UINT32_MAX;
+    static constexpr int MAX_DEPTH = 96; // AVL height bound for 2^32 nodes is ~46
+
+    struct Node {
+        std::uint32_t left;
+        std::uint32_t right;
+        std::int32_t height;
+    };
+
+    std::vector<Node> nodes;         // hot: links and balance
+    std::vector<std::string> keys;   // hot: product ids, one per node slot
+    std::vector<Product> payloads;   // cold: full records, one per node slot
+    std::vector<std::uint32_t> freeSlots;
+    std::uint32_t root;
+    std::size_t count;
+
+    Layout layout;
+    mutable std::atomic<bool> eytzingerValid;
+    mutable std::mutex layoutMutex; // one reader rebuilds the layout
+    mutable std::vector<std::string_view> eytzingerKeys; // 1-based BFS order
+    mutable std::vector<std::uint32_t> eytzingerSlots;
+
+    int getHeight(std::uint32_t n) const { return n == NIL ? 0 : nodes[n].height; }
+
+    int getBalance(std::uint32_t n) const {
+        return n == NIL ? 0 : getHeight(nodes[n].left) - getHeight(nodes[n].right);
+    }
+
+    void updateHeight(std::uint32_t n) {
+        nodes[n].height = std::max(getHeight(nodes[n].left), getHeight(nodes[n].right)) + 1;
+    }
+
+    std::uint32_t rightRotate(std::uint32_t y) {
+        std::uint32_t x = nodes[y].left;
+        nodes[y].left = nodes[x].right;
+        nodes[x].right = y;
+        updateHeight(y);
+        updateHeight(x);
+        return x;
+    }
+
+    std::uint32_t leftRotate(std::uint32_t x) {
+        std::uint32_t y = nodes[x].right;
+        nodes[x].right = nodes[y].left;
+        nodes[y].left = x;
+        updateHeight(x);
+        updateHeight(y);
+        return y;
+    }
+
+    std::uint32_t rebalance(std::uint32_t n) {
+        updateHeight(n);
+        int balance = getBalance(n);
+        if (balance > 1) {
+            if (getBalance(nodes[n].left) < 0)
+                nodes[n].left = leftRotate(nodes[n].left);
+            return rightRotate(n);
+        }
+        if (balance < -1) {
+            if (getBalance(nodes[n].right) > 0)
+                nodes[n].right = rightRotate(nodes[n].right);
+            return leftRotate(n);
+        }
+        return n;
+    }
+
+    std::uint32_t allocate(const Product& product) {
+        std::uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            nodes[slot] = Node{NIL, NIL, 1};
+            keys[slot] = product.id;
+            payloads[slot] = product;
+        } else {
+            slot = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back(Node{NIL, NIL, 1});
+            keys.push_back(product.id);
+            payloads.push_back(product);
+        }
+        ++count;
+        return slot;
+    }
+
+    void release(std::uint32_t slot) {
+        keys[slot].clear();
+        payloads[slot] = Product();
+        freeSlots.push_back(slot);
+        --count;
+    }
+
+    // Rebalances path[0, depth) from the bottom up, linking each rebalanced
+    // subtree back into its parent. `subtree` is the root to return when the
+    // path is empty. Returns the new root.
+    std::uint32_t rebalancePath(const std::uint32_t* path, int depth, std::uint32_t subtree) {
+        for (int i = depth - 1; i >= 0; --i) {
+            subtree = rebalance(path[i]);
+            if (i > 0) {
+                Node& parent = nodes[path[i - 1]];
+                (parent.left == path[i] ? parent.left : parent.right) = subtree;
+            }
+        }
+        return subtree;
+    }
+
+    void insertNode(const Product& product) {
+        std::uint32_t path[MAX_DEPTH];
+        int depth = 0;
+        int cmp = 0;
+        for (std::uint32_t n = root; n != NIL; n = cmp < 0 ? nodes[n].left : nodes[n].right) {
+            cmp = product.id.compare(keys[n]);
+            if (cmp == 0) {
+                payloads[n] = product; // Update existing product
+                return;
+            }
+            path[depth++] = n;
+        }
+        std::uint32_t slot = allocate(product);
+        if (depth > 0)
+            (cmp < 0 ? nodes[path[depth - 1]].left : nodes[path[depth - 1]].right) = slot;
+        root = rebalancePath(path, depth, slot);
+    }
+
+    bool removeNode(std::string_view id) {
+        std::uint32_t path[MAX_DEPTH];
+        int depth = 0;
+        std::uint32_t n = root;
+        while (n != NIL) {
+            int cmp = id.compare(keys[n]);
+            if (cmp == 0)
+                break;
+            path[depth++] = n;
+            n = cmp < 0 ? nodes[n].left : nodes[n].right;
+        }
+        if (n == NIL)
+            return false;
+        const int at = depth;
+        std::uint32_t left = nodes[n].left, right = nodes[n].right;
+        std::uint32_t replacement = left == NIL ? right : left;
+        if (left != NIL && right != NIL) {
+            // Splice the in-order successor into this position; payloads
+            // stay in their slots, so only links change. The successor
+            // takes n's place on the path, above the nodes it leaves.
+            path[depth++] = n;
+            replacement = right;
+            while (nodes[replacement].left != NIL) {
+                path[depth++] = replacement;
+                replacement = nodes[replacement].left;
+            }
+            if (replacement != right) {
+                nodes[path[depth - 1]].left = nodes[replacement].right;
+                nodes[replacement].right = right;
+            }
+            nodes[replacement].left = left;
+            path[at] = replacement;
+        }
+        if (at > 0) {
+            Node& parent = nodes[path[at - 1]];
+            (parent.left == n ? parent.left : parent.right) = replacement;
+        }
+        release(n);
+        root = rebalancePath(path, depth, replacement);
+        return true;
+    }
+
+    std::uint32_t treeFind(std::string_view id) const {
+        std::uint32_t n = root;
+        std::uint32_t depth = 0;
+        while (n != NIL) {
+            ++depth;
+            int cmp = id.compare(keys[n]);
+            if (cmp == 0)
+                break;
+            n = cmp < 0 ? nodes[n].left : nodes[n].right;
+        }
+        METRIC_RECORD(AvlDepth, depth);
+        return n;
+    }
+
+    std::uint32_t findSlot(std::string_view id) const {
+        if (layout == Layout::Eytzinger) {
+            if (!eytzingerValid.load(std::memory_order_acquire))
+                buildEytzinger();
+            const std::size_t n = eytzingerKeys.size() - 1;
+            std::size_t k = 1;
+            std::uint32_t depth = 0;
+            while (k <= n) {
+                k = 2 * k + (eytzingerKeys[k] < id);
+                ++depth;
+            }
+            METRIC_RECORD(AvlDepth, depth);
+            // Strip the trailing right turns plus one to reach the lower bound.
+            while (k & 1)
+                k >>= 1;
+            k >>= 1;
+            return (k != 0 && eytzingerKeys[k] == id) ? eytzingerSlots[k] : NIL;
+        }
+        return treeFind(id);
+    }
+
+    template <typename Visit>
+    void inOrder(std::uint32_t n, const Visit& visit) const {
+        // Explicit stack: no recursion, depth is bounded by the AVL height.
+        std::uint32_t stack[MAX_DEPTH];
+        int top = 0;
+        while (n != NIL || top > 0) {
+            while (n != NIL) {
+                stack[top++] = n;
+                n = nodes[n].left;
+            }
+            n = stack[--top];
+            visit(n);
+            n = nodes[n].right;
+        }
+    }
+
+    void fillEytzinger(const std::vector<std::uint32_t>& sorted, std::size_t& next, std::size_t k) const {
+        if (k >= eytzingerKeys.size())
+            return;
+        fillEytzinger(sorted, next, 2 * k);
+        eytzingerSlots[k] = sorted[next];
+        eytzingerKeys[k] = keys[sorted[next]];
+        ++next;
+        fillEytzinger(sorted, next, 2 * k + 1);
+    }
+
+    void buildEytzinger() const {
+        std::lock_guard<std::mutex> lock(layoutMutex);
+        if (eytzingerValid.load(std::memory_order_relaxed))
+            return;
+        std::vector<std::uint32_t> sorted;
+        sorted.reserve(count);
+        inOrder(root, [&](std::uint32_t n) { sorted.push_back(n); });
+        eytzingerKeys.assign(count + 1, std::string_view());
+        eytzingerSlots.assign(count + 1, NIL);
+        std::size_t next = 0;
+        fillEytzinger(sorted, next, 1);
+        eytzingerValid.store(true, std::memory_order_release);
+    }
+
+    // Mutations run with no concurrent readers.
+    void invalidateLayout() { eytzingerValid.store(false, std::memory_order_relaxed); }
+
+    template <typename RowSource>
+    std::uint32_t buildRange(std::size_t lo, std::size_t hi, const RowSource& row) {
+        if (lo >= hi)
+            return NIL;
+        std::size_t mid = lo + (hi - lo) / 2;
+        std::uint32_t n = allocate(row(mid));
+        std::uint32_t left = buildRange(lo, mid, row);
+        std::uint32_t right = buildRange(mid + 1, hi, row);
+        nodes[n].left = left;
+        nodes[n].right = right;
+        updateHeight(n);
+        return n;
+    }
+
+public:
+    // In-order iterator over const Product references. It holds the path
+    // from the root on a fixed-size stack, so iterating never allocates.
+    class const_iterator {
+    private:
+        const ArenaProductTree* tree;
+        std::uint32_t stack[MAX_DEPTH];
+        int depth;
+
+        void pushLeft(std::uint32_t n) {
+            while (n != NIL) {
+                stack[depth++] = n;
+                n = tree->nodes[n].left;
+            }
+        }
+
+        friend class ArenaProductTree;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Product value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Product* pointer;
+        typedef const Product& reference;
+
+        const_iterator() : tree(nullptr), depth(0) {}
+        const_iterator(const ArenaProductTree* _tree, std::uint32_t start) : tree(_tree), depth(0) {
+            pushLeft(start);
+        }
+
+        reference operator*() const { return tree->payloads[stack[depth - 1]]; }
+        pointer operator->() const { return &tree->payloads[stack[depth - 1]]; }
+
+        const_iterator& operator++() {
+            std::uint32_t n = stack[--depth];
+            pushLeft(tree->nodes[n].right);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return depth == other.depth && (depth == 0 || stack[depth - 1] == other.stack[depth - 1]);
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    };
+
+    explicit ArenaProductTree(Layout _layout = Layout::Avl)
+        : root(NIL), count(0), layout(_layout), eytzingerValid(false) {}
+
+    void setLayout(Layout _layout) {
+        layout = _layout;
+        invalidateLayout();
+    }
+
+    void clear() {
+        nodes.clear();
+        keys.clear();
+        payloads.clear();
+        freeSlots.clear();
+        root = NIL;
+        count = 0;
+        invalidateLayout();
+    }
+
+    void insert(const Product& product) {
+        std::uint32_t existing = treeFind(product.id);
+        if (existing != NIL) {
+            payloads[existing] = product; // keys are unchanged, layout stays valid
+            return;
+        }
+        insertNode(product);
+        invalidateLayout();
+    }
+
+    // Replaces the contents with `count` rows already sorted by id, where
+    // row(i) yields the i-th Product. Allocates the pools once and links
+    // them in O(n) with no comparisons or rotations.
+    template <typename RowSource>
+    void buildFromSorted(std::size_t rows, const RowSource& row) {
+        clear();
+        nodes.reserve(rows);
+        keys.reserve(rows);
+        payloads.reserve(rows);
+        root = buildRange(0, rows, row);
+        if (layout == Layout::Eytzinger)
+            buildEytzinger();
+    }
+
+    bool remove(std::string_view id) {
+        bool removed = removeNode(id);
+        if (removed)
+            invalidateLayout();
+        return removed;
+    }
+
+    // Products are replaced through insert(), never changed in place, so
+    // the key a slot is indexed under cannot drift.
+    const Product* find(std::string_view id) const {
+        std::uint32_t n = findSlot(id);
+        return n == NIL ? nullptr : &payloads[n];
+    }
+
+    const_iterator begin() const { return const_iterator(this, root); }
+    const_iterator end() const { return const_iterator(); }
+
+    // First product whose id sorts strictly after `id`.
+    const_iterator upperBound(std::string_view id) const {
+        const_iterator it;
+        it.tree = this;
+        std::uint32_t n = root;
+        while (n != NIL) {
+            if (id < keys[n]) {
+                it.stack[it.depth++] = n;
+                n = nodes[n].left;
+            } else {
+                n = nodes[n].right;
+            }
+        }
+        return it;
+    }
+
+    // visit(const Product&) for every product in id order, without copying.
+    template <typename Visit>
+    void forEach(const Visit& visit) const {
+        inOrder(root, [&](std::uint32_t n) { visit(payloads[n]); });
+    }
+
+    // Visits up to `limit` products following `resumeToken` (empty = from the
+    // start) and returns the token for the next page, or "" once the catalog
+    // is exhausted. Tokens are product ids, so they survive mutations.
+    template <typename Visit>
+    std::string forEachPage(const std::string& resumeToken, std::size_t limit, const Visit& visit) const {
+        const_iterator it = resumeToken.empty() ? begin() : upperBound(resumeToken);
+        std::string last;
+        for (std::size_t visited = 0; it != end() && visited < limit; ++it, ++visited) {
+            visit(*it);
+            last = it->id;
+        }
+        return it == end() ? std::string() : last;
+    }
+
+    std::vector<Product> getAllProducts() const {
+        std::vector<Product> result;
+        result.reserve(count);
+        inOrder(root, [&](std::uint32_t n) { result.push_back(payloads[n]); });
+        return result;
+    }
+
+    std::size_t size() const { return count; }
+    int height() const { return getHeight(root); }
+};
+
+#endif
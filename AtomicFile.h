@@ -0,0 +1,81 @@
+// AtomicFile.h
+#ifndef ATOMICFILE_H
+#define ATOMICFILE_H
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "Metrics.h"
+
+// Flushes a file's contents (or, for a directory, its entries) to stable
+// storage. Directories cannot be synced on Windows; that is a no-op there.
+inline bool syncPath(const std::string& path, bool directory = false) {
+#ifdef _WIN32
+    if (directory)
+        return true;
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0)
+        return false;
+    bool ok = _commit(fd) == 0;
+    _close(fd);
+#else
+    int fd = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    if (fd < 0)
+        return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+#endif
+    METRIC_ADD(Fsyncs, 1);
+    return ok;
+}
+
+// Moves a finished temporary file over `path` so that a crash at any
+// point leaves either the old or the new file, whole: the temporary's data
+// is fsynced before the rename, and the directory after it so the rename
+// itself is durable.
+inline bool replaceFile(const std::string& temp, const std::string& path) {
+    std::error_code ec;
+    const std::uintmax_t bytes = std::filesystem::file_size(temp, ec);
+    if (ec || !syncPath(temp)) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    syncPath(directory.empty() ? "." : directory, true);
+    METRIC_ADD(BytesWritten, bytes);
+    return true;
+}
+
+// Writes `path` through `path`.tmp with replaceFile. write(std::ostream&)
+// produces the contents. On failure the old file is left as it was.
+template <typename Write>
+bool writeFileAtomically(const std::string& path, const Write& write, std::ios::openmode mode = std::ios::out) {
+    const std::string temp = path + ".tmp";
+    std::ofstream ofs(temp, mode | std::ios::trunc);
+    if (!ofs.is_open())
+        return false;
+    write(ofs);
+    ofs.close();
+    if (!ofs) {
+        std::error_code ec;
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    return replaceFile(temp, path);
+}
+
+#endif
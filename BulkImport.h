@@ -0,0 +1,228 @@
+// BulkImport.h
+#ifndef BULKIMPORT_H
+#define BULKIMPORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "AtomicFile.h"
+#include "CustomHashTable.h"
+#include "ThreadPool.h"
+
+// What an import does with a row whose id already exists.
+enum class ConflictPolicy {
+    Upsert, // replace the stored record
+    Skip,   // keep the stored record
+    Fail    // apply nothing if any row conflicts
+};
+
+inline bool parseConflictPolicy(std::string_view text, ConflictPolicy& policy) {
+    if (text == "upsert")
+        policy = ConflictPolicy::Upsert;
+    else if (text == "skip")
+        policy = ConflictPolicy::Skip;
+    else if (text == "fail")
+        policy = ConflictPolicy::Fail;
+    else
+        return false;
+    return true;
+}
+
+struct ImportReport {
+    static constexpr std::size_t MAX_PROBLEMS = 20;
+
+    std::size_t rows = 0;       // data lines read
+    std::size_t inserted = 0;   // new ids
+    std::size_t updated = 0;    // existing ids replaced (upsert)
+    std::size_t skipped = 0;    // existing ids kept (skip)
+    std::size_t duplicates = 0; // earlier rows overridden by a later row with the same id
+    std::size_t invalid = 0;    // rows that failed to parse or validate
+    bool aborted = false;       // fail policy hit a conflict
+    std::vector<std::string> problems; // first MAX_PROBLEMS, "line N: reason"
+
+    void note(std::size_t line, const std::string& reason) {
+        if (problems.size() < MAX_PROBLEMS)
+            problems.push_back("line " + std::to_string(line) + ": " + reason);
+    }
+
+    void print(std::ostream& out) const {
+        out << rows << " rows: " << inserted << " inserted, " << updated << " updated, " << skipped
+            << " skipped, " << duplicates << " duplicates, " << invalid << " invalid"
+            << (aborted ? " (aborted, nothing applied)" : "") << std::endl;
+        for (const std::string& problem : problems)
+            out << "  " << problem << std::endl;
+    }
+};
+
+// CSV import in four stages: parse and validate (parallel over chunks of
+// the file), dedupe (a later row with the same id wins), then apply with a
+// conflict policy. The caller applies all rows under its own locks and
+// commits once afterwards.
+template <typename Record>
+class CsvImportPipeline {
+public:
+    struct Row {
+        std::size_t line;
+        Record record;
+    };
+
+private:
+    struct Chunk {
+        std::string_view text;
+        std::size_t lines = 0;
+        std::vector<Row> rows;
+        std::vector<std::pair<std::size_t, std::string>> errors; // local line, reason
+    };
+
+    // Splits at line boundaries into about `pieces` chunks.
+    static std::vector<Chunk> split(std::string_view text, std::size_t pieces) {
+        std::vector<Chunk> chunks;
+        std::size_t target = std::max<std::size_t>(text.size() / std::max<std::size_t>(pieces, 1), 1 << 16);
+        while (!text.empty()) {
+            std::size_t end = std::min(target, text.size());
+            std::size_t newline = text.find('\n', end - 1);
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
+            chunks.emplace_back();
+            chunks.back().text = text.substr(0, end);
+            text.remove_prefix(end);
+        }
+        return chunks;
+    }
+
+public:
+    // parse(std::string_view line, Record& out, std::string& error) -> bool
+    // keyOf(const Record&) -> std::string
+    // A first line starting with "id," is taken as a header and skipped.
+    template <typename Parse, typename KeyOf>
+    static std::vector<Row> prepare(std::string_view text, ThreadPool& pool, const Parse& parse,
+                                    const KeyOf& keyOf, ImportReport& report) {
+        std::size_t firstLine = 1;
+        if (text.size() >= 3 && (text[0] == 'i' || text[0] == 'I') && (text[1] == 'd' || text[1] == 'D') &&
+            text[2] == ',') {
+            std::size_t newline = text.find('\n');
+            text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+            firstLine = 2;
+        }
+        std::vector<Chunk> chunks = split(text, pool.size() * 4);
+        for (Chunk& chunk : chunks) {
+            pool.submit([&chunk, &parse] {
+                std::string_view rest = chunk.text;
+                std::string error;
+                while (!rest.empty()) {
+                    std::size_t end = rest.find('\n');
+                    std::string_view line = rest.substr(0, end);
+                    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+                    ++chunk.lines;
+                    if (!line.empty() && line.back() == '\r')
+                        line.remove_suffix(1);
+                    if (line.empty())
+                        continue;
+                    Row row{chunk.lines, Record()};
+                    error.clear();
+                    if (parse(line, row.record, error))
+                        chunk.rows.push_back(std::move(row));
+                    else
+                        chunk.errors.emplace_back(chunk.lines, error);
+                }
+            });
+        }
+        pool.wait();
+
+        // Number the lines and keep the last row per id.
+        std::vector<Row> rows;
+        CustomHashTable<std::string, std::uint32_t> byKey(1024);
+        std::size_t base = firstLine - 1;
+        for (Chunk& chunk : chunks) {
+            for (auto& error : chunk.errors) {
+                ++report.invalid;
+                report.note(base + error.first, error.second);
+            }
+            for (Row& row : chunk.rows) {
+                row.line += base;
+                std::string key = keyOf(row.record);
+                if (std::uint32_t* earlier = byKey.find(key)) {
+                    ++report.duplicates;
+                    rows[*earlier] = std::move(row);
+                } else {
+                    byKey.insert(key, static_cast<std::uint32_t>(rows.size()));
+                    rows.push_back(std::move(row));
+                }
+            }
+            report.rows += chunk.rows.size() + chunk.errors.size();
+            base += chunk.lines;
+        }
+        return rows;
+    }
+
+    // exists(const Record&) -> bool; store(Record&, bool existed, std::string&
+    // reason) -> bool, where false rejects the row as invalid for `reason`.
+    template <typename Exists, typename Store>
+    static void apply(std::vector<Row>& rows, ConflictPolicy policy, const Exists& exists, const Store& store,
+                      ImportReport& report) {
+        if (policy == ConflictPolicy::Fail) {
+            for (const Row& row : rows) {
+                if (exists(row.record)) {
+                    report.aborted = true;
+                    report.note(row.line, "id already exists");
+                }
+            }
+            if (report.aborted)
+                return;
+        }
+        for (Row& row : rows) {
+            bool existed = exists(row.record);
+            if (existed && policy == ConflictPolicy::Skip) {
+                ++report.skipped;
+                continue;
+            }
+            std::string reason;
+            if (!store(row.record, existed, reason)) {
+                ++report.invalid;
+                report.note(row.line, reason);
+                continue;
+            }
+            ++(existed ? report.updated : report.inserted);
+        }
+    }
+};
+
+// Writes `items` to `path`, one format(const Item&, std::string& out) call
+// per item, with chunks formatted in parallel and written in order. The
+// file is replaced through replaceFile, so readers never see half of it.
+template <typename Item, typename Format>
+bool writeCsvParallel(const std::string& path, const std::vector<Item>& items, ThreadPool& pool,
+                      const Format& format) {
+    const std::size_t pieces = std::max<std::size_t>(1, std::min(items.size() / 1024 + 1, pool.size() * 4));
+    std::vector<std::string> buffers(pieces);
+    const std::size_t per = (items.size() + pieces - 1) / pieces;
+    for (std::size_t p = 0; p < pieces; ++p) {
+        pool.submit([&, p] {
+            std::size_t first = p * per, last = std::min(items.size(), first + per);
+            for (std::size_t i = first; i < last; ++i)
+                format(items[i], buffers[p]);
+        });
+    }
+    pool.wait();
+    const std::string temp = path + ".tmp";
+    std::ofstream ofs(temp, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "Error writing to " << path << std::endl;
+        return false;
+    }
+    for (const std::string& buffer : buffers)
+        ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    ofs.close();
+    if (!ofs || !replaceFile(temp, path)) {
+        std::cerr << "Error writing to " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#endif
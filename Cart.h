@@ -0,0 +1,148 @@
+// Cart.h
+#ifndef CART_H
+#define CART_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Money.h"
+#include "Product.h"
+#include "SmallVector.h"
+#include "StockReservations.h"
+
+// One line of a cart: the product, how many, and its price when it was
+// added, which is what checkout charges. Names come from the catalog.
+struct CartItem {
+    std::string productId;
+    int quantity;
+    Money unitPrice;
+};
+
+// Cart class
+// Every unit in the cart is backed by a stock reservation. Clearing the
+// cart (or destroying it) hands the reserved units back to stock.
+// Lines are kept inline for small carts, and the total is kept up to date
+// as lines change rather than summed on every display. Move-only, since it
+// owns its reservations.
+class Cart {
+private:
+    typedef StockReservations::Hold Hold;
+
+    SmallVector<CartItem, 4> items;
+    Money total;
+    StockReservations* reservations;
+    std::vector<std::pair<std::string, Hold*>> holds; // product id, reservation
+
+public:
+    typedef SmallVector<CartItem, 4> Items;
+
+    explicit Cart(StockReservations* _reservations = nullptr) : reservations(_reservations) {}
+    ~Cart() { clearCart(); }
+
+    Cart(const Cart&) = delete;
+    Cart& operator=(const Cart&) = delete;
+
+    Cart(Cart&& other) noexcept
+        : items(std::move(other.items)), total(other.total), reservations(other.reservations),
+          holds(std::move(other.holds)) {
+        other.holds.clear();
+        other.total = Money();
+    }
+
+    Cart& operator=(Cart&& other) noexcept {
+        if (this != &other) {
+            clearCart();
+            items = std::move(other.items);
+            total = other.total;
+            reservations = other.reservations;
+            holds = std::move(other.holds);
+            other.holds.clear();
+            other.total = Money();
+        }
+        return *this;
+    }
+
+    void addProduct(const Product& product, int quantity, Hold* hold = nullptr) {
+        CartItem* line = nullptr;
+        for (CartItem& item : items) {
+            if (item.productId == product.id) {
+                line = &item;
+                break;
+            }
+        }
+        if (line)
+            line->quantity += quantity;
+        else
+            line = &items.emplace_back(CartItem{product.id, quantity, product.price});
+        total += line->unitPrice * quantity;
+        if (hold)
+            holds.push_back({product.id, hold});
+    }
+
+    const Items& getItems() const { return items; }
+
+    Money getTotalPrice() const { return total; }
+
+    bool hasExpiredHold(const std::string& productId) const {
+        for (const auto& entry : holds) {
+            if (entry.first == productId && entry.second->isExpired())
+                return true;
+        }
+        return false;
+    }
+
+    // productName(const std::string& id) gives the name to show.
+    template <typename ProductName>
+    void displayCart(const ProductName& productName) const {
+        if (items.empty()) {
+            std::cout << "Cart is empty." << std::endl;
+            return;
+        }
+        std::cout << "\n--- Cart Contents ---" << std::endl;
+        for (const CartItem& item : items) {
+            std::cout << productName(item.productId) << " x " << item.quantity << " = $"
+                 << (item.unitPrice * item.quantity);
+            if (hasExpiredHold(item.productId))
+                std::cout << " (reservation expired)";
+            std::cout << std::endl;
+        }
+        std::cout << "Total: $" << getTotalPrice() << std::endl;
+    }
+
+    // Pins every reservation for checkout. On failure nothing stays pinned
+    // and `failedProductId` names the product that is no longer available.
+    bool claimHolds(std::string& failedProductId) {
+        for (std::size_t i = 0; i < holds.size(); ++i) {
+            if (!reservations->claim(holds[i].second)) {
+                failedProductId = holds[i].first;
+                while (i-- > 0)
+                    reservations->unclaim(holds[i].second);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Turns the claimed reservations into sales and empties the cart.
+    // visit(productId, onHandAfter) runs once per reservation.
+    template <typename Visit>
+    void commitHolds(const Visit& visit) {
+        for (const auto& entry : holds)
+            visit(entry.first, reservations->commit(entry.second));
+        holds.clear();
+        items.clear();
+        total = Money();
+    }
+
+    void clearCart() {
+        for (const auto& entry : holds)
+            reservations->release(entry.second);
+        holds.clear();
+        items.clear();
+        total = Money();
+    }
+};
+
+#endif
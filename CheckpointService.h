@@ -0,0 +1,94 @@
+// CheckpointService.h
+#ifndef CHECKPOINTSERVICE_H
+#define CHECKPOINTSERVICE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "Metrics.h"
+
+// Runs checkpoints on a background thread so that the thread whose commit
+// made one due does not wait for the snapshot files. request() returns at
+// once; requests that arrive while one is already pending, or during the
+// short settle delay before it runs, are folded into that single run.
+// runNow() checkpoints on the calling thread, still one run at a time.
+class CheckpointService {
+private:
+    std::function<void()> checkpoint;
+    std::chrono::milliseconds settle;
+    std::mutex runMutex; // one checkpoint at a time, background or not
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    bool requested;
+    bool stopping;
+    std::thread worker;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || requested; });
+            if (stopping)
+                return;
+            // Let a burst of commits land before taking the snapshot.
+            wake.wait_for(lock, settle, [this] { return stopping; });
+            requested = false;
+            lock.unlock();
+            runNow();
+            lock.lock();
+        }
+    }
+
+public:
+    explicit CheckpointService(std::function<void()> _checkpoint,
+                               std::chrono::milliseconds settleDelay = std::chrono::milliseconds(20))
+        : checkpoint(std::move(_checkpoint)), settle(settleDelay), requested(false), stopping(false) {}
+
+    // A request still pending at stop() is dropped; the caller checkpoints
+    // with runNow() at shutdown.
+    ~CheckpointService() { stop(); }
+
+    CheckpointService(const CheckpointService&) = delete;
+    CheckpointService& operator=(const CheckpointService&) = delete;
+
+    void start() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = false;
+        if (!worker.joinable())
+            worker = std::thread([this] { work(); });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    // Without a running worker the checkpoint runs inline.
+    void request() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (worker.joinable() && !stopping) {
+                if (requested)
+                    METRIC_ADD(CheckpointsCoalesced, 1);
+                requested = true;
+                wake.notify_one();
+                return;
+            }
+        }
+        runNow();
+    }
+
+    void runNow() {
+        std::lock_guard<std::mutex> lock(runMutex);
+        checkpoint();
+    }
+};
+
+#endif
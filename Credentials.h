@@ -0,0 +1,339 @@
+// Credentials.h
+#ifndef CREDENTIALS_H
+#define CREDENTIALS_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// SHA-256 (FIPS 180-4), enough for HMAC and PBKDF2 below.
+class Sha256 {
+private:
+    std::array<std::uint32_t, 8> state;
+    std::array<std::uint8_t, 64> block;
+    std::size_t blockLength;
+    std::uint64_t totalLength;
+
+    static std::uint32_t rotr(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void compress(const std::uint8_t* chunk) {
+        static const std::uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        std::uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (std::uint32_t(chunk[4 * i]) << 24) | (std::uint32_t(chunk[4 * i + 1]) << 16) |
+                   (std::uint32_t(chunk[4 * i + 2]) << 8) | std::uint32_t(chunk[4 * i + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            std::uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            std::uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+public:
+    using Digest = std::array<std::uint8_t, 32>;
+
+    Sha256() { reset(); }
+
+    void reset() {
+        state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        blockLength = 0;
+        totalLength = 0;
+    }
+
+    void update(const void* data, std::size_t length) {
+        const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+        totalLength += length;
+        while (length > 0) {
+            std::size_t take = std::min(length, block.size() - blockLength);
+            std::memcpy(block.data() + blockLength, bytes, take);
+            blockLength += take;
+            bytes += take;
+            length -= take;
+            if (blockLength == block.size()) {
+                compress(block.data());
+                blockLength = 0;
+            }
+        }
+    }
+
+    Digest finish() {
+        std::uint64_t bits = totalLength * 8;
+        std::uint8_t pad = 0x80;
+        update(&pad, 1);
+        pad = 0;
+        while (blockLength != 56)
+            update(&pad, 1);
+        std::uint8_t length[8];
+        for (int i = 0; i < 8; ++i)
+            length[i] = static_cast<std::uint8_t>(bits >> (56 - 8 * i));
+        update(length, 8);
+        Digest digest;
+        for (int i = 0; i < 8; ++i) {
+            digest[4 * i] = static_cast<std::uint8_t>(state[i] >> 24);
+            digest[4 * i + 1] = static_cast<std::uint8_t>(state[i] >> 16);
+            digest[4 * i + 2] = static_cast<std::uint8_t>(state[i] >> 8);
+            digest[4 * i + 3] = static_cast<std::uint8_t>(state[i]);
+        }
+        reset();
+        return digest;
+    }
+};
+
+// HMAC-SHA256 with the key's inner and outer pads hashed once, so each
+// PBKDF2 iteration costs two compressions of the 32-byte chain value.
+class HmacSha256 {
+private:
+    Sha256 inner, outer;
+
+public:
+    explicit HmacSha256(std::string_view key) {
+        std::array<std::uint8_t, 64> pad{};
+        if (key.size() > pad.size()) {
+            Sha256 keyHash;
+            keyHash.update(key.data(), key.size());
+            Sha256::Digest digest = keyHash.finish();
+            std::memcpy(pad.data(), digest.data(), digest.size());
+        } else {
+            std::memcpy(pad.data(), key.data(), key.size());
+        }
+        for (auto& byte : pad)
+            byte ^= 0x36;
+        inner.update(pad.data(), pad.size());
+        for (auto& byte : pad)
+            byte ^= 0x36 ^ 0x5c;
+        outer.update(pad.data(), pad.size());
+    }
+
+    Sha256::Digest mac(const void* data, std::size_t length) const {
+        Sha256 in = inner;
+        in.update(data, length);
+        Sha256::Digest digest = in.finish();
+        Sha256 out = outer;
+        out.update(digest.data(), digest.size());
+        return out.finish();
+    }
+};
+
+// PBKDF2-HMAC-SHA256 (RFC 8018), one 32-byte block.
+inline Sha256::Digest pbkdf2Sha256(std::string_view password, std::string_view salt, std::uint32_t iterations) {
+    HmacSha256 prf(password);
+    std::string first(salt);
+    first += std::string("\0\0\0\1", 4);
+    Sha256::Digest u = prf.mac(first.data(), first.size());
+    Sha256::Digest result = u;
+    for (std::uint32_t i = 1; i < iterations; ++i) {
+        u = prf.mac(u.data(), u.size());
+        for (std::size_t j = 0; j < result.size(); ++j)
+            result[j] ^= u[j];
+    }
+    return result;
+}
+
+// Compares without an early exit, so the time taken does not reveal how
+// many leading bytes matched.
+inline bool constantTimeEquals(std::string_view a, std::string_view b) {
+    unsigned char diff = static_cast<unsigned char>(a.size() != b.size());
+    std::size_t n = std::min(a.size(), b.size());
+    for (std::size_t i = 0; i < n; ++i)
+        diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+inline std::string toHex(const std::uint8_t* bytes, std::size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(length * 2, '0');
+    for (std::size_t i = 0; i < length; ++i) {
+        hex[2 * i] = digits[bytes[i] >> 4];
+        hex[2 * i + 1] = digits[bytes[i] & 0xf];
+    }
+    return hex;
+}
+
+inline std::string randomHex(std::size_t bytes) {
+    static std::mutex mutex;
+    static std::random_device device;
+    std::string raw(bytes, '\0');
+    std::lock_guard<std::mutex> lock(mutex);
+    for (char& byte : raw)
+        byte = static_cast<char>(device() & 0xff);
+    return toHex(reinterpret_cast<const std::uint8_t*>(raw.data()), raw.size());
+}
+
+// How stored password hashes are made and checked. A backend recognizes
+// its own format; anything it does not recognize is left to the caller.
+class CredentialBackend {
+public:
+    virtual ~CredentialBackend() = default;
+    virtual std::string hash(std::string_view password) const = 0;
+    virtual bool recognizes(std::string_view stored) const = 0;
+    virtual bool verify(std::string_view password, std::string_view stored) const = 0;
+    // True if `stored` should be re-hashed at the current cost.
+    virtual bool needsRehash(std::string_view stored) const = 0;
+};
+
+// "pbkdf2-sha256$<iterations>$<salt hex>$<hash hex>". The iteration count
+// is the cost knob; hashes made at a lower count verify at their own cost
+// and are upgraded on the next login.
+class Pbkdf2Backend : public CredentialBackend {
+private:
+    static constexpr std::string_view PREFIX = "pbkdf2-sha256$";
+    std::uint32_t iterations;
+
+    static bool split(std::string_view stored, std::uint32_t& rounds, std::string_view& salt,
+                      std::string_view& digest) {
+        if (stored.substr(0, PREFIX.size()) != PREFIX)
+            return false;
+        stored.remove_prefix(PREFIX.size());
+        std::size_t first = stored.find('$');
+        std::size_t second = first == std::string_view::npos ? first : stored.find('$', first + 1);
+        if (second == std::string_view::npos || first == 0 || first > 9)
+            return false;
+        rounds = 0;
+        for (char c : stored.substr(0, first)) {
+            if (c < '0' || c > '9')
+                return false;
+            rounds = rounds * 10 + static_cast<std::uint32_t>(c - '0');
+        }
+        salt = stored.substr(first + 1, second - first - 1);
+        digest = stored.substr(second + 1);
+        return rounds > 0;
+    }
+
+public:
+    static constexpr std::uint32_t DEFAULT_ITERATIONS = 100000;
+
+    explicit Pbkdf2Backend(std::uint32_t _iterations = DEFAULT_ITERATIONS)
+        : iterations(_iterations > 0 ? _iterations : 1) {}
+
+    std::uint32_t getIterations() const { return iterations; }
+
+    std::string hash(std::string_view password) const override {
+        std::string salt = randomHex(16);
+        Sha256::Digest digest = pbkdf2Sha256(password, salt, iterations);
+        return std::string(PREFIX) + std::to_string(iterations) + "$" + salt + "$" +
+               toHex(digest.data(), digest.size());
+    }
+
+    bool recognizes(std::string_view stored) const override {
+        return stored.substr(0, PREFIX.size()) == PREFIX;
+    }
+
+    bool verify(std::string_view password, std::string_view stored) const override {
+        std::uint32_t rounds;
+        std::string_view salt, expected;
+        if (!split(stored, rounds, salt, expected))
+            return false;
+        Sha256::Digest digest = pbkdf2Sha256(password, salt, rounds);
+        return constantTimeEquals(toHex(digest.data(), digest.size()), expected);
+    }
+
+    bool needsRehash(std::string_view stored) const override {
+        std::uint32_t rounds;
+        std::string_view salt, expected;
+        return !split(stored, rounds, salt, expected) || rounds < iterations;
+    }
+};
+
+// The unsalted std::hash<std::string> decimal strings written by earlier
+// versions. Verify-only; a match is re-hashed by the current backend.
+class LegacyHashBackend : public CredentialBackend {
+public:
+    std::string hash(std::string_view password) const override {
+        return std::to_string(std::hash<std::string_view>{}(password));
+    }
+
+    bool recognizes(std::string_view stored) const override {
+        return !stored.empty() && stored.find_first_not_of("0123456789") == std::string_view::npos;
+    }
+
+    bool verify(std::string_view password, std::string_view stored) const override {
+        return constantTimeEquals(hash(password), stored);
+    }
+
+    bool needsRehash(std::string_view) const override { return true; }
+};
+
+// Tokens handed out after a successful password check. Presenting a live
+// token proves the same identity without running the KDF again. Tokens are
+// random, held only in memory and expire after the TTL.
+class SessionTokenCache {
+private:
+    struct Entry {
+        std::string username;
+        std::chrono::steady_clock::time_point expiresAt;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> tokens;
+    std::chrono::seconds ttl;
+
+public:
+    explicit SessionTokenCache(std::chrono::seconds _ttl = std::chrono::minutes(30)) : ttl(_ttl) {}
+
+    std::string issue(const std::string& username) {
+        std::string token = randomHex(16);
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        // Sweep expired tokens as new ones arrive, so the map stays small.
+        for (auto it = tokens.begin(); it != tokens.end();)
+            it = it->second.expiresAt <= now ? tokens.erase(it) : std::next(it);
+        tokens[token] = {username, now + ttl};
+        return token;
+    }
+
+    bool validate(const std::string& token, std::string& username) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = tokens.find(token);
+        if (it == tokens.end() || it->second.expiresAt <= std::chrono::steady_clock::now())
+            return false;
+        username = it->second.username;
+        return true;
+    }
+
+    void revoke(const std::string& token) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tokens.erase(token);
+    }
+};
+
+#endif
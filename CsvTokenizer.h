@@ -0,0 +1,238 @@
+// CsvTokenizer.h
+#ifndef CSVTOKENIZER_H
+#define CSVTOKENIZER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+// One record from CsvTokenizer. Fields are views into the tokenized text,
+// or into the row's own buffer for quoted fields that contained "" escapes,
+// so they stay valid until the row is reused or the text goes away.
+class CsvRow {
+    friend class CsvTokenizer;
+
+    struct Escaped {
+        std::size_t field, offset, length;
+    };
+
+    std::vector<std::string_view> fields;
+    std::string unescaped;
+    std::vector<Escaped> escaped;
+    std::size_t lineNumber = 0;
+
+public:
+    std::size_t size() const { return fields.size(); }
+    std::string_view operator[](std::size_t index) const { return fields[index]; }
+    std::string str(std::size_t index) const { return std::string(fields[index]); }
+
+    // Line on which the record starts, counting from 1.
+    std::size_t line() const { return lineNumber; }
+
+    // Parses a whole field as a number; false if it is empty, has trailing
+    // characters or does not fit.
+    template <typename Number>
+    bool number(std::size_t index, Number& value) const {
+        if (index >= fields.size())
+            return false;
+        std::string_view field = fields[index];
+        auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+        return result.ec == std::errc() && result.ptr == field.data() + field.size();
+    }
+};
+
+// Splits delimited text (RFC 4180 CSV by default) into records without
+// copying: a pass over the bytes that records where each field starts and
+// ends. Quoted fields may contain the delimiter, newlines and "" for a
+// quote. Blank lines are skipped and a trailing '\r' is dropped. A
+// malformed record stops the scan and error() names its line.
+class CsvTokenizer {
+private:
+    std::string_view text;
+    std::size_t pos;
+    std::size_t line;
+    char delimiter;
+    std::string errorMessage;
+
+    bool fail(const char* reason) {
+        errorMessage = "line " + std::to_string(line) + ": " + reason;
+        pos = text.size();
+        return false;
+    }
+
+    bool atRecordEnd() const { return pos >= text.size() || text[pos] == '\n' || text[pos] == '\r'; }
+
+    void skipRecordEnd() {
+        if (pos < text.size() && text[pos] == '\r')
+            ++pos;
+        if (pos < text.size() && text[pos] == '\n') {
+            ++pos;
+            ++line;
+        }
+    }
+
+    // Reads a quoted field starting at the opening quote.
+    bool readQuoted(CsvRow& row) {
+        const std::size_t start = ++pos;
+        bool hasEscapes = false;
+        std::size_t offset = row.unescaped.size();
+        while (true) {
+            std::size_t quote = text.find('"', pos);
+            if (quote == std::string_view::npos)
+                return fail("unterminated quoted field");
+            for (std::size_t i = pos; i < quote; ++i)
+                line += text[i] == '\n';
+            if (quote + 1 < text.size() && text[quote + 1] == '"') {
+                if (!hasEscapes) {
+                    hasEscapes = true;
+                    row.unescaped.append(text.data() + start, quote + 1 - start);
+                } else {
+                    row.unescaped.append(text.data() + pos, quote + 1 - pos);
+                }
+                pos = quote + 2;
+                continue;
+            }
+            if (hasEscapes) {
+                row.unescaped.append(text.data() + pos, quote - pos);
+                row.escaped.push_back({row.fields.size(), offset, row.unescaped.size() - offset});
+                row.fields.emplace_back();
+            } else {
+                row.fields.push_back(text.substr(start, quote - start));
+            }
+            pos = quote + 1;
+            if (!atRecordEnd() && text[pos] != delimiter)
+                return fail("unexpected character after closing quote");
+            return true;
+        }
+    }
+
+public:
+    // `firstLine` numbers the first line of `text`, for a chunk cut from
+    // the middle of a file.
+    explicit CsvTokenizer(std::string_view _text, char _delimiter = ',', std::size_t firstLine = 1)
+        : text(_text), pos(0), line(firstLine), delimiter(_delimiter) {}
+
+    // Fills `row` with the next record. Returns false at the end of the
+    // text, or on a malformed record (then error() is not empty).
+    bool next(CsvRow& row) {
+        row.fields.clear();
+        row.unescaped.clear();
+        row.escaped.clear();
+        while (pos < text.size() && (text[pos] == '\n' || text[pos] == '\r')) {
+            line += text[pos] == '\n';
+            ++pos;
+        }
+        if (pos >= text.size())
+            return false;
+        row.lineNumber = line;
+        while (true) {
+            if (text[pos] == '"') {
+                if (!readQuoted(row))
+                    return false;
+            } else {
+                std::size_t start = pos;
+                while (pos < text.size() && text[pos] != delimiter && text[pos] != '\n')
+                    ++pos;
+                std::size_t end = pos;
+                if (end > start && text[end - 1] == '\r')
+                    --end;
+                row.fields.push_back(text.substr(start, end - start));
+            }
+            if (pos < text.size() && text[pos] == delimiter) {
+                ++pos;
+                if (pos >= text.size() || text[pos] == '\n' || text[pos] == '\r') {
+                    row.fields.emplace_back(); // trailing delimiter: empty last field
+                    break;
+                }
+                continue;
+            }
+            break;
+        }
+        skipRecordEnd();
+        // The escape buffer is complete now, so views into it are stable.
+        for (const CsvRow::Escaped& field : row.escaped)
+            row.fields[field.field] = std::string_view(row.unescaped).substr(field.offset, field.length);
+        return true;
+    }
+
+    const std::string& error() const { return errorMessage; }
+
+    // Tokenizes a single record, e.g. one log payload.
+    static bool splitLine(std::string_view line, CsvRow& row, char delimiter = ',') {
+        CsvTokenizer tokenizer(line, delimiter);
+        if (!tokenizer.next(row)) {
+            row.fields.clear();
+            return tokenizer.error().empty() && line.empty();
+        }
+        return true;
+    }
+};
+
+// A slice of a CSV file that starts and ends on a record boundary.
+struct CsvChunk {
+    std::string_view text;
+    std::size_t firstLine;
+};
+
+// Cuts `text` into about `pieces` chunks for parallel tokenizing. A cut is
+// only made at a line break outside quotes, so a quoted field spanning
+// lines stays in one chunk. Counting quotes and newlines is a plain scan,
+// far cheaper than tokenizing.
+inline std::vector<CsvChunk> splitCsvChunks(std::string_view text, std::size_t pieces,
+                                            std::size_t minChunkBytes = 1 << 16) {
+    std::vector<CsvChunk> chunks;
+    const std::size_t target = std::max(text.size() / std::max<std::size_t>(pieces, 1), minChunkBytes);
+    std::size_t start = 0, line = 1;
+    while (start < text.size()) {
+        std::size_t end = std::min(start + target, text.size());
+        bool inQuotes = false;
+        std::size_t newlines = 0;
+        for (std::size_t i = start; i < end; ++i) {
+            inQuotes ^= text[i] == '"';
+            newlines += text[i] == '\n';
+        }
+        // Extend to the next line break that is outside quotes.
+        while (end < text.size() && (inQuotes || text[end - 1] != '\n')) {
+            inQuotes ^= text[end] == '"';
+            newlines += text[end] == '\n';
+            ++end;
+        }
+        chunks.push_back({text.substr(start, end - start), line});
+        line += newlines;
+        start = end;
+    }
+    return chunks;
+}
+
+// Appends one field, quoting it only if it contains the delimiter, a quote
+// or a line break, so plain data keeps the old unquoted layout.
+inline void appendCsvField(std::string& out, std::string_view field, char delimiter = ',') {
+    if (field.find_first_of(std::string{delimiter, '"', '\n', '\r'}) == std::string_view::npos) {
+        out.append(field.data(), field.size());
+        return;
+    }
+    out += '"';
+    for (char c : field) {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+inline void writeCsvField(std::ostream& out, std::string_view field, char delimiter = ',') {
+    if (field.find_first_of(std::string{delimiter, '"', '\n', '\r'}) == std::string_view::npos) {
+        out.write(field.data(), static_cast<std::streamsize>(field.size()));
+        return;
+    }
+    std::string quoted;
+    appendCsvField(quoted, field, delimiter);
+    out.write(quoted.data(), static_cast<std::streamsize>(quoted.size()));
+}
+
+#endif
@@ -3,104 +3,305 @@
 #define CUSTOMHASHTABLE_H
 
 #include <vector>
-#include <list>
 #include <utility>
 #include <functional>
 #include <string>
+#include <string_view>
+#include <sstream>
 #include <fstream>
 #include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include "AtomicFile.h"
+#include "CsvTokenizer.h"
+#include "MappedFile.h"
+#include "Metrics.h"
 
+// Open-addressing hash table with Robin Hood probing.
+// All entries live in one contiguous slot array that doubles once the load
+// factor passes 7/8. Removal shifts the following cluster back by one slot,
+// so the table never accumulates tombstones. String-keyed tables can be
+// probed with a std::string_view (or a literal) without building a key.
 template <typename K, typename V>
 class CustomHashTable {
 private:
-    std::vector<std::list<std::pair<K, V>>> table;
+    struct Slot {
+        std::uint32_t dist = 0; // probe distance + 1; 0 marks an empty slot
+        std::size_t hash = 0;
+        K key{};
+        V value{};
+    };
+
+    static constexpr std::size_t MAX_LOAD_NUM = 7;
+    static constexpr std::size_t MAX_LOAD_DEN = 8;
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+    std::vector<Slot> table;
+    std::size_t count;
     const std::string filename;
 
-public:
-    CustomHashTable(size_t size = 100, const std::string& file = "") : table(size), filename(file) {}
+    template <typename Q>
+    static std::size_t hashKey(const Q& key) {
+        std::size_t h;
+        if constexpr (std::is_convertible_v<const Q&, std::string_view>)
+            h = std::hash<std::string_view>{}(std::string_view(key));
+        else
+            h = std::hash<K>{}(key);
+        // Finalizer so that weak std::hash outputs still spread over a
+        // power-of-two mask.
+        std::uint64_t x = static_cast<std::uint64_t>(h);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return static_cast<std::size_t>(x);
+    }
+
+    static std::size_t capacityFor(std::size_t entries) {
+        std::size_t cap = MIN_CAPACITY;
+        while (entries * MAX_LOAD_DEN > cap * MAX_LOAD_NUM)
+            cap <<= 1;
+        return cap;
+    }
 
-    V* find(const K& key) {
-        size_t index = std::hash<K>{}(key) % table.size();
-        for (auto& node : table[index]) {
-            if (node.first == key) {
-                return &node.second;
+    template <typename Q>
+    std::size_t locate(const Q& key) const {
+        if (count == 0)
+            return table.size();
+        const std::size_t h = hashKey(key);
+        const std::size_t mask = table.size() - 1;
+        std::size_t index = h & mask;
+        for (std::uint32_t dist = 1;; ++dist) {
+            const Slot& slot = table[index];
+            if (slot.dist < dist) { // empty, or an entry richer than we would be
+                METRIC_RECORD(HashProbeLength, dist);
+                return table.size();
             }
+            if (slot.hash == h && slot.key == key) {
+                METRIC_RECORD(HashProbeLength, dist);
+                return index;
+            }
+            index = (index + 1) & mask;
         }
-        return nullptr;
     }
 
-    const V* find(const K& key) const { // Const overload for const objects
-        size_t index = std::hash<K>{}(key) % table.size();
-        for (const auto& node : table[index]) {
-            if (node.first == key) {
-                return &node.second;
+    void place(Slot incoming) {
+        const std::size_t mask = table.size() - 1;
+        std::size_t index = incoming.hash & mask;
+        incoming.dist = 1;
+        while (true) {
+            Slot& slot = table[index];
+            if (slot.dist == 0) {
+                slot = std::move(incoming);
+                return;
             }
+            if (slot.dist < incoming.dist)
+                std::swap(slot, incoming);
+            index = (index + 1) & mask;
+            ++incoming.dist;
+        }
+    }
+
+    void rehash(std::size_t newCapacity) {
+        std::vector<Slot> old(newCapacity);
+        old.swap(table);
+        for (auto& slot : old) {
+            if (slot.dist != 0)
+                place(std::move(slot));
+        }
+    }
+
+public:
+    // Iterates the values in slot order. key() gives the matching key.
+    class const_iterator {
+    private:
+        const Slot* current;
+        const Slot* last;
+
+        void skipEmpty() {
+            while (current != last && current->dist == 0)
+                ++current;
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef V value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const V* pointer;
+        typedef const V& reference;
+
+        const_iterator() : current(nullptr), last(nullptr) {}
+        const_iterator(const Slot* first, const Slot* _last) : current(first), last(_last) { skipEmpty(); }
+
+        reference operator*() const { return current->value; }
+        pointer operator->() const { return &current->value; }
+        const K& key() const { return current->key; }
+
+        const_iterator& operator++() {
+            ++current;
+            skipEmpty();
+            return *this;
         }
-        return nullptr;
+
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const const_iterator& other) const { return current == other.current; }
+        bool operator!=(const const_iterator& other) const { return current != other.current; }
+    };
+
+    CustomHashTable(size_t size = 100, const std::string& file = "")
+        : table(capacityFor(size)), count(0), filename(file) {}
+
+    template <typename Q = K>
+    V* find(const Q& key) {
+        std::size_t index = locate(key);
+        return index < table.size() ? &table[index].value : nullptr;
+    }
+
+    template <typename Q = K>
+    const V* find(const Q& key) const { // Const overload for const objects
+        std::size_t index = locate(key);
+        return index < table.size() ? &table[index].value : nullptr;
     }
 
     void insert(const K& key, const V& value) {
-        size_t index = std::hash<K>{}(key) % table.size();
-        for (auto& node : table[index]) {
-            if (node.first == key) {
-                node.second = value;
-                return;
-            }
+        if (V* existing = find(key)) {
+            *existing = value;
+            return;
+        }
+        if ((count + 1) * MAX_LOAD_DEN > table.size() * MAX_LOAD_NUM)
+            rehash(table.size() * 2);
+        Slot slot;
+        slot.hash = hashKey(key);
+        slot.key = key;
+        slot.value = value;
+        place(std::move(slot));
+        ++count;
+    }
+
+    template <typename Q = K>
+    bool remove(const Q& key) {
+        std::size_t index = locate(key);
+        if (index >= table.size())
+            return false;
+        const std::size_t mask = table.size() - 1;
+        std::size_t next = (index + 1) & mask;
+        while (table[next].dist > 1) {
+            table[index] = std::move(table[next]);
+            --table[index].dist;
+            index = next;
+            next = (next + 1) & mask;
+        }
+        table[index] = Slot{};
+        --count;
+        return true;
+    }
+
+    void reserve(std::size_t entries) {
+        std::size_t cap = capacityFor(entries);
+        if (cap > table.size())
+            rehash(cap);
+    }
+
+    void clear() {
+        table.assign(MIN_CAPACITY, Slot());
+        count = 0;
+    }
+
+    const_iterator begin() const { return const_iterator(table.data(), table.data() + table.size()); }
+    const_iterator end() const {
+        return const_iterator(table.data() + table.size(), table.data() + table.size());
+    }
+
+    // visit(const K&, const V&) for every entry, without copying.
+    template <typename Visit>
+    void forEach(const Visit& visit) const {
+        for (const auto& slot : table) {
+            if (slot.dist != 0)
+                visit(slot.key, slot.value);
         }
-        table[index].emplace_back(key, value);
     }
 
-    bool remove(const K& key) {
-        size_t index = std::hash<K>{}(key) % table.size();
-        auto it = std::find_if(table[index].begin(), table[index].end(),
-                              [&](const std::pair<K, V>& p) { return p.first == key; });
-        if (it != table[index].end()) {
-            table[index].erase(it);
-            return true;
+    // Visits up to `limit` entries starting at slot `resumeToken` (0 = from
+    // the start) and returns the token for the next page, or 0 when done.
+    // Tokens are slot positions: a rehash or removal between pages may
+    // repeat or skip entries.
+    template <typename Visit>
+    std::size_t forEachPage(std::size_t resumeToken, std::size_t limit, const Visit& visit) const {
+        std::size_t index = resumeToken;
+        for (std::size_t visited = 0; index < table.size() && visited < limit; ++index) {
+            if (table[index].dist != 0) {
+                visit(table[index].key, table[index].value);
+                ++visited;
+            }
         }
-        return false;
+        while (index < table.size() && table[index].dist == 0)
+            ++index;
+        return index < table.size() ? index : 0;
     }
 
     std::vector<V> getAll() const {
         std::vector<V> result;
-        for (const auto& bucket : table) {
-            for (const auto& node : bucket) {
-                result.push_back(node.second);
-            }
+        result.reserve(count);
+        for (const auto& slot : table) {
+            if (slot.dist != 0)
+                result.push_back(slot.value);
         }
         return result;
     }
 
-    bool isEmpty() const { return table.empty(); }
+    std::size_t size() const { return count; }
 
-    void save(const std::string& filename) const {
-        std::ofstream ofs(filename);
-        if (ofs.is_open()) {
-            for (const auto& bucket : table) {
-                for (const auto& node : bucket) {
-                    ofs << node.first << "," << node.second << "\n";
-                }
-            }
-            ofs.close();
-        } else {
+    bool isEmpty() const { return count == 0; }
+
+    // One "key,value" line per entry; string keys and values are quoted
+    // when they hold a comma. The file is replaced atomically.
+    bool save(const std::string& filename) const {
+        bool ok = writeFileAtomically(filename, [&](std::ostream& ofs) {
+            forEach([&](const K& key, const V& value) {
+                if constexpr (std::is_same_v<K, std::string>)
+                    writeCsvField(ofs, key);
+                else
+                    ofs << key;
+                ofs << ",";
+                if constexpr (std::is_same_v<V, std::string>)
+                    writeCsvField(ofs, value);
+                else
+                    ofs << value;
+                ofs << "\n";
+            });
+        });
+        if (!ok)
             std::cerr << "Error saving to " << filename << std::endl;
-        }
+        return ok;
     }
 
     void load(const std::string& filename) {
-        std::ifstream ifs(filename);
-        if (ifs.is_open()) {
-            std::string line;
-            while (std::getline(ifs, line)) {
-                std::stringstream ss(line);
-                K key;
-                V value;
-                std::getline(ss, key, ',');
-                std::getline(ss, value);
-                insert(key, value);
-            }
-            ifs.close();
+        MappedFile file;
+        if (!file.open(filename))
+            return;
+        CsvTokenizer tokenizer(std::string_view(file.data(), file.size()));
+        CsvRow row;
+        while (tokenizer.next(row)) {
+            K key;
+            V value{};
+            if constexpr (std::is_same_v<K, std::string>)
+                key = row.str(0);
+            else if (!row.number(0, key))
+                continue;
+            if constexpr (std::is_same_v<V, std::string>)
+                value = row.size() > 1 ? row.str(1) : std::string();
+            else if (!row.number(1, value))
+                continue;
+            insert(key, value);
         }
+        if (!tokenizer.error().empty())
+            std::cerr << "Error reading " << filename << ", " << tokenizer.error() << std::endl;
     }
 };
 
@@ -0,0 +1,256 @@
+// CustomerIndex.h
+#ifndef CUSTOMERINDEX_H
+#define CUSTOMERINDEX_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "CustomHashTable.h"
+
+// Secondary indexes over customers, keyed back to customer ids:
+//  - a unique hash index on the normalized (trimmed, lowercased) email;
+//  - the normalized names in sorted order, for prefix search;
+//  - a trigram index over the normalized names for substring search. Each
+//    trigram maps to a posting list of customer slots kept in slot order,
+//    so a query walks the shortest list of its trigrams, skips ahead in the
+//    others, and checks each survivor's name before reporting it.
+// Searches take a result limit and stop as soon as it is reached.
+class CustomerIndex {
+private:
+    struct Slot {
+        std::string id;
+        std::string name;  // normalized
+        std::string email; // normalized; empty = not indexed
+        bool live = false;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> freeSlots;
+    CustomHashTable<std::string, std::uint32_t> byId;
+    CustomHashTable<std::string, std::uint32_t> byEmail;
+    std::set<std::pair<std::string, std::uint32_t>> byName;
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> byTrigram;
+
+    static std::uint32_t trigramAt(std::string_view text, std::size_t i) {
+        return static_cast<std::uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+               static_cast<std::uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+               static_cast<unsigned char>(text[i + 2]);
+    }
+
+    // Distinct trigrams of `text`, sorted.
+    static std::vector<std::uint32_t> trigramsOf(std::string_view text) {
+        std::vector<std::uint32_t> result;
+        for (std::size_t i = 0; i + 3 <= text.size(); ++i)
+            result.push_back(trigramAt(text, i));
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    void linkName(std::uint32_t slot) {
+        byName.emplace(slots[slot].name, slot);
+        for (std::uint32_t trigram : trigramsOf(slots[slot].name)) {
+            std::vector<std::uint32_t>& postings = byTrigram[trigram];
+            // Slots mostly grow, so this is usually an append.
+            postings.insert(std::lower_bound(postings.begin(), postings.end(), slot), slot);
+        }
+    }
+
+    void unlinkName(std::uint32_t slot) {
+        byName.erase({slots[slot].name, slot});
+        for (std::uint32_t trigram : trigramsOf(slots[slot].name)) {
+            auto it = byTrigram.find(trigram);
+            if (it == byTrigram.end())
+                continue;
+            std::vector<std::uint32_t>& postings = it->second;
+            auto at = std::lower_bound(postings.begin(), postings.end(), slot);
+            if (at != postings.end() && *at == slot)
+                postings.erase(at);
+            if (postings.empty())
+                byTrigram.erase(it);
+        }
+    }
+
+public:
+    // Lowercase with surrounding whitespace removed.
+    static std::string normalizeEmail(std::string_view email) {
+        std::size_t first = 0, last = email.size();
+        while (first < last && std::isspace(static_cast<unsigned char>(email[first])))
+            ++first;
+        while (last > first && std::isspace(static_cast<unsigned char>(email[last - 1])))
+            --last;
+        std::string result(email.substr(first, last - first));
+        for (char& c : result)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return result;
+    }
+
+    // Lowercase with runs of whitespace collapsed to one space and trimmed.
+    static std::string normalizeName(std::string_view name) {
+        std::string result;
+        result.reserve(name.size());
+        for (char c : name) {
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                if (!result.empty() && result.back() != ' ')
+                    result += ' ';
+            } else {
+                result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            }
+        }
+        if (!result.empty() && result.back() == ' ')
+            result.pop_back();
+        return result;
+    }
+
+    // False if another customer already has this email.
+    bool canUse(std::string_view id, std::string_view email) const {
+        std::string key = normalizeEmail(email);
+        if (key.empty())
+            return true;
+        const std::uint32_t* owner = byEmail.find(key);
+        return !owner || slots[*owner].id == id;
+    }
+
+    // Adds or replaces the customer `id`. Returns false, changing nothing,
+    // if the email belongs to another customer.
+    bool put(const std::string& id, std::string_view name, std::string_view email) {
+        if (!canUse(id, email))
+            return false;
+        std::string normalizedName = normalizeName(name), normalizedEmail = normalizeEmail(email);
+        std::uint32_t slot;
+        if (const std::uint32_t* existing = byId.find(id)) {
+            slot = *existing;
+            if (slots[slot].email != normalizedEmail) {
+                if (!slots[slot].email.empty())
+                    byEmail.remove(slots[slot].email);
+                if (!normalizedEmail.empty())
+                    byEmail.insert(normalizedEmail, slot);
+                slots[slot].email = std::move(normalizedEmail);
+            }
+            if (slots[slot].name != normalizedName) {
+                unlinkName(slot);
+                slots[slot].name = std::move(normalizedName);
+                linkName(slot);
+            }
+            return true;
+        }
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = static_cast<std::uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+        slots[slot] = Slot{id, std::move(normalizedName), std::move(normalizedEmail), true};
+        byId.insert(id, slot);
+        if (!slots[slot].email.empty())
+            byEmail.insert(slots[slot].email, slot);
+        linkName(slot);
+        return true;
+    }
+
+    bool erase(std::string_view id) {
+        const std::uint32_t* found = byId.find(id);
+        if (!found)
+            return false;
+        const std::uint32_t slot = *found;
+        unlinkName(slot);
+        if (!slots[slot].email.empty())
+            byEmail.remove(slots[slot].email);
+        byId.remove(id);
+        slots[slot] = Slot();
+        freeSlots.push_back(slot);
+        return true;
+    }
+
+    void clear() {
+        slots.clear();
+        freeSlots.clear();
+        byId.clear();
+        byEmail.clear();
+        byName.clear();
+        byTrigram.clear();
+    }
+
+    void reserve(std::size_t customers) {
+        slots.reserve(customers);
+        byId.reserve(customers);
+        byEmail.reserve(customers);
+    }
+
+    std::size_t size() const { return byId.size(); }
+
+    // Id of the customer with this email (any case), or nullptr.
+    const std::string* findByEmail(std::string_view email) const {
+        const std::uint32_t* slot = byEmail.find(normalizeEmail(email));
+        return slot ? &slots[*slot].id : nullptr;
+    }
+
+    // visit(const std::string& id) for up to `limit` customers whose name
+    // starts with `prefix`, in name order. Returns how many were visited.
+    template <typename Visit>
+    std::size_t forEachNamePrefix(std::string_view prefix, std::size_t limit, const Visit& visit) const {
+        const std::string key = normalizeName(prefix);
+        std::size_t visited = 0;
+        for (auto it = byName.lower_bound({key, 0}); it != byName.end() && visited < limit; ++it) {
+            if (it->first.compare(0, key.size(), key) != 0)
+                break;
+            visit(slots[it->second].id);
+            ++visited;
+        }
+        return visited;
+    }
+
+    // visit(const std::string& id) for up to `limit` customers whose name
+    // contains `text`, in slot order. Needs three characters to use the
+    // trigram index; shorter text is checked against every name until
+    // `limit` matches are found.
+    template <typename Visit>
+    std::size_t forEachNameContaining(std::string_view text, std::size_t limit, const Visit& visit) const {
+        const std::string key = normalizeName(text);
+        if (key.size() < 3) {
+            std::size_t visited = 0;
+            for (std::size_t slot = 0; slot < slots.size() && visited < limit; ++slot) {
+                if (!slots[slot].live || slots[slot].name.find(key) == std::string::npos)
+                    continue;
+                visit(slots[slot].id);
+                ++visited;
+            }
+            return visited;
+        }
+        std::vector<const std::vector<std::uint32_t>*> lists;
+        for (std::uint32_t trigram : trigramsOf(key)) {
+            auto it = byTrigram.find(trigram);
+            if (it == byTrigram.end())
+                return 0;
+            lists.push_back(&it->second);
+        }
+        std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+        std::vector<std::vector<std::uint32_t>::const_iterator> cursors;
+        for (const auto* list : lists)
+            cursors.push_back(list->begin());
+        std::size_t visited = 0;
+        for (std::uint32_t slot : *lists[0]) {
+            bool inAll = true;
+            for (std::size_t k = 1; k < lists.size() && inAll; ++k) {
+                cursors[k] = std::lower_bound(cursors[k], lists[k]->end(), slot);
+                inAll = cursors[k] != lists[k]->end() && *cursors[k] == slot;
+            }
+            if (!inAll || slots[slot].name.find(key) == std::string::npos)
+                continue;
+            visit(slots[slot].id);
+            if (++visited >= limit)
+                break;
+        }
+        return visited;
+    }
+};
+
+#endif
@@ -0,0 +1,259 @@
+// DataGenerator.h
+#ifndef DATAGENERATOR_H
+#define DATAGENERATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "CsvTokenizer.h"
+#include "Money.h"
+#include "Order.h"
+#include "Product.h"
+#include "ShipmentStore.h"
+
+// Size and shape of a synthetic dataset.
+struct DatasetSpec {
+    std::size_t products = 10000;
+    std::size_t customers = 5000;
+    std::size_t orders = 50000;
+    double zipfExponent = 1.1; // product popularity skew; 0 is uniform
+    std::uint32_t seed = 42;
+    int days = 365;            // orders are spread over this many days...
+    std::int64_t endTime = 1735689600; // ...ending here (2025-01-01 00:00 UTC), for repeatable files
+};
+
+// Draws ranks 0..n-1 with P(rank k) proportional to 1/(k+1)^s, by binary
+// search over the precomputed cumulative distribution.
+class ZipfSampler {
+private:
+    std::vector<double> cdf;
+
+public:
+    ZipfSampler(std::size_t n, double exponent) : cdf(std::max<std::size_t>(n, 1)) {
+        double sum = 0;
+        for (std::size_t k = 0; k < cdf.size(); ++k) {
+            sum += 1.0 / std::pow(static_cast<double>(k + 1), exponent);
+            cdf[k] = sum;
+        }
+        for (double& c : cdf)
+            c /= sum;
+    }
+
+    template <typename Rng>
+    std::size_t operator()(Rng& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return std::min<std::size_t>(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin(), cdf.size() - 1);
+    }
+};
+
+// Deterministic synthetic warehouse data: the same spec and seed always
+// give the same files. Products are skewed towards a few categories,
+// order lines pick products by Zipfian popularity (the popular ones are
+// scattered over the id range, not the lowest ids), and every order has a
+// shipment whose status depends on the order's age.
+class DataGenerator {
+public:
+    struct Customer {
+        std::string id, name, email, address, phone;
+    };
+
+private:
+    struct Category {
+        const char* name;
+        double weight;
+        std::vector<const char*> subcategories;
+        double basePrice;
+    };
+
+    DatasetSpec spec;
+    std::vector<Category> categories;
+
+    static std::string numbered(const char* prefix, std::size_t number, int width) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%s%0*zu", prefix, width, number);
+        return text;
+    }
+
+public:
+    explicit DataGenerator(const DatasetSpec& _spec) : spec(_spec) {
+        categories = {
+            {"Women", 0.42, {"Eid Edition", "Lawn", "Formal", "Casual", "Bridal"}, 6000},
+            {"Men", 0.28, {"Casual", "Formal", "Kurta", "Denim"}, 4000},
+            {"Kids", 0.15, {"Boys", "Girls", "Infants"}, 2000},
+            {"Home", 0.10, {"Bedding", "Curtains", "Towels"}, 3500},
+            {"Accessories", 0.05, {"Bags", "Shoes", "Jewellery, Fashion"}, 1500},
+        };
+    }
+
+    const DatasetSpec& getSpec() const { return spec; }
+
+    std::vector<Product> products() const {
+        static const char* adjectives[] = {"Classic", "Printed", "Embroidered", "Slim", "Classic Fit", "Luxury"};
+        static const char* nouns[] = {"Shirt", "Kurta", "Dupatta", "Trouser", "Shawl", "Set, 2 Piece"};
+        std::mt19937 rng(spec.seed);
+        std::discrete_distribution<std::size_t> pickCategory(
+            {categories[0].weight, categories[1].weight, categories[2].weight, categories[3].weight,
+             categories[4].weight});
+        std::lognormal_distribution<double> priceFactor(0.0, 0.5);
+        std::vector<Product> result;
+        result.reserve(spec.products);
+        for (std::size_t i = 0; i < spec.products; ++i) {
+            const Category& category = categories[pickCategory(rng)];
+            std::string name = std::string(adjectives[rng() % 6]) + " " + nouns[rng() % 6] + " " + std::to_string(i);
+            double price = std::round(category.basePrice * priceFactor(rng));
+            result.emplace_back(numbered("P", i + 1, 7), name, category.name,
+                                category.subcategories[rng() % category.subcategories.size()],
+                                Money::fromDouble(std::max(100.0, price)), static_cast<int>(rng() % 500));
+        }
+        return result;
+    }
+
+    std::vector<Customer> customers() const {
+        static const char* first[] = {"Amina", "Bilal", "Sara", "Usman", "Hina", "Ali", "Zara", "Omar"};
+        static const char* last[] = {"Khan", "Ahmed", "Malik", "Raza", "Qureshi", "Shah"};
+        static const char* cities[] = {"Lahore", "Karachi", "Islamabad", "Multan", "Faisalabad"};
+        std::mt19937 rng(spec.seed + 1);
+        std::vector<Customer> result;
+        result.reserve(spec.customers);
+        for (std::size_t i = 0; i < spec.customers; ++i) {
+            Customer c;
+            c.id = std::to_string(i + 1);
+            c.name = std::string(first[rng() % 8]) + " " + last[rng() % 6];
+            c.email = "customer" + std::to_string(i + 1) + "@example.com";
+            c.address = "House " + std::to_string(1 + rng() % 900) + ", Street " + std::to_string(1 + rng() % 60) +
+                        ", " + cities[rng() % 5];
+            c.phone = "0300-" + std::to_string(1000000 + rng() % 9000000);
+            result.push_back(std::move(c));
+        }
+        return result;
+    }
+
+    // Orders in placement order, numbered like the application's own
+    // ORD000001/TRK000001. `catalog` and `buyers` come from products() and
+    // customers().
+    std::vector<Order> orders(const std::vector<Product>& catalog, const std::vector<Customer>& buyers) const {
+        std::mt19937 rng(spec.seed + 2);
+        std::vector<Order> result;
+        if (catalog.empty() || buyers.empty())
+            return result;
+        // Popularity rank -> product, so popular products are spread out.
+        std::vector<std::size_t> byRank(catalog.size());
+        for (std::size_t i = 0; i < byRank.size(); ++i)
+            byRank[i] = i;
+        std::shuffle(byRank.begin(), byRank.end(), rng);
+        ZipfSampler popularity(catalog.size(), spec.zipfExponent);
+        std::discrete_distribution<int> lineCount({0, 45, 25, 15, 10, 5});
+        const std::time_t now = static_cast<std::time_t>(spec.endTime);
+        const std::time_t first = now - static_cast<std::time_t>(spec.days) * 86400;
+        result.reserve(spec.orders);
+        for (std::size_t i = 0; i < spec.orders; ++i) {
+            const Customer& buyer = buyers[rng() % buyers.size()];
+            std::time_t placed = first + static_cast<std::time_t>((now - first) * (i + 0.5) / spec.orders);
+            char timestamp[32];
+            std::tm utc{};
+#ifdef _WIN32
+            gmtime_s(&utc, &placed);
+#else
+            gmtime_r(&placed, &utc);
+#endif
+            std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &utc);
+            Order order(numbered("ORD", i + 1, 6), numbered("TRK", i + 1, 6), timestamp, buyer.name, buyer.address,
+                        buyer.phone, rng() % 10 < 7 ? "Cash" : "Online Payment");
+            int lines = lineCount(rng);
+            for (int k = 0; k < lines; ++k) {
+                const Product& product = catalog[byRank[popularity(rng)]];
+                auto existing = std::find_if(order.items.begin(), order.items.end(),
+                                             [&](const OrderItem& item) { return item.productId == product.id; });
+                int quantity = 1 + static_cast<int>(rng() % 3);
+                if (existing != order.items.end())
+                    existing->quantity += quantity;
+                else
+                    order.items.push_back({product.id, quantity, product.price});
+            }
+            for (const OrderItem& item : order.items)
+                order.totalPrice += item.unitPrice * item.quantity;
+            result.push_back(std::move(order));
+        }
+        return result;
+    }
+
+    // One shipment per order: delivered after a week, shipped after three
+    // days, packed after one, otherwise in progress.
+    std::vector<Shipment> shipments(const std::vector<Order>& placed) const {
+        std::vector<Shipment> result;
+        result.reserve(placed.size());
+        const std::size_t total = placed.size();
+        for (std::size_t i = 0; i < total; ++i) {
+            const Order& order = placed[i];
+            double ageDays = spec.days * (total - i - 0.5) / std::max<std::size_t>(total, 1);
+            ShipmentStatus status = ageDays > 7   ? ShipmentStatus::Delivered
+                                    : ageDays > 3 ? ShipmentStatus::Shipped
+                                    : ageDays > 1 ? ShipmentStatus::Packed
+                                                  : ShipmentStatus::InProgress;
+            result.push_back({order.orderId, order.trackingId, order.customerName, order.customerAddress, status});
+        }
+        return result;
+    }
+
+    // Writes a complete wearhouse/ tree under `root`: products.txt,
+    // customers.txt, orders.txt (imported into the order history on first
+    // start), id_counters.txt and database/shipments.txt.
+    bool write(const std::string& root) const {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        fs::create_directories(fs::path(root) / "wearhouse" / "database", ec);
+        if (ec) {
+            std::cerr << "Error creating " << root << ": " << ec.message() << std::endl;
+            return false;
+        }
+        const fs::path base = fs::path(root) / "wearhouse";
+        std::vector<Product> catalog = products();
+        std::vector<Customer> buyers = customers();
+        std::vector<Order> placed = orders(catalog, buyers);
+
+        std::ofstream productsFile(base / "products.txt");
+        for (const Product& p : catalog) {
+            p.writeCsv(productsFile);
+            productsFile << "\n";
+        }
+        std::ofstream customersFile(base / "customers.txt");
+        std::string line;
+        for (const Customer& c : buyers) {
+            line.clear();
+            appendCsvField(line, c.id);
+            line += ',';
+            appendCsvField(line, c.name);
+            line += ',';
+            appendCsvField(line, c.email);
+            customersFile << line << "\n";
+        }
+        std::ofstream ordersFile(base / "orders.txt");
+        for (const Order& o : placed)
+            ordersFile << o.toCsv() << "\n";
+        std::ofstream counters(base / "id_counters.txt");
+        counters << placed.size() + 1 << " " << placed.size() + 1 << "\n";
+        ShipmentStore store;
+        for (const Shipment& s : shipments(placed))
+            store.add(s);
+        productsFile.close();
+        customersFile.close();
+        ordersFile.close();
+        counters.close();
+        if (!productsFile || !customersFile || !ordersFile || !counters ||
+            !store.save((base / "database" / "shipments.txt").string())) {
+            std::cerr << "Error writing dataset under " << base.string() << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
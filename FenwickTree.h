@@ -0,0 +1,56 @@
+// FenwickTree.h
+#ifndef FENWICKTREE_H
+#define FENWICKTREE_H
+
+#include <cstddef>
+#include <vector>
+
+// Binary indexed tree over a dense array of T, for O(log n) point updates
+// and prefix / range sums. T needs a value-initialized zero, += and -=.
+template <typename T>
+class FenwickTree {
+private:
+    std::vector<T> tree; // 1-based
+
+public:
+    explicit FenwickTree(std::size_t size = 0) : tree(size + 1) {}
+
+    // O(n) construction from plain values.
+    void build(const std::vector<T>& values) {
+        tree.assign(values.size() + 1, T());
+        for (std::size_t i = 1; i <= values.size(); ++i) {
+            tree[i] += values[i - 1];
+            std::size_t parent = i + (i & (0 - i));
+            if (parent <= values.size())
+                tree[parent] += tree[i];
+        }
+    }
+
+    std::size_t size() const { return tree.size() - 1; }
+
+    void add(std::size_t index, const T& delta) {
+        for (std::size_t i = index + 1; i < tree.size(); i += i & (0 - i))
+            tree[i] += delta;
+    }
+
+    // Sum of [0, end).
+    T prefix(std::size_t end) const {
+        T sum = T();
+        if (end > size())
+            end = size();
+        for (std::size_t i = end; i > 0; i -= i & (0 - i))
+            sum += tree[i];
+        return sum;
+    }
+
+    // Sum of [first, last).
+    T range(std::size_t first, std::size_t last) const {
+        if (last <= first)
+            return T();
+        T sum = prefix(last);
+        sum -= prefix(first);
+        return sum;
+    }
+};
+
+#endif
@@ -0,0 +1,159 @@
+// IdAllocator.h
+#ifndef IDALLOCATOR_H
+#define IDALLOCATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include "AtomicFile.h"
+#include "CsvTokenizer.h"
+#include "MappedFile.h"
+#include "Metrics.h"
+
+// Increasing ids for a fixed number of sequences (order ids, tracking ids)
+// sharing one counters file of space-separated high-water marks.
+// Ids are leased in blocks: the file records the end of each sequence's
+// lease, written durably before any id in the block is handed out, so one
+// file write covers a whole block. After a crash every sequence restarts
+// at its recorded high-water mark, skipping whatever was left of the
+// lease rather than handing out an id twice. allocate() is lock-free until
+// a lease runs out; the caller that finds it exhausted extends it while
+// the others wait.
+class IdAllocator {
+private:
+    struct Sequence {
+        std::atomic<std::uint64_t> next{1};
+        std::atomic<std::uint64_t> leaseEnd{1}; // first id not covered by the file
+    };
+
+    std::string filename;
+    std::size_t count;
+    std::unique_ptr<Sequence[]> sequences;
+    std::uint64_t blockSize;
+    std::mutex leaseMutex; // serializes lease extensions and file writes
+
+    // Writes every sequence's lease end, with `sequence` moved to `end`.
+    // Called with leaseMutex held.
+    bool extendLease(std::size_t sequence, std::uint64_t end) {
+        bool ok = writeFileAtomically(filename, [&](std::ostream& out) {
+            for (std::size_t i = 0; i < count; ++i) {
+                out << (i ? " " : "")
+                    << (i == sequence ? end : sequences[i].leaseEnd.load(std::memory_order_relaxed));
+            }
+            out << "\n";
+        });
+        if (!ok) {
+            std::cerr << "Error saving ID counters to " << filename << std::endl;
+            return false;
+        }
+        METRIC_ADD(IdLeases, 1);
+        sequences[sequence].leaseEnd.store(end, std::memory_order_release);
+        return true;
+    }
+
+public:
+    IdAllocator(const std::string& file, std::size_t sequenceCount, std::uint64_t leaseBlock = 10000)
+        : filename(file), count(sequenceCount), sequences(new Sequence[sequenceCount]),
+          blockSize(leaseBlock ? leaseBlock : 1) {}
+
+    IdAllocator(const IdAllocator&) = delete;
+    IdAllocator& operator=(const IdAllocator&) = delete;
+
+    // Restarts each sequence at its high-water mark. A missing file starts
+    // every sequence at 1. Counters files from older versions hold the next
+    // id of each sequence, which reads the same way.
+    bool load() {
+        MappedFile file;
+        if (!file.open(filename))
+            return false;
+        CsvRow row;
+        CsvTokenizer tokenizer(std::string_view(file.data(), file.size()), ' ');
+        if (!tokenizer.next(row)) {
+            std::cerr << "Warning: Could not read " << filename << std::endl;
+            return false;
+        }
+        bool ok = true;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::uint64_t mark = 0;
+            if (!row.number(i, mark) || mark == 0) {
+                ok = false;
+                continue;
+            }
+            sequences[i].next.store(mark, std::memory_order_relaxed);
+            sequences[i].leaseEnd.store(mark, std::memory_order_relaxed);
+        }
+        if (!ok)
+            std::cerr << "Warning: Could not read " << filename << std::endl;
+        return ok;
+    }
+
+    // Hands out the next id of `sequence`. False only if the lease could not
+    // be extended on disk; that id is then not used.
+    bool allocate(std::size_t sequence, std::uint64_t& id) {
+        Sequence& s = sequences[sequence];
+        id = s.next.fetch_add(1, std::memory_order_relaxed);
+        if (id < s.leaseEnd.load(std::memory_order_acquire))
+            return true;
+        std::lock_guard<std::mutex> lock(leaseMutex);
+        while (id >= s.leaseEnd.load(std::memory_order_relaxed)) {
+            if (!extendLease(sequence, std::max(id + 1, s.leaseEnd.load(std::memory_order_relaxed) + blockSize)))
+                return false;
+        }
+        return true;
+    }
+
+    // Makes sure `sequence` never hands out `used` or anything below it, for
+    // ids that arrived from elsewhere (imports, replayed log records).
+    bool advancePast(std::size_t sequence, std::uint64_t used) {
+        Sequence& s = sequences[sequence];
+        std::uint64_t next = s.next.load(std::memory_order_relaxed);
+        while (next <= used && !s.next.compare_exchange_weak(next, used + 1, std::memory_order_relaxed)) {
+        }
+        if (used < s.leaseEnd.load(std::memory_order_acquire))
+            return true;
+        std::lock_guard<std::mutex> lock(leaseMutex);
+        if (used < s.leaseEnd.load(std::memory_order_relaxed))
+            return true;
+        return extendLease(sequence, used + 1);
+    }
+
+    // The id allocate() would hand out next, if nothing else gets there first.
+    std::uint64_t peek(std::size_t sequence) const {
+        return sequences[sequence].next.load(std::memory_order_relaxed);
+    }
+
+    // "ORD000042": the prefix and at least `minDigits` digits, growing past
+    // them (ORD1000000) instead of overflowing.
+    static std::string format(std::string_view prefix, std::uint64_t id, std::size_t minDigits = 6) {
+        char digits[20];
+        std::to_chars_result end = std::to_chars(digits, digits + sizeof(digits), id);
+        const std::size_t length = static_cast<std::size_t>(end.ptr - digits);
+        std::string result;
+        result.reserve(prefix.size() + std::max(length, minDigits));
+        result += prefix;
+        if (length < minDigits)
+            result.append(minDigits - length, '0');
+        result.append(digits, length);
+        return result;
+    }
+
+    // The number in an id made by format(), or 0 if `id` is not one.
+    static std::uint64_t parse(std::string_view prefix, std::string_view id) {
+        if (id.size() <= prefix.size() || id.substr(0, prefix.size()) != prefix)
+            return 0;
+        std::string_view digits = id.substr(prefix.size());
+        std::uint64_t number = 0;
+        std::from_chars_result result = std::from_chars(digits.data(), digits.data() + digits.size(), number);
+        return result.ec == std::errc() && result.ptr == digits.data() + digits.size() ? number : 0;
+    }
+};
+
+#endif
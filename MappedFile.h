@@ -0,0 +1,89 @@
+// MappedFile.h
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Metrics.h"
+
+// Read-only view of a whole file. Uses mmap on POSIX systems and falls back
+// to reading the file into memory elsewhere.
+class MappedFile {
+private:
+    const char* bytes;
+    std::size_t length;
+    bool mapped;
+    std::vector<char> buffer;
+
+public:
+    MappedFile() : bytes(nullptr), length(0), mapped(false) {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<std::size_t>(st.st_size);
+        if (length == 0) {
+            ::close(fd);
+            bytes = "";
+            return true;
+        }
+        void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr != MAP_FAILED) {
+            bytes = static_cast<const char*>(addr);
+            mapped = true;
+            METRIC_ADD(BytesRead, length);
+            return true;
+        }
+        length = 0;
+#endif
+        std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+        if (!ifs.is_open())
+            return false;
+        buffer.resize(static_cast<std::size_t>(ifs.tellg()));
+        ifs.seekg(0);
+        ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        bytes = buffer.data();
+        length = buffer.size();
+        METRIC_ADD(BytesRead, length);
+        return static_cast<bool>(ifs);
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (mapped)
+            munmap(const_cast<char*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+        mapped = false;
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+
+    const char* data() const { return bytes; }
+    std::size_t size() const { return length; }
+    bool isOpen() const { return bytes != nullptr; }
+};
+
+#endif
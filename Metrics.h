@@ -0,0 +1,326 @@
+// Metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+// Build with -DWEARHOUSE_METRICS=0 to compile every METRIC_* site out.
+#ifndef WEARHOUSE_METRICS
+#define WEARHOUSE_METRICS 1
+#endif
+
+#if WEARHOUSE_METRICS
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Monotonic totals.
+enum class Counter : std::uint8_t {
+    BytesRead,    // files mapped or read whole for loading
+    BytesWritten, // operation log, order segments and snapshots
+    Fsyncs,
+    OrdersPlaced,
+    Checkpoints,
+    CheckpointBytes,      // snapshot files written by checkpoints
+    CheckpointsCoalesced, // requests folded into an already pending checkpoint
+    IdLeases,             // id blocks leased, one counters file write each
+    COUNT
+};
+
+// Distributions. Latencies are recorded in nanoseconds.
+enum class Histogram : std::uint8_t {
+    PlaceOrder,
+    CommitLog,
+    Checkpoint,        // whole checkpoint, capture and file writes
+    CheckpointCapture, // copying state under the locks; the time writers wait
+    SaveProducts,
+    SaveOrders, // order history sync at a checkpoint
+    LoadProducts,
+    LoadOrders,
+    Fsync,
+    HashProbeLength, // CustomHashTable slots inspected per lookup
+    AvlDepth,        // product index levels walked per lookup
+    COUNT
+};
+
+// Log-linear buckets in the style of an HDR histogram: values below 16 get
+// a bucket each, above that every power of two is split into 16 buckets,
+// so any value is within 1/16 (about 6%) of its bucket's bound. 45 groups
+// cover values up to 2^48 (over three days in nanoseconds).
+struct HistogramBuckets {
+    static constexpr int SUB_BITS = 4;
+    static constexpr std::size_t SUB_COUNT = std::size_t(1) << SUB_BITS;
+    static constexpr std::size_t COUNT = SUB_COUNT * 45;
+
+    static std::size_t indexOf(std::uint64_t value) {
+        if (value < SUB_COUNT)
+            return static_cast<std::size_t>(value);
+        int msb = 63;
+        while (!(value >> msb))
+            --msb;
+        std::size_t index = static_cast<std::size_t>(msb - SUB_BITS + 1) * SUB_COUNT +
+                            static_cast<std::size_t>((value >> (msb - SUB_BITS)) - SUB_COUNT);
+        return std::min(index, COUNT - 1);
+    }
+
+    // Largest value that lands in bucket `index`.
+    static std::uint64_t upperBound(std::size_t index) {
+        if (index < SUB_COUNT)
+            return index;
+        const std::size_t group = index / SUB_COUNT, sub = index % SUB_COUNT;
+        return ((static_cast<std::uint64_t>(SUB_COUNT + sub + 1)) << (group - 1)) - 1;
+    }
+};
+
+// Process-wide metrics. Each thread writes only to its own block, with
+// relaxed loads and stores rather than atomic read-modify-writes, so a
+// recording costs a thread-local lookup and a couple of adds. Reading sums
+// every live block plus the totals of threads that have exited.
+class Metrics {
+public:
+    struct HistogramSnapshot {
+        std::vector<std::uint64_t> buckets;
+        std::uint64_t count = 0, sum = 0, max = 0;
+
+        // Upper bound of the bucket holding the q-th quantile (0..1).
+        std::uint64_t quantile(double q) const {
+            if (count == 0)
+                return 0;
+            const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(q * count + 0.5));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < buckets.size(); ++i) {
+                seen += buckets[i];
+                if (seen >= rank)
+                    return std::min(HistogramBuckets::upperBound(i), max);
+            }
+            return max;
+        }
+    };
+
+private:
+    static constexpr std::size_t COUNTERS = static_cast<std::size_t>(Counter::COUNT);
+    static constexpr std::size_t HISTOGRAMS = static_cast<std::size_t>(Histogram::COUNT);
+
+    struct HistogramCells {
+        std::array<std::atomic<std::uint64_t>, HistogramBuckets::COUNT> buckets{};
+        std::atomic<std::uint64_t> sum{0}, max{0};
+    };
+
+    struct Block {
+        std::array<std::atomic<std::uint64_t>, COUNTERS> counters{};
+        std::array<HistogramCells, HISTOGRAMS> histograms{};
+    };
+
+    static void bump(std::atomic<std::uint64_t>& cell, std::uint64_t amount) {
+        cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<Block*> live;
+        Block retired; // folded in from exited threads, under the mutex
+    };
+
+    // Never destroyed, so threads exiting during shutdown can still retire.
+    static Registry& registry() {
+        static Registry* instance = new Registry();
+        return *instance;
+    }
+
+    // Owns the calling thread's block (on the heap, as it is tens of KB)
+    // and folds it into the retired totals when the thread exits.
+    struct ThreadBlock {
+        Block* block;
+        ThreadBlock() : block(new Block()) {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            registry().live.push_back(block);
+        }
+        ~ThreadBlock() {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.live.erase(std::find(r.live.begin(), r.live.end(), block));
+            for (std::size_t i = 0; i < COUNTERS; ++i)
+                bump(r.retired.counters[i], block->counters[i].load(std::memory_order_relaxed));
+            for (std::size_t h = 0; h < HISTOGRAMS; ++h) {
+                HistogramCells& to = r.retired.histograms[h];
+                const HistogramCells& from = block->histograms[h];
+                for (std::size_t i = 0; i < HistogramBuckets::COUNT; ++i)
+                    bump(to.buckets[i], from.buckets[i].load(std::memory_order_relaxed));
+                bump(to.sum, from.sum.load(std::memory_order_relaxed));
+                to.max.store(std::max(to.max.load(std::memory_order_relaxed), from.max.load(std::memory_order_relaxed)),
+                             std::memory_order_relaxed);
+            }
+            delete block;
+        }
+    };
+
+    static Block& local() {
+        thread_local ThreadBlock threadBlock;
+        return *threadBlock.block;
+    }
+
+    template <typename Visit>
+    static void forEachBlock(const Visit& visit) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        visit(r.retired);
+        for (const Block* block : r.live)
+            visit(*block);
+    }
+
+    static const char* name(Counter counter) {
+        static const char* names[] = {"io_read_bytes_total",           "io_written_bytes_total",
+                                      "fsyncs_total",                  "orders_placed_total",
+                                      "checkpoints_total",             "checkpoint_written_bytes_total",
+                                      "checkpoints_coalesced_total",   "id_leases_total"};
+        return names[static_cast<std::size_t>(counter)];
+    }
+
+    static const char* name(Histogram histogram) {
+        static const char* names[] = {"place_order_seconds",        "commit_log_seconds",
+                                      "checkpoint_seconds",         "checkpoint_capture_seconds",
+                                      "save_products_seconds",      "save_orders_seconds",
+                                      "load_products_seconds",      "load_orders_seconds",
+                                      "fsync_seconds",              "hash_probe_length",
+                                      "avl_lookup_depth"};
+        return names[static_cast<std::size_t>(histogram)];
+    }
+
+    static bool isLatency(Histogram histogram) {
+        return histogram != Histogram::HashProbeLength && histogram != Histogram::AvlDepth;
+    }
+
+public:
+    static void add(Counter counter, std::uint64_t amount = 1) {
+        bump(local().counters[static_cast<std::size_t>(counter)], amount);
+    }
+
+    static void record(Histogram histogram, std::uint64_t value) {
+        HistogramCells& cells = local().histograms[static_cast<std::size_t>(histogram)];
+        bump(cells.buckets[HistogramBuckets::indexOf(value)], 1);
+        bump(cells.sum, value);
+        if (value > cells.max.load(std::memory_order_relaxed))
+            cells.max.store(value, std::memory_order_relaxed);
+    }
+
+    static std::uint64_t total(Counter counter) {
+        std::uint64_t sum = 0;
+        forEachBlock([&](const Block& block) {
+            sum += block.counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+        });
+        return sum;
+    }
+
+    static HistogramSnapshot snapshot(Histogram histogram) {
+        HistogramSnapshot result;
+        result.buckets.assign(HistogramBuckets::COUNT, 0);
+        forEachBlock([&](const Block& block) {
+            const HistogramCells& cells = block.histograms[static_cast<std::size_t>(histogram)];
+            for (std::size_t i = 0; i < HistogramBuckets::COUNT; ++i) {
+                std::uint64_t n = cells.buckets[i].load(std::memory_order_relaxed);
+                result.buckets[i] += n;
+                result.count += n;
+            }
+            result.sum += cells.sum.load(std::memory_order_relaxed);
+            result.max = std::max(result.max, cells.max.load(std::memory_order_relaxed));
+        });
+        return result;
+    }
+
+    // Human-readable table: counters, then count and p50/p99/max per
+    // histogram (milliseconds for latencies).
+    static void print(std::ostream& out) {
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        for (std::size_t c = 0; c < COUNTERS; ++c)
+            out << "  " << std::left << std::setw(32) << name(static_cast<Counter>(c)) << std::right << std::setw(10)
+                << total(static_cast<Counter>(c)) << std::endl;
+        out << "  " << std::left << std::setw(32) << "histogram (times in ms)" << std::right << std::setw(10) << "count"
+            << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "max" << std::endl;
+        for (std::size_t h = 0; h < HISTOGRAMS; ++h) {
+            const Histogram histogram = static_cast<Histogram>(h);
+            HistogramSnapshot s = snapshot(histogram);
+            const double scale = isLatency(histogram) ? 1e-6 : 1.0; // ns -> ms
+            out << "  " << std::left << std::setw(32) << name(histogram) << std::right << std::setw(10) << s.count
+                << std::fixed << std::setprecision(isLatency(histogram) ? 3 : 0) << std::setw(12)
+                << s.quantile(0.50) * scale << std::setw(12) << s.quantile(0.99) * scale << std::setw(12)
+                << s.max * scale << std::endl;
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    // Prometheus text exposition format. Histograms list cumulative counts
+    // at the bounds of their non-empty buckets only.
+    static void writePrometheus(std::ostream& out) {
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        out << std::setprecision(9);
+        for (std::size_t c = 0; c < COUNTERS; ++c) {
+            const char* metric = name(static_cast<Counter>(c));
+            out << "# TYPE wearhouse_" << metric << " counter\n"
+                << "wearhouse_" << metric << " " << total(static_cast<Counter>(c)) << "\n";
+        }
+        for (std::size_t h = 0; h < HISTOGRAMS; ++h) {
+            const Histogram histogram = static_cast<Histogram>(h);
+            const char* metric = name(histogram);
+            const double scale = isLatency(histogram) ? 1e-9 : 1.0; // ns -> s
+            HistogramSnapshot s = snapshot(histogram);
+            out << "# TYPE wearhouse_" << metric << " histogram\n";
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < s.buckets.size(); ++i) {
+                if (s.buckets[i] == 0)
+                    continue;
+                cumulative += s.buckets[i];
+                out << "wearhouse_" << metric << "_bucket{le=\"" << HistogramBuckets::upperBound(i) * scale << "\"} "
+                    << cumulative << "\n";
+            }
+            out << "wearhouse_" << metric << "_bucket{le=\"+Inf\"} " << s.count << "\n"
+                << "wearhouse_" << metric << "_sum " << s.sum * scale << "\n"
+                << "wearhouse_" << metric << "_count " << s.count << "\n";
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+// Records the lifetime of a scope into a latency histogram.
+class MetricsTimer {
+private:
+    Histogram histogram;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit MetricsTimer(Histogram _histogram) : histogram(_histogram), start(std::chrono::steady_clock::now()) {}
+    ~MetricsTimer() {
+        Metrics::record(histogram, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                  std::chrono::steady_clock::now() - start)
+                                                                  .count()));
+    }
+
+    MetricsTimer(const MetricsTimer&) = delete;
+    MetricsTimer& operator=(const MetricsTimer&) = delete;
+};
+
+#define METRICS_CONCAT2(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT2(a, b)
+#define METRIC_TIME(histogram) MetricsTimer METRICS_CONCAT(metricsTimer, __LINE__)(Histogram::histogram)
+#define METRIC_ADD(counter, amount) Metrics::add(Counter::counter, (amount))
+#define METRIC_RECORD(histogram, value) Metrics::record(Histogram::histogram, (value))
+
+#else
+
+// sizeof keeps the arguments referenced without evaluating them.
+#define METRIC_TIME(histogram) ((void)0)
+#define METRIC_ADD(counter, amount) ((void)sizeof(amount))
+#define METRIC_RECORD(histogram, value) ((void)sizeof(value))
+
+#endif
+
+#endif
@@ -0,0 +1,213 @@
+// Money.h
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+// An amount of money as a whole number of minor units (1/100 of the
+// currency unit), so sums and differences are exact and come out the same
+// in any order, on any machine. Text is a plain decimal with two places
+// ("4107.50"); parse() also accepts fewer places and the float notation
+// older files were written in ("1.23457e+06"), rounding to the nearest
+// minor unit.
+class Money {
+private:
+    std::int64_t minor;
+
+    explicit constexpr Money(std::int64_t minorUnits) : minor(minorUnits) {}
+
+    // Digits of `text` as a non-negative count, or false on anything else
+    // or overflow.
+    static bool parseDigits(std::string_view text, std::int64_t& value) {
+        value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9' || value > (std::numeric_limits<std::int64_t>::max() - 9) / 10)
+                return false;
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    }
+
+    // |value| without overflow, INT64_MIN included.
+    static constexpr std::uint64_t magnitude(std::int64_t value) {
+        return value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+    }
+
+    static bool parseFloat(std::string_view text, Money& out) {
+        double value;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size() || !std::isfinite(value) ||
+            std::fabs(value) >= 9.0e16 / SCALE)
+            return false;
+        out = fromDouble(value);
+        return true;
+    }
+
+public:
+    static constexpr std::int64_t SCALE = 100;
+
+    constexpr Money() : minor(0) {}
+
+    static constexpr Money fromMinorUnits(std::int64_t minorUnits) { return Money(minorUnits); }
+    static constexpr Money max() { return Money(std::numeric_limits<std::int64_t>::max()); }
+
+    // Nearest minor unit, halves away from zero. Only for amounts that
+    // arrive as floating point (generated data, older files).
+    static Money fromDouble(double value) { return Money(std::llround(value * SCALE)); }
+
+    constexpr std::int64_t minorUnits() const { return minor; }
+    double toDouble() const { return static_cast<double>(minor) / SCALE; }
+
+    // "12", "12.5", "12.50", "-0.05"; more than two places round to the
+    // nearest minor unit, halves away from zero.
+    static bool parse(std::string_view text, Money& out) {
+        bool negative = !text.empty() && text[0] == '-';
+        std::string_view digits = negative ? text.substr(1) : text;
+        std::size_t dot = digits.find('.');
+        std::string_view whole = digits.substr(0, dot);
+        std::string_view fraction = dot == std::string_view::npos ? std::string_view() : digits.substr(dot + 1);
+        std::int64_t units, cents = 0;
+        if (whole.empty() || (dot != std::string_view::npos && fraction.empty()) || !parseDigits(whole, units) ||
+            units > std::numeric_limits<std::int64_t>::max() / SCALE - 1)
+            return parseFloat(text, out);
+        for (std::size_t i = 0; i < fraction.size(); ++i) {
+            if (fraction[i] < '0' || fraction[i] > '9')
+                return parseFloat(text, out);
+            if (i < 2)
+                cents = cents * 10 + (fraction[i] - '0');
+            else if (i == 2 && fraction[i] >= '5')
+                ++cents;
+        }
+        if (fraction.size() == 1)
+            cents *= 10;
+        out = Money(units * SCALE + cents);
+        if (negative)
+            out.minor = -out.minor;
+        return true;
+    }
+
+    // Appends the two-place decimal text; no allocation beyond `out`'s own.
+    void appendTo(std::string& out) const {
+        char text[24];
+        char* end = text;
+        const std::uint64_t units = magnitude(minor);
+        if (minor < 0)
+            *end++ = '-';
+        end = std::to_chars(end, text + sizeof(text), units / SCALE).ptr;
+        const unsigned cents = static_cast<unsigned>(units % SCALE);
+        *end++ = '.';
+        *end++ = static_cast<char>('0' + cents / 10);
+        *end++ = static_cast<char>('0' + cents % 10);
+        out.append(text, static_cast<std::size_t>(end - text));
+    }
+
+    std::string toString() const {
+        std::string text;
+        appendTo(text);
+        return text;
+    }
+
+    // This amount times numerator / denominator (denominator > 0), rounded
+    // to the nearest minor unit, halves away from zero. Works on unsigned
+    // magnitudes, so INT64_MIN is a valid input, and a result too large
+    // for 64 bits saturates at max() (or its negation). The split below
+    // is exact while |numerator| * denominator fits in 64 bits; larger
+    // factors go through a 128-bit product where the compiler has one.
+    Money scaled(std::int64_t numerator, std::int64_t denominator) const {
+        const bool negative = (minor < 0) != (numerator < 0);
+        const std::uint64_t a = magnitude(minor), n = magnitude(numerator);
+        const std::uint64_t d = static_cast<std::uint64_t>(denominator);
+        const std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+        std::uint64_t result;
+#ifdef __SIZEOF_INT128__
+        if (n != 0 && d > std::numeric_limits<std::uint64_t>::max() / n) {
+            __extension__ typedef unsigned __int128 Wide;
+            const Wide product = static_cast<Wide>(a) * n;
+            const Wide rounded = product / d + (2 * (product % d) >= d);
+            result = rounded > limit ? limit : static_cast<std::uint64_t>(rounded);
+            return Money(negative ? -static_cast<std::int64_t>(result) : static_cast<std::int64_t>(result));
+        }
+#endif
+        const std::uint64_t whole = a / d, rest = a % d;
+        if (n != 0 && whole > limit / n) {
+            result = limit;
+        } else {
+            const std::uint64_t scaledRest = rest * n;
+            result = whole * n + scaledRest / d + (2 * (scaledRest % d) >= d);
+            result = result > limit ? limit : result;
+        }
+        return Money(negative ? -static_cast<std::int64_t>(result) : static_cast<std::int64_t>(result));
+    }
+
+    Money& operator+=(Money other) {
+        minor += other.minor;
+        return *this;
+    }
+    Money& operator-=(Money other) {
+        minor -= other.minor;
+        return *this;
+    }
+    Money operator+(Money other) const { return Money(minor + other.minor); }
+    Money operator-(Money other) const { return Money(minor - other.minor); }
+    Money operator-() const { return Money(-minor); }
+    Money operator*(std::int64_t count) const { return Money(minor * count); }
+
+    bool operator==(Money other) const { return minor == other.minor; }
+    bool operator!=(Money other) const { return minor != other.minor; }
+    bool operator<(Money other) const { return minor < other.minor; }
+    bool operator<=(Money other) const { return minor <= other.minor; }
+    bool operator>(Money other) const { return minor > other.minor; }
+    bool operator>=(Money other) const { return minor >= other.minor; }
+};
+
+inline std::ostream& operator<<(std::ostream& os, Money amount) {
+    std::string text;
+    amount.appendTo(text);
+    return os << text;
+}
+
+// Batch kernels over contiguous columns of amounts (an order history's
+// totals, the catalog's prices). Each is a branch-free pass over
+// plain 64-bit integers with independent accumulators, which compilers
+// turn into vector adds and multiplies; integer sums give the same result
+// however the lanes split the work.
+
+// Sum of values[0, n).
+inline Money sumMoney(const Money* values, std::size_t n) {
+    std::int64_t lane[4] = {0, 0, 0, 0};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        lane[0] += values[i].minorUnits();
+        lane[1] += values[i + 1].minorUnits();
+        lane[2] += values[i + 2].minorUnits();
+        lane[3] += values[i + 3].minorUnits();
+    }
+    for (; i < n; ++i)
+        lane[0] += values[i].minorUnits();
+    return Money::fromMinorUnits(lane[0] + lane[1] + lane[2] + lane[3]);
+}
+
+// Sum of prices[i] * quantities[i]: the value of a catalog's stock.
+inline Money stockValue(const Money* prices, const std::int32_t* quantities, std::size_t n) {
+    std::int64_t lane[4] = {0, 0, 0, 0};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        lane[0] += prices[i].minorUnits() * quantities[i];
+        lane[1] += prices[i + 1].minorUnits() * quantities[i + 1];
+        lane[2] += prices[i + 2].minorUnits() * quantities[i + 2];
+        lane[3] += prices[i + 3].minorUnits() * quantities[i + 3];
+    }
+    for (; i < n; ++i)
+        lane[0] += prices[i].minorUnits() * quantities[i];
+    return Money::fromMinorUnits(lane[0] + lane[1] + lane[2] + lane[3]);
+}
+
+#endif
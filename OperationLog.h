@@ -0,0 +1,322 @@
+// OperationLog.h
+#ifndef OPERATIONLOG_H
+#define OPERATIONLOG_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "AtomicFile.h"
+#include "Metrics.h"
+
+// Kinds of mutation recorded in the operation log. Payloads use the same
+// comma-separated layout as the matching snapshot file.
+enum class LogOp {
+    ProductPut,     // products.txt line
+    ProductDelete,  // product id
+    OrderAdd,       // orders.txt line
+    CustomerPut,    // customers.txt line
+    CustomerDelete, // customer id
+    SalesSet,       // monthYear,total (absolute, so replay is idempotent)
+    IdCounters,     // nextOrderId nextTrackingId (older versions; ids are leased now)
+    ShipmentPut,    // shipments.txt line
+    ShipmentAdvance // trackingId,status
+};
+
+enum class FsyncPolicy {
+    Always,   // fsync after every group commit
+    Interval, // fsync at most once per sync interval
+    Never     // leave flushing to the operating system
+};
+
+// Append-only, checksummed operation log.
+// Each record is one text line "lsn|OP|payload|crc32", where the CRC covers
+// everything before the last '|'. Records are buffered and written together
+// by commit(), so a multi-record operation costs one write and at most one
+// fsync. Replay stops at the first damaged record and cuts the torn tail off.
+// A checkpoint rotate()s the log to <file>.1 while it still holds its
+// locks and dropRotated()s it once the snapshots are durable; until then
+// replay reads the rotated records before the live ones.
+class OperationLog {
+private:
+    std::string filename;
+    std::FILE* file;
+    std::string pending;
+    std::size_t pendingRecords;
+    std::size_t groupSize;
+    FsyncPolicy policy;
+    std::chrono::milliseconds syncInterval;
+    std::chrono::steady_clock::time_point lastSync;
+    std::uint64_t nextLsn;
+    std::size_t sinceCheckpoint;
+    std::uint32_t opsSinceCheckpoint; // bit (1 << op) per kind appended
+
+    static const char* opName(LogOp op) {
+        switch (op) {
+        case LogOp::ProductPut: return "PRODUCT_PUT";
+        case LogOp::ProductDelete: return "PRODUCT_DEL";
+        case LogOp::OrderAdd: return "ORDER_ADD";
+        case LogOp::CustomerPut: return "CUSTOMER_PUT";
+        case LogOp::CustomerDelete: return "CUSTOMER_DEL";
+        case LogOp::SalesSet: return "SALES_SET";
+        case LogOp::IdCounters: return "ID_COUNTERS";
+        case LogOp::ShipmentPut: return "SHIPMENT_PUT";
+        case LogOp::ShipmentAdvance: return "SHIPMENT_STATUS";
+        }
+        return "";
+    }
+
+    static bool parseOp(const std::string& name, LogOp& op) {
+        static const LogOp all[] = {LogOp::ProductPut, LogOp::ProductDelete, LogOp::OrderAdd,
+                                    LogOp::CustomerPut, LogOp::CustomerDelete, LogOp::SalesSet,
+                                    LogOp::IdCounters, LogOp::ShipmentPut, LogOp::ShipmentAdvance};
+        for (LogOp candidate : all) {
+            if (name == opName(candidate)) {
+                op = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static std::string toHex(std::uint32_t value) {
+        char buf[9];
+        std::snprintf(buf, sizeof(buf), "%08x", value);
+        return buf;
+    }
+
+    // Parses one record line; returns false if it is malformed or fails its checksum.
+    static bool parseRecord(const std::string& line, std::uint64_t& lsn, LogOp& op, std::string& payload) {
+        size_t crcPos = line.rfind('|');
+        size_t lsnEnd = line.find('|');
+        if (crcPos == std::string::npos || lsnEnd == crcPos)
+            return false;
+        size_t opEnd = line.find('|', lsnEnd + 1);
+        if (opEnd == std::string::npos || opEnd > crcPos)
+            return false;
+        if (line.compare(crcPos + 1, std::string::npos, toHex(crc32(line.data(), crcPos))) != 0)
+            return false;
+        try {
+            lsn = std::stoull(line.substr(0, lsnEnd));
+        } catch (...) {
+            return false;
+        }
+        if (!parseOp(line.substr(lsnEnd + 1, opEnd - lsnEnd - 1), op))
+            return false;
+        payload = line.substr(opEnd + 1, crcPos - opEnd - 1);
+        return true;
+    }
+
+    bool sync() {
+        METRIC_TIME(Fsync);
+        METRIC_ADD(Fsyncs, 1);
+        if (std::fflush(file) != 0)
+            return false;
+#ifdef _WIN32
+        bool ok = _commit(_fileno(file)) == 0;
+#else
+        bool ok = fsync(fileno(file)) == 0;
+#endif
+        lastSync = std::chrono::steady_clock::now();
+        return ok;
+    }
+
+public:
+    static std::uint32_t crc32(const char* data, std::size_t len) {
+        static const std::array<std::uint32_t, 256> table = [] {
+            std::array<std::uint32_t, 256> t{};
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+        std::uint32_t crc = 0xFFFFFFFFu;
+        for (std::size_t i = 0; i < len; ++i)
+            crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    OperationLog(const std::string& file, FsyncPolicy fsyncPolicy = FsyncPolicy::Always,
+                 std::size_t groupCommitRecords = 64,
+                 std::chrono::milliseconds interval = std::chrono::milliseconds(1000))
+        : filename(file), file(nullptr), pendingRecords(0), groupSize(groupCommitRecords),
+          policy(fsyncPolicy), syncInterval(interval), lastSync(std::chrono::steady_clock::now()),
+          nextLsn(1), sinceCheckpoint(0), opsSinceCheckpoint(0) {}
+
+    ~OperationLog() {
+        commit();
+        if (file)
+            std::fclose(file);
+    }
+
+    OperationLog(const OperationLog&) = delete;
+    OperationLog& operator=(const OperationLog&) = delete;
+
+    void setFsyncPolicy(FsyncPolicy fsyncPolicy) { policy = fsyncPolicy; }
+    void setGroupCommitSize(std::size_t records) { groupSize = records ? records : 1; }
+
+    static std::uint32_t opBit(LogOp op) { return 1u << static_cast<unsigned>(op); }
+
+    std::string rotatedFilename() const { return filename + ".1"; }
+
+    // Applies every intact record with an LSN above checkpointLsn, from the
+    // rotated log and then the live one, and opens the log for appending.
+    // Returns the number of records applied.
+    std::size_t replay(std::uint64_t checkpointLsn,
+                       const std::function<void(LogOp, const std::string&)>& apply) {
+        std::uint64_t lastLsn = checkpointLsn;
+        sinceCheckpoint = 0;
+        opsSinceCheckpoint = 0;
+        std::size_t applied = replayFile(rotatedFilename(), checkpointLsn, lastLsn, apply);
+        applied += replayFile(filename, checkpointLsn, lastLsn, apply);
+        nextLsn = lastLsn + 1;
+        file = std::fopen(filename.c_str(), "ab");
+        if (!file)
+            std::cerr << "Error opening operation log " << filename << std::endl;
+        return applied;
+    }
+
+private:
+    std::size_t replayFile(const std::string& path, std::uint64_t checkpointLsn, std::uint64_t& lastLsn,
+                           const std::function<void(LogOp, const std::string&)>& apply) {
+        std::size_t applied = 0;
+        std::uintmax_t validBytes = 0;
+        bool torn = false;
+        std::ifstream ifs(path, std::ios::binary);
+        if (ifs.is_open()) {
+            std::string line, payload;
+            while (std::getline(ifs, line)) {
+                std::uint64_t lsn;
+                LogOp op;
+                if (ifs.eof() || !parseRecord(line, lsn, op, payload)) {
+                    torn = true; // unterminated or corrupt: everything after it is unreliable
+                    break;
+                }
+                validBytes += line.size() + 1;
+                if (lsn > lastLsn)
+                    lastLsn = lsn;
+                if (lsn <= checkpointLsn)
+                    continue;
+                apply(op, payload);
+                opsSinceCheckpoint |= opBit(op);
+                ++applied;
+            }
+            torn = torn || (!ifs.eof() && ifs.fail());
+            ifs.close();
+        }
+        if (torn) {
+            std::cerr << "Warning: discarding damaged tail of " << path << " after "
+                      << validBytes << " bytes" << std::endl;
+            std::error_code ec;
+            std::filesystem::resize_file(path, validBytes, ec);
+        }
+        sinceCheckpoint += applied;
+        return applied;
+    }
+
+public:
+
+    // Buffers one record; it becomes durable on the next commit().
+    void append(LogOp op, const std::string& payload) {
+        std::string body = std::to_string(nextLsn++) + "|" + opName(op) + "|" + payload;
+        pending += body;
+        pending += '|';
+        pending += toHex(crc32(body.data(), body.size()));
+        pending += '\n';
+        ++pendingRecords;
+        ++sinceCheckpoint;
+        opsSinceCheckpoint |= opBit(op);
+        if (pendingRecords >= groupSize)
+            commit();
+    }
+
+    // Writes all buffered records with a single write and applies the fsync policy.
+    bool commit() {
+        if (pending.empty())
+            return true;
+        if (!file) {
+            std::cerr << "Error writing to " << filename << ": log is not open" << std::endl;
+            return false;
+        }
+        bool ok = std::fwrite(pending.data(), 1, pending.size(), file) == pending.size();
+        METRIC_ADD(BytesWritten, pending.size());
+        pending.clear();
+        pendingRecords = 0;
+        if (policy == FsyncPolicy::Always ||
+            (policy == FsyncPolicy::Interval &&
+             std::chrono::steady_clock::now() - lastSync >= syncInterval)) {
+            ok = sync() && ok;
+        } else {
+            ok = std::fflush(file) == 0 && ok;
+        }
+        if (!ok)
+            std::cerr << "Error writing to " << filename << std::endl;
+        return ok;
+    }
+
+    // Moves the committed records aside to <file>.1 and starts an empty log,
+    // so a checkpoint can write its snapshots while new records keep
+    // arriving. If an earlier checkpoint failed to drop its rotated log,
+    // the records are appended to it instead. LSNs keep counting up.
+    bool rotate() {
+        commit();
+        if (file)
+            std::fclose(file);
+        file = nullptr;
+        std::error_code ec;
+        bool ok;
+        if (std::filesystem::exists(rotatedFilename(), ec)) {
+            std::ifstream ifs(filename, std::ios::binary);
+            std::ofstream ofs(rotatedFilename(), std::ios::binary | std::ios::app);
+            ok = ofs.is_open();
+            if (ifs.is_open() && ofs.is_open())
+                ofs << ifs.rdbuf();
+            ofs.close();
+            ok = ok && ofs && syncPath(rotatedFilename());
+        } else {
+            std::filesystem::rename(filename, rotatedFilename(), ec);
+            ok = !ec || !std::filesystem::exists(filename);
+            std::string directory = std::filesystem::path(filename).parent_path().string();
+            syncPath(directory.empty() ? "." : directory, true);
+        }
+        // On failure the records stay where they were and the log carries on.
+        file = std::fopen(filename.c_str(), ok ? "wb" : "ab");
+        if (!file || !ok) {
+            std::cerr << "Error rotating operation log " << filename << std::endl;
+            return false;
+        }
+        sinceCheckpoint = 0;
+        opsSinceCheckpoint = 0;
+        return sync();
+    }
+
+    // Deletes the rotated records once the snapshots reflect them.
+    bool dropRotated() {
+        std::error_code ec;
+        std::filesystem::remove(rotatedFilename(), ec);
+        if (ec)
+            std::cerr << "Error removing " << rotatedFilename() << std::endl;
+        return !ec;
+    }
+
+    std::uint64_t lastLsn() const { return nextLsn - 1; }
+    std::size_t recordsSinceCheckpoint() const { return sinceCheckpoint; }
+
+    // The kinds of record appended since the last rotate(), as opBit()s.
+    std::uint32_t opsSinceRotate() const { return opsSinceCheckpoint; }
+};
+
+#endif
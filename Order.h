@@ -0,0 +1,167 @@
+// Order.h
+#ifndef ORDER_H
+#define ORDER_H
+
+#include <cstddef>
+#include <charconv>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include "CsvTokenizer.h"
+#include "Money.h"
+#include "SmallVector.h"
+#include "StringPool.h"
+
+// One line of a placed order. Only the product id is kept; names and
+// categories are looked up in the catalog when the order is displayed. The
+// unit price is the price paid, which later catalog edits must not change.
+struct OrderItem {
+    std::string productId;
+    int quantity;
+    Money unitPrice;
+};
+
+// Most orders have one to three lines; those are stored inside the order.
+typedef SmallVector<OrderItem, 3> OrderItems;
+
+// Order class
+// Move-only: orders travel from checkout into the history and back out by
+// moving, and the few places that need a second copy say so with clone().
+// The payment method is one of a few fixed names, kept as a symbol.
+class Order {
+public:
+    std::string orderId, trackingId, timestamp, customerName, customerAddress, customerPhone;
+    Symbol paymentMethod;
+    OrderItems items;
+    Money totalPrice;
+
+    Order(std::string _orderId = "", std::string _trackingId = "", std::string _timestamp = "",
+          std::string _customerName = "", std::string _customerAddress = "",
+          std::string _customerPhone = "", std::string_view _paymentMethod = "",
+          OrderItems _items = OrderItems(), Money _totalPrice = Money())
+        : orderId(std::move(_orderId)), trackingId(std::move(_trackingId)),
+          timestamp(std::move(_timestamp)), customerName(std::move(_customerName)),
+          customerAddress(std::move(_customerAddress)), customerPhone(std::move(_customerPhone)),
+          paymentMethod(_paymentMethod), items(std::move(_items)),
+          totalPrice(_totalPrice) {}
+
+    Order(Order&&) noexcept = default;
+    Order& operator=(Order&&) noexcept = default;
+    Order(const Order&) = delete;
+    Order& operator=(const Order&) = delete;
+
+    Order clone() const {
+        Order copy(orderId, trackingId, timestamp, customerName, customerAddress, customerPhone, "", items,
+                   totalPrice);
+        copy.paymentMethod = paymentMethod;
+        return copy;
+    }
+
+    // productName(const std::string& id) returns the display name of a
+    // product id; deleted products can fall back to the id itself.
+    template <typename ProductName>
+    std::string toString(const ProductName& productName) const {
+        std::stringstream ss;
+        ss << "Order ID: " << orderId << "\nTracking ID: " << trackingId
+           << "\nTimestamp: " << timestamp << "\nCustomer: " << customerName << ", "
+           << customerAddress << ", " << customerPhone
+           << "\nPayment Method: " << paymentMethod << "\nItems:\n";
+        for (const OrderItem& item : items) {
+            ss << productName(item.productId) << " x " << item.quantity << " = $"
+               << (item.unitPrice * item.quantity) << "\n";
+        }
+        ss << "Total: $" << totalPrice;
+        return ss.str();
+    }
+
+    // Heap bytes held by this order, for the resident-order budget.
+    std::size_t memoryUsage() const {
+        std::size_t bytes = sizeof(Order) + items.heapBytes();
+        for (const std::string* s : {&orderId, &trackingId, &timestamp, &customerName,
+                                     &customerAddress, &customerPhone}) {
+            if (s->capacity() > 15)
+                bytes += s->capacity() + 1;
+        }
+        for (const OrderItem& item : items) {
+            if (item.productId.capacity() > 15)
+                bytes += item.productId.capacity() + 1;
+        }
+        return bytes;
+    }
+
+    // orders.txt layout; items are "productId:quantity:unitPrice" joined by
+    // ';'. Text fields are quoted when they contain a comma or a quote.
+    std::string toCsv() const {
+        std::string line;
+        for (const std::string* field : {&orderId, &trackingId, &timestamp, &customerName,
+                                         &customerAddress, &customerPhone, &paymentMethod.str()}) {
+            appendCsvField(line, *field);
+            line += ',';
+        }
+        totalPrice.appendTo(line);
+        line += ',';
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            if (i > 0)
+                line += ';';
+            char quantity[16];
+            line += items[i].productId;
+            line += ':';
+            line.append(quantity, std::to_chars(quantity, quantity + sizeof(quantity), items[i].quantity).ptr);
+            line += ':';
+            items[i].unitPrice.appendTo(line);
+        }
+        return line;
+    }
+
+    // Fills `order` from a tokenized orders.txt record. Older files store
+    // items as "productId:quantity"; their unit price is left negative so
+    // the caller can fill it in from the catalog. Unreadable items are
+    // dropped.
+    static bool fromRow(const CsvRow& row, Order& order) {
+        if (row.size() < 8)
+            return false;
+        std::string* fields[] = {&order.orderId, &order.trackingId, &order.timestamp, &order.customerName,
+                                 &order.customerAddress, &order.customerPhone};
+        for (std::size_t i = 0; i < 6; ++i)
+            fields[i]->assign(row[i]);
+        order.paymentMethod = Symbol(row[6]);
+        if (!Money::parse(row[7], order.totalPrice))
+            order.totalPrice = Money();
+        order.items.clear();
+        std::string_view rest = row.size() > 8 ? row[8] : std::string_view();
+        while (!rest.empty()) {
+            std::size_t end = rest.find(';');
+            std::string_view item = rest.substr(0, end);
+            rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+            std::size_t colon = item.find(':');
+            if (colon == std::string_view::npos)
+                continue;
+            std::string_view quantity = item.substr(colon + 1);
+            std::size_t priceColon = quantity.find(':');
+            OrderItem parsed{std::string(item.substr(0, colon)), 0, Money::fromMinorUnits(-1)};
+            auto q = std::from_chars(quantity.data(), quantity.data() + quantity.size(), parsed.quantity);
+            if (q.ec != std::errc() || (priceColon != std::string_view::npos && q.ptr != quantity.data() + priceColon))
+                continue;
+            if (priceColon != std::string_view::npos) {
+                std::string_view price = quantity.substr(priceColon + 1);
+                if (!Money::parse(price, parsed.unitPrice))
+                    continue;
+            }
+            order.items.push_back(std::move(parsed));
+        }
+        return true;
+    }
+
+    static Order fromCsv(std::string_view line) {
+        Order order;
+        CsvRow row;
+        if (CsvTokenizer::splitLine(line, row))
+            fromRow(row, order);
+        return order;
+    }
+};
+
+#endif
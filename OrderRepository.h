@@ -0,0 +1,513 @@
+// OrderRepository.h
+#ifndef ORDERREPOSITORY_H
+#define ORDERREPOSITORY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "AtomicFile.h"
+#include "CsvTokenizer.h"
+#include "CustomHashTable.h"
+#include "MappedFile.h"
+#include "Metrics.h"
+#include "Money.h"
+#include "Order.h"
+#include "ThreadPool.h"
+
+// Order history kept on disk in append-only segment files
+// (segment-000001.dat, ...), one orders.txt line per order.
+// Memory holds a small fixed-size index entry per order (segment, offset,
+// packed timestamp, total) plus hash indexes by order id and tracking id,
+// so memory grows by a few dozen bytes per order rather than by the orders
+// themselves. The most recently placed orders stay resident up to a byte
+// budget; older ones are read back from their segment when asked for. A full segment is sealed with a sidecar .idx
+// file so startup reads the index rather than every order.
+class OrderRepository {
+private:
+    struct Entry {
+        std::int64_t time; // packTime(timestamp)
+        Money total;
+        std::uint32_t segment;
+        std::uint64_t offset;
+    };
+
+    // Reads orders by index entry, reusing the open segment and skipping
+    // the seek when entries are visited in placement order.
+    class SegmentReader {
+    private:
+        const OrderRepository& owner;
+        std::ifstream ifs;
+        std::uint32_t segment = 0;
+        std::uint64_t position = 0;
+
+    public:
+        explicit SegmentReader(const OrderRepository& _owner) : owner(_owner) {}
+
+        bool read(const Entry& entry, Order& out) {
+            if (segment != entry.segment) {
+                ifs.close();
+                ifs.clear();
+                ifs.open(owner.segmentPath(entry.segment), std::ios::binary);
+                segment = entry.segment;
+                position = 0;
+            }
+            if (position != entry.offset) {
+                ifs.clear();
+                ifs.seekg(static_cast<std::streamoff>(entry.offset));
+            }
+            std::string line;
+            if (!ifs.is_open() || !std::getline(ifs, line)) {
+                std::cerr << "Error reading order at " << owner.segmentPath(entry.segment) << ":"
+                          << entry.offset << std::endl;
+                segment = 0;
+                return false;
+            }
+            position = entry.offset + line.size() + 1;
+            out = Order::fromCsv(line);
+            return true;
+        }
+    };
+
+    std::string directory;
+    std::size_t residentBudget;
+    std::uint64_t segmentLimit;
+    std::vector<Entry> entries; // placement order
+    CustomHashTable<std::string, std::uint32_t> byOrderId;
+    CustomHashTable<std::string, std::uint32_t> byTrackingId;
+    mutable std::vector<std::uint32_t> byTime;
+    mutable std::vector<Money> timeTotals; // entries[byTime[i]].total, as one column
+    mutable bool timeSorted;
+    std::deque<Order> resident; // entries [firstResident, entries.size())
+    std::uint32_t firstResident;
+    std::size_t residentBytes;
+    std::uint32_t activeSegment;
+    std::uint64_t activeBytes;
+    std::FILE* active;
+
+    // The first 14 digits of a "YYYY-MM-DD HH:MM:SS" timestamp (or a prefix
+    // of one) as YYYYMMDDhhmmss, padded with `pad` digits. Packed values
+    // sort like the text, and a prefix padded with '0' and with '9' bounds
+    // every timestamp that starts with it.
+    static std::int64_t packTime(std::string_view text, char pad = '0') {
+        std::int64_t packed = 0;
+        int digits = 0;
+        for (std::size_t i = 0; i < text.size() && digits < 14; ++i) {
+            if (text[i] >= '0' && text[i] <= '9') {
+                packed = packed * 10 + (text[i] - '0');
+                ++digits;
+            }
+        }
+        for (; digits < 14; ++digits)
+            packed = packed * 10 + (pad - '0');
+        return packed;
+    }
+
+    std::string segmentPath(std::uint32_t segment, const char* extension = ".dat") const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/segment-%06u%s", segment, extension);
+        return directory + name;
+    }
+
+    // Tokenizes one segment line for the index: id, tracking id and
+    // timestamp are row[0..2], the total is parsed, the items are not.
+    static bool parseSummary(std::string_view line, CsvRow& row, Money& total) {
+        return CsvTokenizer::splitLine(line, row) && row.size() >= 9 && !row[0].empty() &&
+               Money::parse(row[7], total);
+    }
+
+    // What the index keeps of one order, gathered before indexing so that
+    // segments can be read in parallel.
+    struct Summary {
+        std::string orderId, trackingId;
+        Entry entry;
+    };
+
+    void index(const std::string& orderId, const std::string& trackingId, Entry entry) {
+        std::uint32_t position = static_cast<std::uint32_t>(entries.size());
+        entries.push_back(std::move(entry));
+        byOrderId.insert(orderId, position);
+        if (!trackingId.empty())
+            byTrackingId.insert(trackingId, position);
+        // New orders almost always carry the latest timestamp; anything else
+        // (a legacy import, say) is sorted once on the next time query.
+        if (!byTime.empty() && entries.back().time < entries[byTime.back()].time)
+            timeSorted = false;
+        byTime.push_back(position);
+        timeTotals.push_back(entries.back().total);
+    }
+
+    void sortByTime() const {
+        if (timeSorted)
+            return;
+        std::stable_sort(byTime.begin(), byTime.end(), [this](std::uint32_t a, std::uint32_t b) {
+            return entries[a].time < entries[b].time;
+        });
+        for (std::size_t i = 0; i < byTime.size(); ++i)
+            timeTotals[i] = entries[byTime[i]].total;
+        timeSorted = true;
+    }
+
+    // Positions in byTime of the orders whose timestamp starts within
+    // [from, to]. Call after sortByTime().
+    void timeRange(const std::string& from, const std::string& to, std::size_t& first, std::size_t& last) const {
+        const std::int64_t lowest = packTime(from, '0'), highest = packTime(to, '9');
+        auto begin = std::partition_point(byTime.begin(), byTime.end(),
+                                          [&](std::uint32_t p) { return entries[p].time < lowest; });
+        auto end = std::partition_point(begin, byTime.end(),
+                                        [&](std::uint32_t p) { return entries[p].time <= highest; });
+        first = static_cast<std::size_t>(begin - byTime.begin());
+        last = static_cast<std::size_t>(end - byTime.begin());
+    }
+
+    // Summarizes every order in `segment` and returns the bytes that hold
+    // complete lines; an unterminated last line is a torn write.
+    std::uint64_t scanSegment(std::uint32_t segment, std::vector<Summary>& out) const {
+        MappedFile file;
+        if (!file.open(segmentPath(segment)))
+            return 0;
+        std::string_view text(file.data(), file.size());
+        std::uint64_t offset = 0;
+        CsvRow row;
+        Money total;
+        for (std::size_t end; (end = text.find('\n', offset)) != std::string_view::npos; offset = end + 1) {
+            if (parseSummary(text.substr(offset, end - offset), row, total))
+                out.push_back(Summary{row.str(0), row.str(1), Entry{packTime(row[2]), total, segment, offset}});
+        }
+        return offset;
+    }
+
+    // Index files start with the size of the segment they describe, so a
+    // stale or half-written one is ignored and the segment rescanned.
+    bool loadSegmentIndex(std::uint32_t segment, std::vector<Summary>& out) const {
+        MappedFile file;
+        if (!file.open(segmentPath(segment, ".idx")))
+            return false;
+        CsvTokenizer tokenizer(std::string_view(file.data(), file.size()));
+        CsvRow row;
+        std::uint64_t bytes = 0;
+        std::error_code ec;
+        if (!tokenizer.next(row) || !row.number(0, bytes) || bytes != std::filesystem::file_size(segmentPath(segment), ec))
+            return false;
+        while (tokenizer.next(row)) {
+            Money total;
+            std::uint64_t offset;
+            if (row.size() != 5 || !Money::parse(row[3], total) || !row.number(4, offset)) {
+                out.clear();
+                return false;
+            }
+            out.push_back(Summary{row.str(0), row.str(1), Entry{packTime(row[2]), total, segment, offset}});
+        }
+        if (!tokenizer.error().empty()) {
+            out.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // Indexes summaries in placement order; a repeated order id keeps its
+    // first placement.
+    void indexAll(std::vector<Summary>& summaries) {
+        for (Summary& summary : summaries) {
+            if (!byOrderId.find(summary.orderId))
+                index(summary.orderId, summary.trackingId, std::move(summary.entry));
+        }
+    }
+
+    // Sealing is rare, so the index is written from a fresh sequential
+    // read of the segment rather than from state kept for every order.
+    bool writeSegmentIndex(std::uint32_t segment) const {
+        const std::string path = segmentPath(segment, ".idx");
+        std::ifstream ifs(segmentPath(segment), std::ios::binary);
+        std::ofstream ofs(path + ".tmp");
+        if (!ifs.is_open() || !ofs.is_open())
+            return false;
+        std::error_code ec;
+        ofs << std::filesystem::file_size(segmentPath(segment), ec) << "\n";
+        std::uint64_t offset = 0;
+        std::string line;
+        CsvRow row;
+        Money total;
+        while (std::getline(ifs, line) && !ifs.eof()) {
+            if (parseSummary(line, row, total)) {
+                for (std::size_t i = 0; i < 3; ++i) {
+                    writeCsvField(ofs, row[i]);
+                    ofs << ",";
+                }
+                ofs << total << "," << offset << "\n";
+            }
+            offset += line.size() + 1;
+        }
+        ofs.close();
+        return ofs && replaceFile(path + ".tmp", path);
+    }
+
+    bool openActive() {
+        active = std::fopen(segmentPath(activeSegment).c_str(), "ab");
+        if (!active)
+            std::cerr << "Error opening order segment " << segmentPath(activeSegment) << std::endl;
+        return active != nullptr;
+    }
+
+    bool roll() {
+        sync();
+        std::fclose(active);
+        active = nullptr;
+        if (!writeSegmentIndex(activeSegment))
+            std::cerr << "Warning: could not write " << segmentPath(activeSegment, ".idx") << std::endl;
+        ++activeSegment;
+        activeBytes = 0;
+        return openActive();
+    }
+
+    void evict() {
+        while (residentBytes > residentBudget && !resident.empty()) {
+            residentBytes -= resident.front().memoryUsage();
+            resident.pop_front();
+            ++firstResident;
+        }
+    }
+
+    bool load(std::uint32_t position, Order& out) const {
+        if (position >= firstResident) {
+            out = resident[position - firstResident].clone();
+            return true;
+        }
+        SegmentReader reader(*this);
+        return reader.read(entries[position], out);
+    }
+
+    // visit(const Order&) for positionAt(i), i in [first, last), reading
+    // evicted orders through one reader so runs from the same segment stay
+    // sequential.
+    template <typename PositionAt, typename Visit>
+    void visitPositions(std::size_t first, std::size_t last, const PositionAt& positionAt,
+                        const Visit& visit) const {
+        SegmentReader reader(*this);
+        Order scratch;
+        for (std::size_t i = first; i < last; ++i) {
+            const std::uint32_t position = positionAt(i);
+            if (position >= firstResident)
+                visit(resident[position - firstResident]);
+            else if (reader.read(entries[position], scratch))
+                visit(scratch);
+        }
+    }
+
+    template <typename Visit>
+    void visitPositions(const std::vector<std::uint32_t>& positions, const Visit& visit) const {
+        visitPositions(0, positions.size(), [&](std::size_t i) { return positions[i]; }, visit);
+    }
+
+public:
+    OrderRepository(const std::string& dir, std::size_t residentBudgetBytes = 4 << 20,
+                    std::uint64_t segmentBytes = 4 << 20)
+        : directory(dir), residentBudget(residentBudgetBytes), segmentLimit(segmentBytes),
+          byOrderId(1024), byTrackingId(1024), timeSorted(true), firstResident(0), residentBytes(0),
+          activeSegment(1), activeBytes(0), active(nullptr) {}
+
+    ~OrderRepository() {
+        if (active)
+            std::fclose(active);
+    }
+
+    OrderRepository(const OrderRepository&) = delete;
+    OrderRepository& operator=(const OrderRepository&) = delete;
+
+    // Indexes the segments on disk and opens the last one for appending.
+    // Given a pool, segments are read in parallel and indexed in order.
+    bool open(ThreadPool* pool = nullptr) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            std::cerr << "Error creating " << directory << ": " << ec.message() << std::endl;
+            return false;
+        }
+        activeSegment = 1;
+        while (std::filesystem::exists(segmentPath(activeSegment + 1)))
+            ++activeSegment;
+        std::vector<std::vector<Summary>> segments(activeSegment);
+        std::uint64_t scannedBytes = 0;
+        auto read = [&](std::uint32_t segment) {
+            std::vector<Summary>& out = segments[segment - 1];
+            if (segment == activeSegment) {
+                scannedBytes = scanSegment(segment, out);
+            } else if (std::filesystem::exists(segmentPath(segment)) && !loadSegmentIndex(segment, out)) {
+                scanSegment(segment, out);
+                writeSegmentIndex(segment);
+            }
+        };
+        if (pool) {
+            TaskGroup group(*pool);
+            for (std::uint32_t segment = 1; segment <= activeSegment; ++segment)
+                group.run([&read, segment] { read(segment); });
+        } else {
+            for (std::uint32_t segment = 1; segment <= activeSegment; ++segment)
+                read(segment);
+        }
+        for (std::vector<Summary>& summaries : segments)
+            indexAll(summaries);
+        activeBytes = scannedBytes;
+        if (std::filesystem::exists(segmentPath(activeSegment)) &&
+            std::filesystem::file_size(segmentPath(activeSegment), ec) != activeBytes) {
+            std::cerr << "Warning: discarding damaged tail of " << segmentPath(activeSegment)
+                      << " after " << activeBytes << " bytes" << std::endl;
+            std::filesystem::resize_file(segmentPath(activeSegment), activeBytes, ec);
+        }
+        firstResident = static_cast<std::uint32_t>(entries.size());
+        return openActive();
+    }
+
+    // Appends `order` to the history unless its id is already present.
+    // A bulk load may pass flush = false and call sync() once at the end;
+    // evicted orders cannot be read back until then.
+    bool add(Order order, bool flush = true) {
+        if (byOrderId.find(order.orderId))
+            return false;
+        if (!active && !openActive())
+            return false;
+        std::string line = order.toCsv();
+        line += '\n';
+        if (activeBytes > 0 && activeBytes + line.size() > segmentLimit && !roll())
+            return false;
+        if (std::fwrite(line.data(), 1, line.size(), active) != line.size() || (flush && std::fflush(active) != 0)) {
+            std::cerr << "Error writing to " << segmentPath(activeSegment) << std::endl;
+            return false;
+        }
+        METRIC_ADD(BytesWritten, line.size());
+        index(order.orderId, order.trackingId,
+              Entry{packTime(order.timestamp), order.totalPrice, activeSegment, activeBytes});
+        activeBytes += line.size();
+        residentBytes += order.memoryUsage();
+        resident.push_back(std::move(order));
+        evict();
+        return true;
+    }
+
+    // Makes appended orders durable; called before the operation log that
+    // also records them is truncated.
+    bool sync() {
+        if (!active)
+            return true;
+        METRIC_TIME(Fsync);
+        METRIC_ADD(Fsyncs, 1);
+        if (std::fflush(active) != 0)
+            return false;
+#ifdef _WIN32
+        return _commit(_fileno(active)) == 0;
+#else
+        return fsync(fileno(active)) == 0;
+#endif
+    }
+
+    // Hands appended orders to the OS without waiting for the disk and
+    // returns the segment they went to, for a checkpoint to syncPath()
+    // once its locks are released. Earlier segments were synced by roll().
+    std::string flush() {
+        if (active)
+            std::fflush(active);
+        return segmentPath(activeSegment);
+    }
+
+    void setResidentBudget(std::size_t bytes) {
+        residentBudget = bytes;
+        evict();
+    }
+
+    std::size_t residentCount() const { return resident.size(); }
+    std::size_t residentMemory() const { return residentBytes; }
+
+    bool findByOrderId(std::string_view orderId, Order& out) const {
+        const std::uint32_t* position = byOrderId.find(orderId);
+        return position && load(*position, out);
+    }
+
+    bool findByTrackingId(std::string_view trackingId, Order& out) const {
+        const std::uint32_t* position = byTrackingId.find(trackingId);
+        return position && load(*position, out);
+    }
+
+    bool contains(std::string_view orderId) const { return byOrderId.find(orderId) != nullptr; }
+
+    std::size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    // visit(const Order&) oldest first. Evicted orders are streamed from
+    // disk one at a time, so a full pass holds a single extra order.
+    template <typename Visit>
+    void forEachByTime(const Visit& visit) const {
+        sortByTime();
+        visitPositions(byTime, visit);
+    }
+
+    // visit(const Order&) in placement order, skipping the first `skip`
+    // orders ever added. Lets a consumer that counted what it has seen
+    // catch up on the rest.
+    template <typename Visit>
+    void forEachPlacedSince(std::size_t skip, const Visit& visit) const {
+        visitPositions(skip, entries.size(), [](std::size_t i) { return static_cast<std::uint32_t>(i); }, visit);
+    }
+
+    // Orders whose timestamp starts within [from, to]; bounds are timestamp
+    // prefixes such as "2025-06" or "2025-06-01", compared lexicographically.
+    template <typename Visit>
+    void forEachInTimeRange(const std::string& from, const std::string& to, const Visit& visit) const {
+        sortByTime();
+        std::size_t first, last;
+        timeRange(from, to, first, last);
+        visitPositions(first, last, [this](std::size_t i) { return byTime[i]; }, visit);
+    }
+
+    // Sum of the totals of the orders forEachInTimeRange would visit,
+    // from the in-memory index alone: no order is read and nothing is
+    // allocated once the time order is current.
+    Money totalInTimeRange(const std::string& from, const std::string& to) const {
+        sortByTime();
+        std::size_t first, last;
+        timeRange(from, to, first, last);
+        return sumMoney(timeTotals.data() + first, last - first);
+    }
+
+    // visit(const Order&) for the k orders with the largest total, highest
+    // first. The selection runs over the in-memory index; only the k
+    // winners are materialized.
+    template <typename Visit>
+    void forEachTopByTotal(std::size_t k, const Visit& visit) const {
+        if (k == 0)
+            return;
+        auto cheaper = [this](std::uint32_t a, std::uint32_t b) {
+            return entries[a].total > entries[b].total;
+        };
+        std::priority_queue<std::uint32_t, std::vector<std::uint32_t>, decltype(cheaper)> heap(cheaper);
+        for (std::uint32_t position = 0; position < entries.size(); ++position) {
+            if (heap.size() < k) {
+                heap.push(position);
+            } else if (entries[position].total > entries[heap.top()].total) {
+                heap.pop();
+                heap.push(position);
+            }
+        }
+        std::vector<std::uint32_t> top(heap.size());
+        for (auto it = top.rbegin(); it != top.rend(); ++it) {
+            *it = heap.top();
+            heap.pop();
+        }
+        visitPositions(top, visit);
+    }
+};
+
+#endif
@@ -0,0 +1,86 @@
+// Product.h
+#ifndef PRODUCT_H
+#define PRODUCT_H
+
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "CsvTokenizer.h"
+#include "Money.h"
+#include "StringPool.h"
+
+// Product class
+// Categories and subcategories come from a handful of values shared by the
+// whole catalog, so they are interned symbols rather than strings.
+class Product {
+public:
+    std::string id, name;
+    Symbol category, subcategory;
+    Money price;
+    int quantity;
+
+    Product(std::string _id = "", std::string _name = "", std::string_view _category = "",
+            std::string_view _subcategory = "", Money _price = Money(), int _quantity = 0)
+        : id(_id), name(_name), category(_category), subcategory(_subcategory),
+          price(_price), quantity(_quantity) {}
+
+    Product(std::string _id, std::string _name, Symbol _category, Symbol _subcategory, Money _price,
+            int _quantity)
+        : id(std::move(_id)), name(std::move(_name)), category(_category), subcategory(_subcategory),
+          price(_price), quantity(_quantity) {}
+
+    std::string toString() const {
+        return "ID: " + id + ", Name: " + name + ", Category: " + category.str() + " - " +
+               subcategory.str() + ", Price: $" + price.toString() +
+               ", Stock: " + std::to_string(quantity);
+    }
+
+    // One line of products.txt: id,name,category,subcategory,price,quantity.
+    // Text fields are quoted when they contain a comma or a quote.
+    void writeCsv(std::ostream& os) const {
+        writeCsvField(os, id);
+        os << ",";
+        writeCsvField(os, name);
+        os << ",";
+        writeCsvField(os, category.str());
+        os << ",";
+        writeCsvField(os, subcategory.str());
+        os << "," << price << "," << quantity;
+    }
+
+    std::string toCsv() const {
+        std::stringstream ss;
+        writeCsv(ss);
+        return ss.str();
+    }
+
+    // Fills `product` from a tokenized products.txt record. False if the id
+    // is missing or price/quantity are not numbers.
+    static bool fromRow(const CsvRow& row, Product& product) {
+        if (row.size() < 6 || row[0].empty())
+            return false;
+        if (!Money::parse(row[4], product.price) || !row.number(5, product.quantity))
+            return false;
+        product.id.assign(row[0]);
+        product.name.assign(row[1]);
+        product.category = Symbol(row[2]);
+        product.subcategory = Symbol(row[3]);
+        return true;
+    }
+
+    // A line that does not parse gives a product with an empty id.
+    static Product fromCsv(std::string_view line) {
+        Product product;
+        CsvRow row;
+        if (CsvTokenizer::splitLine(line, row) && !fromRow(row, product))
+            product = Product();
+        return product;
+    }
+
+    bool operator<(const Product& other) const { return id < other.id; }
+    bool operator==(const Product& other) const { return id == other.id; }
+};
+
+#endif
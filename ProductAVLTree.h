@@ -0,0 +1,221 @@
+// ProductAVLTree.h
+#ifndef PRODUCTAVLTREE_H
+#define PRODUCTAVLTREE_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "Product.h"
+
+// AVL Tree Node for Products
+struct AVLNode {
+    Product data;
+    AVLNode* left;
+    AVLNode* right;
+    int height;
+    AVLNode(const Product& _data)
+        : data(_data), left(nullptr), right(nullptr), height(1) {}
+};
+
+// ProductAVLTree class
+class ProductAVLTree {
+private:
+    AVLNode* root;
+
+    int getHeight(AVLNode* node) const { return node ? node->height : 0; }
+
+    int getBalance(AVLNode* node) const {
+        return node ? getHeight(node->left) - getHeight(node->right) : 0;
+    }
+
+    AVLNode* rightRotate(AVLNode* y) {
+        AVLNode* x = y->left;
+        AVLNode* T2 = x->right;
+        x->right = y;
+        y->left = T2;
+        y->height = std::max(getHeight(y->left), getHeight(y->right)) + 1;
+        x->height = std::max(getHeight(x->left), getHeight(x->right)) + 1;
+        return x;
+    }
+
+    AVLNode* leftRotate(AVLNode* x) {
+        AVLNode* y = x->right;
+        AVLNode* T2 = y->left;
+        y->left = x;
+        x->right = T2;
+        x->height = std::max(getHeight(x->left), getHeight(x->right)) + 1;
+        y->height = std::max(getHeight(y->left), getHeight(y->right)) + 1;
+        return y;
+    }
+
+    AVLNode* insertNode(AVLNode* node, const Product& product) {
+        if (!node)
+            return new AVLNode(product);
+
+        if (product.id < node->data.id)
+            node->left = insertNode(node->left, product);
+        else if (product.id > node->data.id)
+            node->right = insertNode(node->right, product);
+        else {
+            node->data = product; // Update existing product
+            return node;
+        }
+
+        node->height = std::max(getHeight(node->left), getHeight(node->right)) + 1;
+        int balance = getBalance(node);
+
+        if (balance > 1 && product.id < node->left->data.id)
+            return rightRotate(node);
+        if (balance < -1 && product.id > node->right->data.id)
+            return leftRotate(node);
+        if (balance > 1 && product.id > node->left->data.id) {
+            node->left = leftRotate(node->left);
+            return rightRotate(node);
+        }
+        if (balance < -1 && product.id < node->right->data.id) {
+            node->right = rightRotate(node->right);
+            return leftRotate(node);
+        }
+        return node;
+    }
+
+    AVLNode* minValueNode(AVLNode* node) {
+        AVLNode* current = node;
+        while (current->left)
+            current = current->left;
+        return current;
+    }
+
+    AVLNode* removeNode(AVLNode* node, const std::string& id) {
+        if (!node)
+            return node;
+
+        if (id < node->data.id)
+            node->left = removeNode(node->left, id);
+        else if (id > node->data.id)
+            node->right = removeNode(node->right, id);
+        else {
+            if (!node->left || !node->right) {
+                AVLNode* temp = node->left ? node->left : node->right;
+                if (!temp) {
+                    temp = node;
+                    node = nullptr;
+                } else {
+                    *node = *temp;
+                }
+                delete temp;
+            } else {
+                AVLNode* temp = minValueNode(node->right);
+                node->data = temp->data;
+                node->right = removeNode(node->right, temp->data.id);
+            }
+        }
+
+        if (!node)
+            return node;
+
+        node->height = std::max(getHeight(node->left), getHeight(node->right)) + 1;
+        int balance = getBalance(node);
+
+        if (balance > 1 && getBalance(node->left) >= 0)
+            return rightRotate(node);
+        if (balance > 1 && getBalance(node->left) < 0) {
+            node->left = leftRotate(node->left);
+            return rightRotate(node);
+        }
+        if (balance < -1 && getBalance(node->right) <= 0)
+            return leftRotate(node);
+        if (balance < -1 && getBalance(node->right) > 0) {
+            node->right = rightRotate(node->right);
+            return leftRotate(node);
+        }
+        return node;
+    }
+
+    AVLNode* findNode(AVLNode* node, const std::string& id) const {
+        if (!node || node->data.id == id)
+            return node;
+        if (id < node->data.id)
+            return findNode(node->left, id);
+        return findNode(node->right, id);
+    }
+
+    void inOrder(AVLNode* node, std::vector<Product>& result) const {
+        if (node) {
+            inOrder(node->left, result);
+            result.push_back(node->data);
+            inOrder(node->right, result);
+        }
+    }
+
+    template <typename RowSource>
+    AVLNode* buildRange(std::size_t lo, std::size_t hi, const RowSource& row) {
+        if (lo >= hi)
+            return nullptr;
+        std::size_t mid = lo + (hi - lo) / 2;
+        AVLNode* node = new AVLNode(row(mid));
+        node->left = buildRange(lo, mid, row);
+        node->right = buildRange(mid + 1, hi, row);
+        node->height = std::max(getHeight(node->left), getHeight(node->right)) + 1;
+        return node;
+    }
+
+    template <typename Visit>
+    void inOrderVisit(const AVLNode* node, const Visit& visit) const {
+        if (node) {
+            inOrderVisit(node->left, visit);
+            visit(node->data);
+            inOrderVisit(node->right, visit);
+        }
+    }
+
+    void deleteTree(AVLNode* node) {
+        if (node) {
+            deleteTree(node->left);
+            deleteTree(node->right);
+            delete node;
+        }
+    }
+
+public:
+    ProductAVLTree() : root(nullptr) {}
+    ~ProductAVLTree() { deleteTree(root); }
+
+    void insert(const Product& product) { root = insertNode(root, product); }
+
+    // Replaces the contents with `count` rows already sorted by id, where
+    // row(i) yields the i-th Product. Builds a balanced tree in O(n) with no
+    // comparisons or rotations.
+    template <typename RowSource>
+    void buildFromSorted(std::size_t count, const RowSource& row) {
+        deleteTree(root);
+        root = buildRange(0, count, row);
+    }
+
+    bool remove(const std::string& id) {
+        AVLNode* node = findNode(root, id);
+        if (!node)
+            return false;
+        root = removeNode(root, id);
+        return true;
+    }
+
+    Product* find(const std::string& id) {
+        AVLNode* node = findNode(root, id);
+        return node ? &node->data : nullptr;
+    }
+
+    // visit(const Product&) for every product in id order, without copying.
+    template <typename Visit>
+    void forEach(const Visit& visit) const {
+        inOrderVisit(root, visit);
+    }
+
+    std::vector<Product> getAllProducts() const {
+        std::vector<Product> result;
+        inOrder(root, result);
+        return result;
+    }
+};
+
+#endif
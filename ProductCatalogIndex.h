@@ -0,0 +1,153 @@
+// ProductCatalogIndex.h
+#ifndef PRODUCTCATALOGINDEX_H
+#define PRODUCTCATALOGINDEX_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Money.h"
+#include "Product.h"
+#include "StringPool.h"
+
+// Secondary indexes over the product catalog for filtered browsing.
+// Categories and subcategories are keyed by their symbol codes and map to
+// posting lists of product ids (kept in id order). Prices are kept
+// in a global price-ordered index and one per category, so a query such as
+// "Women, 1000-5000" walks only the matching range. The index stores ids
+// only; callers resolve them through the product tree, which also holds the
+// live stock level.
+class ProductCatalogIndex {
+private:
+    typedef std::pair<Money, std::string> PriceKey;
+
+    struct Entry {
+        std::uint32_t category;
+        std::uint32_t subcategory;
+        Money price;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_map<std::uint32_t, std::set<std::string>> byCategory;
+    std::unordered_map<std::uint32_t, std::set<std::string>> bySubcategory;
+    std::unordered_map<std::uint32_t, std::set<PriceKey>> byCategoryPrice;
+    std::set<PriceKey> byPrice;
+
+    // Names that were never interned have no products.
+    static bool lookup(std::string_view name, std::uint32_t& code) {
+        Symbol symbol;
+        if (!Symbol::find(name, symbol))
+            return false;
+        code = symbol.code();
+        return true;
+    }
+
+    void unlink(const std::string& id, const Entry& entry) {
+        byCategory[entry.category].erase(id);
+        bySubcategory[entry.subcategory].erase(id);
+        byCategoryPrice[entry.category].erase(PriceKey(entry.price, id));
+        byPrice.erase(PriceKey(entry.price, id));
+    }
+
+    void link(const std::string& id, const Entry& entry) {
+        byCategory[entry.category].insert(id);
+        bySubcategory[entry.subcategory].insert(id);
+        byCategoryPrice[entry.category].insert(PriceKey(entry.price, id));
+        byPrice.insert(PriceKey(entry.price, id));
+    }
+
+    template <typename Visit>
+    static void visitPriceRange(const std::set<PriceKey>& prices, Money minPrice, Money maxPrice,
+                                const Visit& visit) {
+        for (auto it = prices.lower_bound(PriceKey(minPrice, std::string()));
+             it != prices.end() && it->first <= maxPrice; ++it)
+            visit(it->second);
+    }
+
+public:
+    // Adds or refreshes one product. Quantity-only changes are a no-op.
+    void upsert(const Product& product) {
+        Entry entry{product.category.code(), product.subcategory.code(), product.price};
+        auto it = entries.find(product.id);
+        if (it != entries.end()) {
+            const Entry& old = it->second;
+            if (old.category == entry.category && old.subcategory == entry.subcategory &&
+                old.price == entry.price)
+                return;
+            unlink(product.id, old);
+            it->second = entry;
+        } else {
+            entries.emplace(product.id, entry);
+        }
+        link(product.id, entry);
+    }
+
+    void erase(const std::string& id) {
+        auto it = entries.find(id);
+        if (it == entries.end())
+            return;
+        unlink(id, it->second);
+        entries.erase(it);
+    }
+
+    void clear() {
+        entries.clear();
+        byCategory.clear();
+        bySubcategory.clear();
+        byCategoryPrice.clear();
+        byPrice.clear();
+    }
+
+    std::size_t size() const { return entries.size(); }
+
+    // visit(const std::string& id) for every product in `category`, by id.
+    template <typename Visit>
+    void forEachInCategory(std::string_view category, const Visit& visit) const {
+        std::uint32_t code;
+        if (!lookup(category, code))
+            return;
+        auto it = byCategory.find(code);
+        if (it == byCategory.end())
+            return;
+        for (const auto& id : it->second)
+            visit(id);
+    }
+
+    // Products in `subcategory`, optionally restricted to `category` (empty = any).
+    template <typename Visit>
+    void forEachInSubcategory(std::string_view category, std::string_view subcategory,
+                              const Visit& visit) const {
+        std::uint32_t subCode, catCode = 0;
+        if (!lookup(subcategory, subCode) || (!category.empty() && !lookup(category, catCode)))
+            return;
+        auto it = bySubcategory.find(subCode);
+        if (it == bySubcategory.end())
+            return;
+        for (const auto& id : it->second) {
+            if (category.empty() || entries.at(id).category == catCode)
+                visit(id);
+        }
+    }
+
+    // Products priced within [minPrice, maxPrice], cheapest first, optionally
+    // restricted to `category` (empty = any).
+    template <typename Visit>
+    void forEachInPriceRange(std::string_view category, Money minPrice, Money maxPrice,
+                             const Visit& visit) const {
+        if (category.empty()) {
+            visitPriceRange(byPrice, minPrice, maxPrice, visit);
+            return;
+        }
+        std::uint32_t code;
+        if (!lookup(category, code))
+            return;
+        auto it = byCategoryPrice.find(code);
+        if (it != byCategoryPrice.end())
+            visitPriceRange(it->second, minPrice, maxPrice, visit);
+    }
+};
+
+#endif
@@ -0,0 +1,385 @@
+// ProductSnapshot.h
+#ifndef PRODUCTSNAPSHOT_H
+#define PRODUCTSNAPSHOT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "AtomicFile.h"
+#include "MappedFile.h"
+#include "Money.h"
+#include "Product.h"
+
+// Binary columnar snapshot of the product catalog (products.bin).
+//
+// The file is a ProductSnapshotHeader followed by these sections, each
+// starting on an 8-byte boundary:
+//   IdOffsets    uint32[rows + 1]  byte offsets into IdBytes
+//   IdBytes
+//   NameOffsets  uint32[rows + 1]
+//   NameBytes
+//   Category     uint32[rows]      codes into the file's string dictionary
+//   Subcategory  uint32[rows]
+//   Price        int64[rows]       Money, in minor units
+//   Quantity     int32[rows]
+//   DictOffsets  uint32[dictCount + 1]
+//   DictBytes
+// Rows are sorted by id, so a mapped snapshot can feed an index's
+// buildFromSorted directly. The dictionary belongs to the file: its codes
+// are translated to StringPool symbols once, when the snapshot is opened. Integers are stored in host byte order; the
+// magic doubles as an endianness check. Version 1 stored prices as
+// doubles; such a file is not opened, and the catalog loads from
+// products.txt instead.
+static_assert(sizeof(Money) == sizeof(std::int64_t) && std::is_trivially_copyable<Money>::value,
+              "Money is stored as its minor units");
+
+namespace ProductSnapshotFormat {
+constexpr char MAGIC[4] = {'W', 'H', 'P', 'S'};
+constexpr std::uint32_t VERSION = 2;
+
+enum Section {
+    IdOffsets,
+    IdBytes,
+    NameOffsets,
+    NameBytes,
+    Category,
+    Subcategory,
+    Price,
+    Quantity,
+    DictOffsets,
+    DictBytes,
+    SectionCount
+};
+} // namespace ProductSnapshotFormat
+
+struct ProductSnapshotHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t rowCount;
+    std::uint64_t dictCount;
+    std::uint64_t fileSize;
+    std::uint64_t sectionOffset[ProductSnapshotFormat::SectionCount];
+};
+
+// Read-only, memory-mapped view of a products.bin file.
+class ProductSnapshot {
+private:
+    MappedFile file;
+    const ProductSnapshotHeader* header;
+    const std::uint32_t* idOffsets;
+    const char* idBytes;
+    const std::uint32_t* nameOffsets;
+    const char* nameBytes;
+    const std::uint32_t* categories;
+    const std::uint32_t* subcategories;
+    const Money* prices;
+    const std::int32_t* quantities;
+    const std::uint32_t* dictOffsets;
+    const char* dictBytes;
+    std::vector<Symbol> symbols; // dictionary code -> interned symbol
+
+    template <typename T>
+    const T* section(ProductSnapshotFormat::Section s) const {
+        return reinterpret_cast<const T*>(file.data() + header->sectionOffset[s]);
+    }
+
+    // Offsets must be non-decreasing and stay inside their byte section.
+    static bool validOffsets(const std::uint32_t* offsets, std::uint64_t count, std::uint64_t limit) {
+        if (offsets[0] != 0)
+            return false;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            if (offsets[i + 1] < offsets[i])
+                return false;
+        }
+        return offsets[count] <= limit;
+    }
+
+    bool validate() const {
+        using namespace ProductSnapshotFormat;
+        const std::uint64_t rows = header->rowCount, dict = header->dictCount;
+        const std::uint64_t sizes[SectionCount] = {
+            (rows + 1) * 4, 0, (rows + 1) * 4, 0, rows * 4, rows * 4, rows * 8, rows * 4,
+            (dict + 1) * 4, 0};
+        for (int s = 0; s < SectionCount; ++s) {
+            std::uint64_t begin = header->sectionOffset[s];
+            std::uint64_t end = s + 1 < SectionCount ? header->sectionOffset[s + 1] : header->fileSize;
+            if (begin % 8 != 0 || begin < sizeof(ProductSnapshotHeader) || end < begin ||
+                end > header->fileSize || end - begin < sizes[s])
+                return false;
+        }
+        if (!validOffsets(idOffsets, rows, header->sectionOffset[NameOffsets] - header->sectionOffset[IdBytes]) ||
+            !validOffsets(nameOffsets, rows, header->sectionOffset[Category] - header->sectionOffset[NameBytes]) ||
+            !validOffsets(dictOffsets, dict, header->fileSize - header->sectionOffset[DictBytes]))
+            return false;
+        for (std::uint64_t i = 0; i < rows; ++i) {
+            if (categories[i] >= dict || subcategories[i] >= dict)
+                return false;
+        }
+        return true;
+    }
+
+public:
+    ProductSnapshot() : header(nullptr) {}
+
+    bool open(const std::string& path) {
+        using namespace ProductSnapshotFormat;
+        header = nullptr;
+        if (!file.open(path))
+            return false;
+        if (file.size() < sizeof(ProductSnapshotHeader)) {
+            std::cerr << "Error: " << path << " is too small to be a product snapshot" << std::endl;
+            return false;
+        }
+        const auto* h = reinterpret_cast<const ProductSnapshotHeader*>(file.data());
+        if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0 && h->version < VERSION) {
+            std::cerr << "Warning: " << path << " is an older product snapshot (version " << h->version
+                      << "); it is replaced on the next save" << std::endl;
+            return false;
+        }
+        if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 || h->version != VERSION ||
+            h->fileSize != file.size()) {
+            std::cerr << "Error: " << path << " is not a version " << VERSION
+                      << " product snapshot" << std::endl;
+            return false;
+        }
+        header = h;
+        idOffsets = section<std::uint32_t>(IdOffsets);
+        idBytes = section<char>(IdBytes);
+        nameOffsets = section<std::uint32_t>(NameOffsets);
+        nameBytes = section<char>(NameBytes);
+        categories = section<std::uint32_t>(Category);
+        subcategories = section<std::uint32_t>(Subcategory);
+        prices = section<Money>(Price);
+        quantities = section<std::int32_t>(Quantity);
+        dictOffsets = section<std::uint32_t>(DictOffsets);
+        dictBytes = section<char>(DictBytes);
+        if (!validate()) {
+            std::cerr << "Error: " << path << " is corrupt" << std::endl;
+            header = nullptr;
+            file.close();
+            return false;
+        }
+        symbols.clear();
+        symbols.reserve(header->dictCount);
+        for (std::uint64_t code = 0; code < header->dictCount; ++code)
+            symbols.emplace_back(dictionaryEntry(static_cast<std::uint32_t>(code)));
+        return true;
+    }
+
+    bool isOpen() const { return header != nullptr; }
+    std::size_t size() const { return header ? static_cast<std::size_t>(header->rowCount) : 0; }
+    std::size_t dictionarySize() const { return header ? static_cast<std::size_t>(header->dictCount) : 0; }
+
+    std::string_view id(std::size_t row) const {
+        return std::string_view(idBytes + idOffsets[row], idOffsets[row + 1] - idOffsets[row]);
+    }
+    std::string_view name(std::size_t row) const {
+        return std::string_view(nameBytes + nameOffsets[row], nameOffsets[row + 1] - nameOffsets[row]);
+    }
+    std::string_view dictionaryEntry(std::uint32_t code) const {
+        return std::string_view(dictBytes + dictOffsets[code], dictOffsets[code + 1] - dictOffsets[code]);
+    }
+    std::uint32_t categoryCode(std::size_t row) const { return categories[row]; }
+    std::uint32_t subcategoryCode(std::size_t row) const { return subcategories[row]; }
+    std::string_view category(std::size_t row) const { return dictionaryEntry(categories[row]); }
+    std::string_view subcategory(std::size_t row) const { return dictionaryEntry(subcategories[row]); }
+    Money price(std::size_t row) const { return prices[row]; }
+    int quantity(std::size_t row) const { return quantities[row]; }
+
+    Symbol categorySymbol(std::size_t row) const { return symbols[categories[row]]; }
+    Symbol subcategorySymbol(std::size_t row) const { return symbols[subcategories[row]]; }
+
+    Product product(std::size_t row) const {
+        return Product(std::string(id(row)), std::string(name(row)), categorySymbol(row),
+                       subcategorySymbol(row), price(row), quantity(row));
+    }
+};
+
+namespace ProductSnapshotDetail {
+// Streams sections to the output file while tracking the byte position.
+class SectionWriter {
+private:
+    std::ofstream& out;
+    std::uint64_t pos;
+
+public:
+    explicit SectionWriter(std::ofstream& _out, std::uint64_t start) : out(_out), pos(start) {}
+
+    void write(const void* data, std::size_t len) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(len));
+        pos += len;
+    }
+
+    template <typename T>
+    void put(const T& value) { write(&value, sizeof(T)); }
+
+    void align8() {
+        static const char zeros[8] = {};
+        write(zeros, (8 - pos % 8) % 8);
+    }
+
+    std::uint64_t position() const { return pos; }
+};
+
+// Writes an offsets array followed by the concatenated strings, making one
+// pass over the rows for each.
+template <typename ForEachString>
+inline bool writeStrings(SectionWriter& out, std::uint64_t* offsetSection, std::uint64_t* bytesSection,
+                         const ForEachString& forEachString) {
+    out.align8();
+    *offsetSection = out.position();
+    std::uint64_t total = 0;
+    out.put(std::uint32_t(0));
+    forEachString([&](const std::string& s) {
+        total += s.size();
+        out.put(static_cast<std::uint32_t>(total));
+    });
+    if (total > UINT32_MAX)
+        return false;
+    out.align8();
+    *bytesSection = out.position();
+    forEachString([&](const std::string& s) { out.write(s.data(), s.size()); });
+    return true;
+}
+} // namespace ProductSnapshotDetail
+
+// Writes a catalog of `rows` products as a snapshot. forEachProduct(visit)
+// must call visit(const Product&) for every product in id order; it is run
+// once per column, so the catalog is never copied or buffered. The file is
+// written next to `path`, fsynced and renamed into place (replaceFile), so
+// neither readers nor a crash ever see a partial snapshot.
+template <typename ForEachProduct>
+inline bool writeProductSnapshot(const std::string& path, std::size_t rows,
+                                 const ForEachProduct& forEachProduct) {
+    using namespace ProductSnapshotFormat;
+    using namespace ProductSnapshotDetail;
+    // File codes are dense over the symbols this catalog uses, in order of
+    // first use.
+    std::vector<Symbol> dictionary;
+    std::unordered_map<std::uint32_t, std::uint32_t> codes; // symbol code -> file code
+    auto intern = [&](Symbol s) {
+        auto it = codes.find(s.code());
+        if (it != codes.end())
+            return it->second;
+        std::uint32_t code = static_cast<std::uint32_t>(dictionary.size());
+        dictionary.push_back(s);
+        codes.emplace(s.code(), code);
+        return code;
+    };
+    auto column = [&](std::string Product::*field) {
+        return [&forEachProduct, field](const auto& visit) {
+            forEachProduct([&](const Product& p) { visit(p.*field); });
+        };
+    };
+
+    ProductSnapshotHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.rowCount = rows;
+
+    const std::string tempPath = path + ".tmp";
+    std::ofstream ofs(tempPath, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "Error saving product snapshot to " << tempPath << std::endl;
+        return false;
+    }
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header)); // rewritten below
+    SectionWriter out(ofs, sizeof(header));
+    if (!writeStrings(out, &header.sectionOffset[IdOffsets], &header.sectionOffset[IdBytes],
+                      column(&Product::id)) ||
+        !writeStrings(out, &header.sectionOffset[NameOffsets], &header.sectionOffset[NameBytes],
+                      column(&Product::name))) {
+        std::cerr << "Error: product catalog too large for snapshot " << path << std::endl;
+        ofs.close();
+        std::filesystem::remove(tempPath);
+        return false;
+    }
+    out.align8();
+    header.sectionOffset[Category] = out.position();
+    forEachProduct([&](const Product& p) { out.put(intern(p.category)); });
+    out.align8();
+    header.sectionOffset[Subcategory] = out.position();
+    forEachProduct([&](const Product& p) { out.put(intern(p.subcategory)); });
+    out.align8();
+    header.sectionOffset[Price] = out.position();
+    forEachProduct([&](const Product& p) { out.put(p.price); });
+    out.align8();
+    header.sectionOffset[Quantity] = out.position();
+    forEachProduct([&](const Product& p) { out.put(static_cast<std::int32_t>(p.quantity)); });
+    header.dictCount = dictionary.size();
+    writeStrings(out, &header.sectionOffset[DictOffsets], &header.sectionOffset[DictBytes],
+                 [&](const auto& visit) {
+                     for (Symbol entry : dictionary)
+                         visit(entry.str());
+                 });
+    header.fileSize = out.position();
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.close();
+    if (!ofs || !replaceFile(tempPath, path)) {
+        std::cerr << "Error saving product snapshot to " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Converts products.txt-style CSV into a snapshot. Later duplicates of an id
+// win, matching what repeated ProductAVLTree::insert calls would keep.
+inline bool convertProductsCsvToSnapshot(const std::string& csvPath, const std::string& snapshotPath) {
+    MappedFile file;
+    if (!file.open(csvPath)) {
+        std::cerr << "Error: cannot open " << csvPath << std::endl;
+        return false;
+    }
+    std::vector<Product> products;
+    CsvTokenizer tokenizer(std::string_view(file.data(), file.size()));
+    CsvRow row;
+    Product product;
+    while (tokenizer.next(row)) {
+        if (Product::fromRow(row, product))
+            products.push_back(product);
+        else
+            std::cerr << "Warning: skipping " << csvPath << " line " << row.line() << std::endl;
+    }
+    if (!tokenizer.error().empty()) {
+        std::cerr << "Error: " << csvPath << " " << tokenizer.error() << std::endl;
+        return false;
+    }
+    std::stable_sort(products.begin(), products.end());
+    std::vector<Product> unique;
+    unique.reserve(products.size());
+    for (auto& p : products) {
+        if (!unique.empty() && unique.back().id == p.id)
+            unique.back() = std::move(p);
+        else
+            unique.push_back(std::move(p));
+    }
+    return writeProductSnapshot(snapshotPath, unique.size(), [&](const auto& visit) {
+        for (const auto& p : unique)
+            visit(p);
+    });
+}
+
+inline bool convertProductsSnapshotToCsv(const std::string& snapshotPath, const std::string& csvPath) {
+    ProductSnapshot snapshot;
+    if (!snapshot.open(snapshotPath))
+        return false;
+    std::ofstream ofs(csvPath);
+    if (!ofs.is_open()) {
+        std::cerr << "Error: cannot write " << csvPath << std::endl;
+        return false;
+    }
+    for (std::size_t row = 0; row < snapshot.size(); ++row)
+        ofs << snapshot.product(row).toCsv() << "\n";
+    return static_cast<bool>(ofs);
+}
+
+#endif
@@ -0,0 +1,456 @@
+// SalesAggregator.h
+#ifndef SALESAGGREGATOR_H
+#define SALESAGGREGATOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "AtomicFile.h"
+#include "CsvTokenizer.h"
+#include "CustomHashTable.h"
+#include "FenwickTree.h"
+#include "MappedFile.h"
+#include "Money.h"
+#include "Order.h"
+#include "StringPool.h"
+
+// Revenue is exact, so a range answered as the difference of two prefix
+// sums matches adding up its days.
+struct SalesTotals {
+    Money revenue;
+    std::uint64_t orders = 0;
+    std::uint64_t units = 0;
+
+    SalesTotals& operator+=(const SalesTotals& other) {
+        revenue += other.revenue;
+        orders += other.orders;
+        units += other.units;
+        return *this;
+    }
+
+    SalesTotals& operator-=(const SalesTotals& other) {
+        revenue -= other.revenue;
+        orders -= other.orders;
+        units -= other.units;
+        return *this;
+    }
+};
+
+// Incremental sales rollups fed one order at a time.
+// Totals are kept per day in dense arrays, one series for all sales plus
+// one per category and per payment method, each with a Fenwick tree so any
+// date range is answered in O(log days). Month and year rollups are hash
+// lookups, and per-product totals are kept per month. Recording an order
+// costs O(items + log days).
+//
+// The aggregator counts the orders it has seen. A saved snapshot carries
+// that count, so a restart only replays the orders placed after it, and
+// clear() followed by a full replay rebuilds the same state.
+class SalesAggregator {
+private:
+    struct DailySeries {
+        std::vector<SalesTotals> days;
+        FenwickTree<SalesTotals> sums;
+    };
+
+    static constexpr const char* ALL = "*";
+
+    std::int32_t baseDay;
+    std::size_t span;
+    CustomHashTable<std::string, std::uint32_t> seriesIndex; // "*", "c:<category>", "p:<payment>"
+    std::vector<std::string> seriesKeys;
+    std::vector<DailySeries> series;
+    // Symbol code -> series index, so recording an order builds no keys.
+    CustomHashTable<std::uint32_t, std::uint32_t> categorySeries;
+    CustomHashTable<std::uint32_t, std::uint32_t> paymentSeries;
+    CustomHashTable<std::uint32_t, SalesTotals> months; // yyyymm
+    CustomHashTable<std::uint32_t, SalesTotals> years;
+    std::unordered_map<std::uint32_t, CustomHashTable<std::string, SalesTotals>> productMonths;
+    std::uint64_t recorded;
+
+    std::uint32_t seriesNumber(const std::string& key) {
+        if (const std::uint32_t* index = seriesIndex.find(key))
+            return *index;
+        const std::uint32_t index = static_cast<std::uint32_t>(series.size());
+        seriesIndex.insert(key, index);
+        seriesKeys.push_back(key);
+        series.emplace_back();
+        series.back().days.resize(span);
+        series.back().sums = FenwickTree<SalesTotals>(span);
+        return index;
+    }
+
+    DailySeries& seriesFor(const std::string& key) { return series[seriesNumber(key)]; }
+
+    // The series keyed "<prefix>:<name>", found through `cache`.
+    DailySeries& seriesFor(CustomHashTable<std::uint32_t, std::uint32_t>& cache, char prefix, Symbol name) {
+        if (const std::uint32_t* index = cache.find(name.code()))
+            return series[*index];
+        const std::uint32_t index = seriesNumber(std::string{prefix, ':'} + name.str());
+        cache.insert(name.code(), index);
+        return series[index];
+    }
+
+    // Re-bases the dense arrays so `day` has a slot. Growth doubles, so it
+    // is amortized O(1) per day of history.
+    void ensureDay(std::int32_t day) {
+        if (span == 0) {
+            baseDay = day;
+            span = 64;
+        } else if (day >= baseDay && day < baseDay + static_cast<std::int32_t>(span)) {
+            return;
+        }
+        std::int32_t first = std::min(baseDay, day);
+        std::int32_t last = std::max(baseDay + static_cast<std::int32_t>(span) - 1, day);
+        std::size_t needed = static_cast<std::size_t>(last - first) + 1;
+        std::size_t newSpan = std::max<std::size_t>(span, 64);
+        while (newSpan < needed)
+            newSpan *= 2;
+        // Leave the slack on the side that grew.
+        std::int32_t newBase = day < baseDay ? last - static_cast<std::int32_t>(newSpan) + 1 : first;
+        for (DailySeries& s : series) {
+            std::vector<SalesTotals> moved(newSpan);
+            for (std::size_t i = 0; i < s.days.size(); ++i) {
+                std::int32_t d = baseDay + static_cast<std::int32_t>(i);
+                if (d >= newBase && d < newBase + static_cast<std::int32_t>(newSpan))
+                    moved[static_cast<std::size_t>(d - newBase)] = s.days[i];
+            }
+            s.days.swap(moved);
+            s.sums.build(s.days);
+        }
+        baseDay = newBase;
+        span = newSpan;
+    }
+
+    void addDay(DailySeries& s, std::size_t index, const SalesTotals& delta) {
+        s.days[index] += delta;
+        s.sums.add(index, delta);
+    }
+
+    static void addTo(CustomHashTable<std::uint32_t, SalesTotals>& table, std::uint32_t key,
+                      const SalesTotals& delta) {
+        if (SalesTotals* existing = table.find(key)) {
+            *existing += delta;
+        } else {
+            table.insert(key, delta);
+        }
+    }
+
+    static void addTo(CustomHashTable<std::string, SalesTotals>& table, const std::string& key,
+                      const SalesTotals& delta) {
+        if (SalesTotals* existing = table.find(key)) {
+            *existing += delta;
+        } else {
+            table.insert(key, delta);
+        }
+    }
+
+    template <typename Key>
+    static void addTo(std::vector<std::pair<Key, SalesTotals>>& totals, const Key& key, const SalesTotals& delta) {
+        for (auto& entry : totals) {
+            if (entry.first == key) {
+                entry.second += delta;
+                return;
+            }
+        }
+        totals.push_back({key, delta});
+    }
+
+    // Month and year rollups follow from the "all sales" series.
+    void rebuildCalendarRollups() {
+        months.clear();
+        years.clear();
+        const std::uint32_t* all = seriesIndex.find(ALL);
+        if (!all)
+            return;
+        const DailySeries& s = series[*all];
+        for (std::size_t i = 0; i < s.days.size(); ++i) {
+            if (s.days[i].orders == 0)
+                continue;
+            int y, m, d;
+            civilFromDays(baseDay + static_cast<std::int32_t>(i), y, m, d);
+            addTo(months, static_cast<std::uint32_t>(y * 100 + m), s.days[i]);
+            addTo(years, static_cast<std::uint32_t>(y), s.days[i]);
+        }
+    }
+
+    template <typename Visit>
+    void forEachSeries(char kind, std::int32_t fromDay, std::int32_t toDay, const Visit& visit) const {
+        for (std::size_t i = 0; i < series.size(); ++i) {
+            if (seriesKeys[i].size() < 2 || seriesKeys[i][0] != kind || seriesKeys[i][1] != ':')
+                continue;
+            SalesTotals totals = rangeOf(series[i], fromDay, toDay);
+            if (totals.orders > 0)
+                visit(seriesKeys[i].substr(2), totals);
+        }
+    }
+
+    SalesTotals rangeOf(const DailySeries& s, std::int32_t fromDay, std::int32_t toDay) const {
+        std::int32_t last = baseDay + static_cast<std::int32_t>(span) - 1;
+        fromDay = std::max(fromDay, baseDay);
+        toDay = std::min(toDay, last);
+        if (span == 0 || fromDay > toDay)
+            return SalesTotals();
+        return s.sums.range(static_cast<std::size_t>(fromDay - baseDay),
+                            static_cast<std::size_t>(toDay - baseDay) + 1);
+    }
+
+    static std::string formatDay(std::int32_t day) {
+        int y, m, d;
+        civilFromDays(day, y, m, d);
+        char text[40];
+        std::snprintf(text, sizeof(text), "%04d-%02d-%02d", y, m, d);
+        return text;
+    }
+
+public:
+    SalesAggregator()
+        : baseDay(0), span(0), seriesIndex(16), categorySeries(16), paymentSeries(16), months(64), years(16),
+          recorded(0) {}
+
+    // Days since 1970-01-01 for a proleptic Gregorian date.
+    static std::int32_t dayNumber(int y, int m, int d) {
+        y -= m <= 2;
+        const int era = (y >= 0 ? y : y - 399) / 400;
+        const int yoe = y - era * 400;
+        const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    static void civilFromDays(std::int32_t z, int& y, int& m, int& d) {
+        z += 719468;
+        const int era = (z >= 0 ? z : z - 146096) / 146097;
+        const int doe = z - era * 146097;
+        const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const int mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = yoe + era * 400 + (m <= 2);
+    }
+
+    // Reads the date at the start of "YYYY-MM-DD[ HH:MM:SS]".
+    static bool parseDate(std::string_view text, int& y, int& m, int& d) {
+        if (text.size() < 10 || text[4] != '-' || text[7] != '-')
+            return false;
+        auto digits = [&](std::size_t pos, std::size_t len, int& out) {
+            out = 0;
+            for (std::size_t i = pos; i < pos + len; ++i) {
+                if (text[i] < '0' || text[i] > '9')
+                    return false;
+                out = out * 10 + (text[i] - '0');
+            }
+            return true;
+        };
+        return digits(0, 4, y) && digits(5, 2, m) && digits(8, 2, d) && m >= 1 && m <= 12 &&
+               d >= 1 && d <= 31;
+    }
+
+    // Whether `day` is within the range kept in the day arrays: 1970-01-01
+    // to a year from today. The arrays are dense, so a single order dated
+    // 0001-01-01 would otherwise size every series for two millennia.
+    static bool inWindow(std::int32_t day) {
+        const std::int32_t today = static_cast<std::int32_t>(std::time(nullptr) / 86400);
+        return day >= 0 && day <= today + 366;
+    }
+
+    // A "YYYY-MM-DD[ HH:MM:SS]" timestamp that record() will book.
+    static bool inWindow(std::string_view timestamp) {
+        int y, m, d;
+        return parseDate(timestamp, y, m, d) && inWindow(dayNumber(y, m, d));
+    }
+
+    // Adds one order. categoryOf(const std::string& productId) returns the
+    // category Symbol an item's revenue is booked under. Orders dated
+    // outside inWindow() are counted but not booked.
+    template <typename CategoryOf>
+    void record(const Order& order, const CategoryOf& categoryOf) {
+        ++recorded;
+        int y, m, d;
+        if (!parseDate(order.timestamp, y, m, d))
+            return;
+        const std::int32_t day = dayNumber(y, m, d);
+        if (!inWindow(day))
+            return;
+        ensureDay(day);
+        const std::size_t index = static_cast<std::size_t>(day - baseDay);
+
+        SalesTotals orderTotals{order.totalPrice, 1, 0};
+        std::vector<std::pair<Symbol, SalesTotals>> byCategory;
+        std::vector<std::pair<std::string, SalesTotals>> byProduct;
+        for (const OrderItem& item : order.items) {
+            SalesTotals line{item.unitPrice * item.quantity, 0, static_cast<std::uint64_t>(item.quantity)};
+            orderTotals.units += line.units;
+            addTo(byCategory, Symbol(categoryOf(item.productId)), line);
+            addTo(byProduct, item.productId, line);
+        }
+        addDay(seriesFor(ALL), index, orderTotals);
+        addDay(seriesFor(paymentSeries, 'p', order.paymentMethod), index, orderTotals);
+        for (auto& entry : byCategory) {
+            entry.second.orders = 1;
+            addDay(seriesFor(categorySeries, 'c', entry.first), index, entry.second);
+        }
+        const std::uint32_t month = static_cast<std::uint32_t>(y * 100 + m);
+        addTo(months, month, orderTotals);
+        addTo(years, static_cast<std::uint32_t>(y), orderTotals);
+        auto it = productMonths.find(month);
+        if (it == productMonths.end())
+            it = productMonths.emplace(month, CustomHashTable<std::string, SalesTotals>(64)).first;
+        for (auto& entry : byProduct) {
+            entry.second.orders = 1;
+            addTo(it->second, entry.first, entry.second);
+        }
+    }
+
+    void clear() {
+        baseDay = 0;
+        span = 0;
+        seriesIndex.clear();
+        seriesKeys.clear();
+        series.clear();
+        categorySeries.clear();
+        paymentSeries.clear();
+        months.clear();
+        years.clear();
+        productMonths.clear();
+        recorded = 0;
+    }
+
+    // Number of orders recorded; the snapshot's replay watermark.
+    std::uint64_t ordersRecorded() const { return recorded; }
+
+    SalesTotals dayTotals(int y, int m, int d) const {
+        std::int32_t day = dayNumber(y, m, d);
+        return dailyRange(day, day);
+    }
+
+    SalesTotals monthTotals(int y, int m) const {
+        const SalesTotals* totals = months.find(static_cast<std::uint32_t>(y * 100 + m));
+        return totals ? *totals : SalesTotals();
+    }
+
+    SalesTotals yearTotals(int y) const {
+        const SalesTotals* totals = years.find(static_cast<std::uint32_t>(y));
+        return totals ? *totals : SalesTotals();
+    }
+
+    // All sales from fromDay to toDay inclusive (day numbers).
+    SalesTotals dailyRange(std::int32_t fromDay, std::int32_t toDay) const {
+        const std::uint32_t* all = seriesIndex.find(ALL);
+        return all ? rangeOf(series[*all], fromDay, toDay) : SalesTotals();
+    }
+
+    // visit(const std::string& category, const SalesTotals&) over a range.
+    template <typename Visit>
+    void forEachCategory(std::int32_t fromDay, std::int32_t toDay, const Visit& visit) const {
+        forEachSeries('c', fromDay, toDay, visit);
+    }
+
+    // visit(const std::string& paymentMethod, const SalesTotals&) over a range.
+    template <typename Visit>
+    void forEachPaymentMethod(std::int32_t fromDay, std::int32_t toDay, const Visit& visit) const {
+        forEachSeries('p', fromDay, toDay, visit);
+    }
+
+    // visit(const std::string& productId, const SalesTotals&) for one month.
+    template <typename Visit>
+    void forEachProductInMonth(int y, int m, const Visit& visit) const {
+        auto it = productMonths.find(static_cast<std::uint32_t>(y * 100 + m));
+        if (it != productMonths.end())
+            it->second.forEach(visit);
+    }
+
+    // Snapshot lines:
+    //   orders,<recorded>
+    //   D,<yyyy-mm-dd>,<revenue>,<orders>,<units>,<series key>
+    //   P,<yyyymm>,<revenue>,<orders>,<units>,<product id>
+    bool save(const std::string& path) const {
+        bool ok = writeFileAtomically(path, [&](std::ostream& ofs) { write(ofs); });
+        if (!ok)
+            std::cerr << "Error saving to " << path << std::endl;
+        return ok;
+    }
+
+    void write(std::ostream& ofs) const {
+        ofs << "orders," << recorded << "\n";
+        for (std::size_t i = 0; i < series.size(); ++i) {
+            for (std::size_t day = 0; day < series[i].days.size(); ++day) {
+                const SalesTotals& t = series[i].days[day];
+                if (t.orders > 0) {
+                    ofs << "D," << formatDay(baseDay + static_cast<std::int32_t>(day)) << "," << t.revenue
+                        << "," << t.orders << "," << t.units << ",";
+                    writeCsvField(ofs, seriesKeys[i]);
+                    ofs << "\n";
+                }
+            }
+        }
+        for (const auto& month : productMonths) {
+            month.second.forEach([&](const std::string& productId, const SalesTotals& t) {
+                ofs << "P," << month.first << "," << t.revenue << "," << t.orders << "," << t.units << ",";
+                writeCsvField(ofs, productId);
+                ofs << "\n";
+            });
+        }
+    }
+
+    // Replaces the current state with a saved snapshot. Returns false (and
+    // leaves the aggregator empty) if the file is missing or malformed.
+    bool load(const std::string& path) {
+        clear();
+        MappedFile file;
+        if (!file.open(path))
+            return false;
+        CsvTokenizer tokenizer(std::string_view(file.data(), file.size()));
+        CsvRow row;
+        if (!tokenizer.next(row) || row.size() != 2 || row[0] != "orders" || !row.number(1, recorded)) {
+            clear();
+            return false;
+        }
+        while (tokenizer.next(row)) {
+            SalesTotals t;
+            int y, m, d;
+            std::uint32_t month;
+            bool ok = row.size() == 6 && Money::parse(row[2], t.revenue) && row.number(3, t.orders) &&
+                      row.number(4, t.units);
+            // A day outside the window fails the whole snapshot, which is
+            // then rebuilt from the orders without it.
+            if (ok && row[0] == "D" && parseDate(row[1], y, m, d) && inWindow(dayNumber(y, m, d))) {
+                std::int32_t day = dayNumber(y, m, d);
+                ensureDay(day);
+                seriesFor(row.str(5)).days[static_cast<std::size_t>(day - baseDay)] += t;
+            } else if (ok && row[0] == "P" && row.number(1, month)) {
+                auto it = productMonths.find(month);
+                if (it == productMonths.end())
+                    it = productMonths.emplace(month, CustomHashTable<std::string, SalesTotals>(64)).first;
+                addTo(it->second, row.str(5), t);
+            } else {
+                std::cerr << "Warning: ignoring malformed sales snapshot " << path << ", line " << row.line()
+                          << std::endl;
+                clear();
+                return false;
+            }
+        }
+        if (!tokenizer.error().empty()) {
+            std::cerr << "Warning: ignoring malformed sales snapshot " << path << ", " << tokenizer.error()
+                      << std::endl;
+            clear();
+            return false;
+        }
+        for (DailySeries& s : series)
+            s.sums.build(s.days);
+        rebuildCalendarRollups();
+        return true;
+    }
+};
+
+#endif
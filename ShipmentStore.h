@@ -0,0 +1,241 @@
+// ShipmentStore.h
+#ifndef SHIPMENTSTORE_H
+#define SHIPMENTSTORE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "AtomicFile.h"
+#include "CsvTokenizer.h"
+#include "CustomHashTable.h"
+#include "MappedFile.h"
+
+// Shipment lifecycle. A shipment only moves forward, possibly skipping
+// steps (a carrier may report "shipped" for a parcel never marked packed).
+enum class ShipmentStatus : std::uint8_t { InProgress, Packed, Shipped, Delivered };
+
+struct Shipment {
+    std::string orderId, trackingId, customerName, address;
+    ShipmentStatus status = ShipmentStatus::InProgress;
+};
+
+// Outcome counts of one carrier feed.
+struct ShipmentFeedResult {
+    std::size_t applied = 0;   // status moved forward
+    std::size_t unchanged = 0; // already at (or past) that status
+    std::size_t unknown = 0;   // no such tracking id
+    std::size_t malformed = 0; // unreadable line or status
+};
+
+// All shipments keyed by tracking id, with a running count per status so
+// the dashboard never scans. The file form is one CSV line per shipment,
+// "orderId,trackingId,customerName,address,status", rewritten whole by
+// save(); changes in between are carried by the operation log.
+class ShipmentStore {
+public:
+    static constexpr std::size_t STATUS_COUNT = 4;
+
+    enum class Update { Applied, Unchanged, Unknown, Backwards };
+
+private:
+    std::vector<Shipment> shipments;
+    CustomHashTable<std::string, std::uint32_t> byTrackingId;
+    std::array<std::size_t, STATUS_COUNT> counts{};
+
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size())
+            return false;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            char x = a[i] >= 'A' && a[i] <= 'Z' ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+            if (x != b[i])
+                return false;
+        }
+        return true;
+    }
+
+    static std::string_view trim(std::string_view text) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+            text.remove_suffix(1);
+        return text;
+    }
+
+public:
+    ShipmentStore() : byTrackingId(1024) {}
+
+    static const char* statusName(ShipmentStatus status) {
+        switch (status) {
+        case ShipmentStatus::InProgress: return "in progress";
+        case ShipmentStatus::Packed: return "packed";
+        case ShipmentStatus::Shipped: return "shipped";
+        case ShipmentStatus::Delivered: return "delivered";
+        }
+        return "";
+    }
+
+    // Accepts the names above in any case, with '_' or '-' for the space.
+    static bool parseStatus(std::string_view text, ShipmentStatus& status) {
+        text = trim(text);
+        if (equalsIgnoreCase(text, "in progress") || equalsIgnoreCase(text, "in_progress") ||
+            equalsIgnoreCase(text, "in-progress")) {
+            status = ShipmentStatus::InProgress;
+        } else if (equalsIgnoreCase(text, "packed")) {
+            status = ShipmentStatus::Packed;
+        } else if (equalsIgnoreCase(text, "shipped")) {
+            status = ShipmentStatus::Shipped;
+        } else if (equalsIgnoreCase(text, "delivered")) {
+            status = ShipmentStatus::Delivered;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Fills `shipment` from a tokenized file record. The status is the last
+    // field; lines written before fields were quoted may hold an unquoted
+    // comma in the address, so any fields between the name and the status
+    // are joined back into it.
+    static bool fromRow(const CsvRow& row, Shipment& shipment) {
+        if (row.size() < 5 || row[1].empty() || !parseStatus(row[row.size() - 1], shipment.status))
+            return false;
+        shipment.orderId.assign(row[0]);
+        shipment.trackingId.assign(row[1]);
+        shipment.customerName.assign(row[2]);
+        shipment.address.assign(row[3]);
+        for (std::size_t i = 4; i + 1 < row.size(); ++i) {
+            shipment.address += ',';
+            shipment.address.append(row[i]);
+        }
+        return true;
+    }
+
+    static bool parseLine(std::string_view line, Shipment& shipment) {
+        CsvRow row;
+        return CsvTokenizer::splitLine(line, row) && fromRow(row, shipment);
+    }
+
+    static std::string toLine(const Shipment& shipment) {
+        std::string line;
+        for (const std::string* field : {&shipment.orderId, &shipment.trackingId, &shipment.customerName,
+                                         &shipment.address}) {
+            appendCsvField(line, *field);
+            line += ',';
+        }
+        return line + statusName(shipment.status);
+    }
+
+    // Returns false if the tracking id is already known.
+    bool add(const Shipment& shipment) {
+        if (byTrackingId.find(shipment.trackingId))
+            return false;
+        byTrackingId.insert(shipment.trackingId, static_cast<std::uint32_t>(shipments.size()));
+        shipments.push_back(shipment);
+        ++counts[static_cast<std::size_t>(shipment.status)];
+        return true;
+    }
+
+    const Shipment* find(std::string_view trackingId) const {
+        const std::uint32_t* index = byTrackingId.find(trackingId);
+        return index ? &shipments[*index] : nullptr;
+    }
+
+    // O(1). Moving to the current status is Unchanged, so replaying an
+    // update or a whole feed twice is harmless.
+    Update advance(std::string_view trackingId, ShipmentStatus status) {
+        const std::uint32_t* index = byTrackingId.find(trackingId);
+        if (!index)
+            return Update::Unknown;
+        Shipment& shipment = shipments[*index];
+        if (status == shipment.status)
+            return Update::Unchanged;
+        if (status < shipment.status)
+            return Update::Backwards;
+        --counts[static_cast<std::size_t>(shipment.status)];
+        ++counts[static_cast<std::size_t>(status)];
+        shipment.status = status;
+        return Update::Applied;
+    }
+
+    // Applies a carrier feed of "trackingId,status" lines, parsed in place.
+    ShipmentFeedResult applyFeed(std::string_view feed) {
+        ShipmentFeedResult result;
+        CsvTokenizer tokenizer(feed);
+        CsvRow row;
+        while (tokenizer.next(row)) {
+            ShipmentStatus status;
+            if (row.size() != 2 || !parseStatus(row[1], status)) {
+                if (row.size() != 1 || !trim(row[0]).empty())
+                    ++result.malformed;
+                continue;
+            }
+            std::string_view trackingId = trim(row[0]);
+            switch (advance(trackingId, status)) {
+            case Update::Applied:
+                ++result.applied;
+                break;
+            case Update::Unknown:
+                ++result.unknown;
+                break;
+            default:
+                ++result.unchanged;
+                break;
+            }
+        }
+        if (!tokenizer.error().empty())
+            ++result.malformed; // the scan stops at an unterminated quote
+        return result;
+    }
+
+    std::size_t count(ShipmentStatus status) const { return counts[static_cast<std::size_t>(status)]; }
+    std::size_t size() const { return shipments.size(); }
+
+    bool load(const std::string& path) {
+        MappedFile file;
+        if (!file.open(path))
+            return false;
+        CsvTokenizer tokenizer(std::string_view(file.data(), file.size()));
+        CsvRow row;
+        std::size_t skipped = 0;
+        Shipment shipment;
+        while (tokenizer.next(row)) {
+            if (fromRow(row, shipment))
+                add(shipment);
+            else
+                ++skipped;
+        }
+        if (!tokenizer.error().empty())
+            std::cerr << "Warning: " << path << " " << tokenizer.error() << std::endl;
+        if (skipped > 0)
+            std::cerr << "Warning: skipped " << skipped << " unreadable lines in " << path << std::endl;
+        return true;
+    }
+
+    // Rewrites the file through a temporary, so a crash leaves the old or
+    // the new version.
+    bool save(const std::string& path) const {
+        bool ok = writeFileAtomically(
+            path,
+            [&](std::ostream& out) {
+                std::string line;
+                for (const Shipment& shipment : shipments) {
+                    line = toLine(shipment);
+                    line += '\n';
+                    out.write(line.data(), static_cast<std::streamsize>(line.size()));
+                }
+            },
+            std::ios::binary);
+        if (!ok)
+            std::cerr << "Error saving to " << path << std::endl;
+        return ok;
+    }
+};
+
+#endif
@@ -0,0 +1,168 @@
+// SmallVector.h
+#ifndef SMALLVECTOR_H
+#define SMALLVECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Vector that keeps its first N elements inside the object and only moves
+// to the heap past that, so the common short list (an order's or a cart's
+// lines) costs no allocation and sits next to the rest of its owner.
+// Elements stay contiguous either way; growing invalidates pointers as
+// std::vector does.
+template <typename T, std::size_t N>
+class SmallVector {
+private:
+    alignas(T) unsigned char inlineStorage[N * sizeof(T)];
+    T* elements;
+    std::size_t count;
+    std::size_t capacityCount;
+
+    T* inlineElements() { return std::launder(reinterpret_cast<T*>(inlineStorage)); }
+    bool isInline() const { return elements == reinterpret_cast<const T*>(inlineStorage); }
+
+    void destroyAll() {
+        std::destroy_n(elements, count);
+        count = 0;
+    }
+
+    void release() {
+        destroyAll();
+        if (!isInline())
+            ::operator delete(elements);
+        elements = inlineElements();
+        capacityCount = N;
+    }
+
+    void grow(std::size_t minimum) {
+        std::size_t newCapacity = std::max(minimum, capacityCount * 2);
+        T* moved = static_cast<T*>(::operator new(newCapacity * sizeof(T)));
+        std::uninitialized_move_n(elements, count, moved);
+        std::destroy_n(elements, count);
+        if (!isInline())
+            ::operator delete(elements);
+        elements = moved;
+        capacityCount = newCapacity;
+    }
+
+    // Takes other's elements: its heap block if it has one, otherwise a
+    // move of each inline element. Leaves `other` empty. *this must be empty
+    // and inline.
+    void steal(SmallVector& other) {
+        if (other.isInline()) {
+            std::uninitialized_move_n(other.elements, other.count, elements);
+            count = other.count;
+            other.destroyAll();
+            return;
+        }
+        elements = other.elements;
+        count = other.count;
+        capacityCount = other.capacityCount;
+        other.elements = other.inlineElements();
+        other.count = 0;
+        other.capacityCount = N;
+    }
+
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    SmallVector() : elements(inlineElements()), count(0), capacityCount(N) {}
+
+    SmallVector(std::initializer_list<T> values) : SmallVector() {
+        reserve(values.size());
+        for (const T& value : values)
+            push_back(value);
+    }
+
+    SmallVector(const SmallVector& other) : SmallVector() {
+        reserve(other.count);
+        std::uninitialized_copy_n(other.elements, other.count, elements);
+        count = other.count;
+    }
+
+    SmallVector(SmallVector&& other) noexcept : SmallVector() { steal(other); }
+
+    ~SmallVector() { release(); }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            destroyAll();
+            reserve(other.count);
+            std::uninitialized_copy_n(other.elements, other.count, elements);
+            count = other.count;
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    void reserve(std::size_t wanted) {
+        if (wanted > capacityCount)
+            grow(wanted);
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (count == capacityCount)
+            grow(count + 1);
+        T* slot = ::new (static_cast<void*>(elements + count)) T(std::forward<Args>(args)...);
+        ++count;
+        return *slot;
+    }
+
+    void push_back(const T& value) {
+        if (count == capacityCount) { // `value` may live in the old block
+            T copy(value);
+            emplace_back(std::move(copy));
+            return;
+        }
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    void pop_back() {
+        std::destroy_at(elements + --count);
+    }
+
+    iterator erase(iterator position) {
+        std::move(position + 1, end(), position);
+        pop_back();
+        return position;
+    }
+
+    void clear() { destroyAll(); }
+
+    T& operator[](std::size_t i) { return elements[i]; }
+    const T& operator[](std::size_t i) const { return elements[i]; }
+    T& back() { return elements[count - 1]; }
+    const T& back() const { return elements[count - 1]; }
+
+    iterator begin() { return elements; }
+    iterator end() { return elements + count; }
+    const_iterator begin() const { return elements; }
+    const_iterator end() const { return elements + count; }
+    T* data() { return elements; }
+    const T* data() const { return elements; }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    std::size_t capacity() const { return capacityCount; }
+
+    // Bytes allocated outside the object; 0 while the elements fit inline.
+    std::size_t heapBytes() const { return isInline() ? 0 : capacityCount * sizeof(T); }
+};
+
+#endif
@@ -0,0 +1,200 @@
+// StartupScheduler.h
+#ifndef STARTUPSCHEDULER_H
+#define STARTUPSCHEDULER_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "CsvTokenizer.h"
+#include "ThreadPool.h"
+
+// Runs named startup phases on a thread pool. Each phase starts as soon as
+// the phases it names in `after` have finished, so independent loaders
+// overlap and a join phase runs once its inputs are ready. A phase may fan
+// out further work on the same pool through a TaskGroup.
+class StartupScheduler {
+public:
+    struct Timing {
+        std::string name;
+        double startMs;    // since run() began
+        double durationMs;
+    };
+
+private:
+    struct Phase {
+        std::string name;
+        std::vector<std::size_t> dependents;
+        std::size_t waitingFor = 0;
+        std::function<void(ThreadPool&)> body;
+    };
+
+    std::vector<Phase> phases;
+    std::vector<std::pair<std::size_t, std::string>> dependencies; // phase, name it waits for
+    std::vector<Timing> timings;
+    double totalMs = 0;
+
+    std::size_t indexOf(std::string_view name) const {
+        for (std::size_t i = 0; i < phases.size(); ++i) {
+            if (phases[i].name == name)
+                return i;
+        }
+        return phases.size();
+    }
+
+public:
+    void add(std::string name, std::vector<std::string> after, std::function<void(ThreadPool&)> body) {
+        Phase phase;
+        phase.name = std::move(name);
+        phase.body = std::move(body);
+        for (std::string& dependency : after)
+            dependencies.emplace_back(phases.size(), std::move(dependency));
+        phases.push_back(std::move(phase));
+    }
+
+    // Runs every phase and returns once all have finished. Returns false
+    // without running anything if a dependency is unknown or circular.
+    bool run(ThreadPool& pool) {
+        for (const auto& dependency : dependencies) {
+            std::size_t before = indexOf(dependency.second);
+            if (before == phases.size()) {
+                std::cerr << "Startup phase " << phases[dependency.first].name << " waits for unknown phase "
+                          << dependency.second << std::endl;
+                return false;
+            }
+            phases[before].dependents.push_back(dependency.first);
+            ++phases[dependency.first].waitingFor;
+        }
+        // Kahn's algorithm on a copy of the counts, only to reject cycles.
+        std::vector<std::size_t> waiting(phases.size()), ready;
+        for (std::size_t i = 0; i < phases.size(); ++i) {
+            waiting[i] = phases[i].waitingFor;
+            if (waiting[i] == 0)
+                ready.push_back(i);
+        }
+        for (std::size_t next = 0; next < ready.size(); ++next) {
+            for (std::size_t dependent : phases[ready[next]].dependents) {
+                if (--waiting[dependent] == 0)
+                    ready.push_back(dependent);
+            }
+        }
+        if (ready.size() != phases.size()) {
+            std::cerr << "Startup phases have a circular dependency" << std::endl;
+            return false;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        auto since = [start] {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+        timings.assign(phases.size(), Timing());
+        TaskGroup group(pool);
+        std::mutex mutex;
+        std::function<void(std::size_t)> launch = [&](std::size_t index) {
+            group.run([&, index] {
+                Phase& phase = phases[index];
+                double began = since();
+                phase.body(pool);
+                timings[index] = Timing{phase.name, began, since() - began};
+                std::vector<std::size_t> unblocked;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    for (std::size_t dependent : phase.dependents) {
+                        if (--phases[dependent].waitingFor == 0)
+                            unblocked.push_back(dependent);
+                    }
+                }
+                for (std::size_t dependent : unblocked)
+                    launch(dependent);
+            });
+        };
+        for (std::size_t i = 0; i < phases.size(); ++i) {
+            if (phases[i].waitingFor == 0)
+                launch(i);
+        }
+        group.wait();
+        totalMs = since();
+        return true;
+    }
+
+    const std::vector<Timing>& phaseTimings() const { return timings; }
+
+    void printTimings(std::ostream& out, std::size_t threads) const {
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        out << "Startup took " << std::fixed << std::setprecision(1) << totalMs << " ms on " << threads
+            << (threads == 1 ? " thread:" : " threads:") << std::endl;
+        for (const Timing& timing : timings) {
+            out << "  " << std::left << std::setw(16) << timing.name << std::right << std::setw(9)
+                << timing.durationMs << " ms  (started at " << timing.startMs << " ms)" << std::endl;
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+// Tokenizes `text` in chunks on the pool; parse(const CsvRow&, Record&)
+// returning false marks a bad record, whose line goes to badLines. Records
+// come back in file order.
+template <typename Record, typename Parse>
+std::vector<Record> parseCsvParallel(std::string_view text, ThreadPool& pool, const Parse& parse,
+                                     std::vector<std::size_t>& badLines, std::string& error) {
+    std::vector<CsvChunk> chunks = splitCsvChunks(text, pool.size() * 4);
+    struct Parsed {
+        std::vector<Record> records;
+        std::vector<std::size_t> bad;
+        std::string error;
+    };
+    std::vector<Parsed> parsed(chunks.size());
+    {
+        TaskGroup group(pool);
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            group.run([&, i] {
+                CsvTokenizer tokenizer(chunks[i].text, ',', chunks[i].firstLine);
+                CsvRow row;
+                Record record;
+                while (tokenizer.next(row)) {
+                    if (parse(row, record))
+                        parsed[i].records.push_back(std::move(record));
+                    else
+                        parsed[i].bad.push_back(row.line());
+                }
+                parsed[i].error = tokenizer.error();
+            });
+        }
+    }
+    std::vector<Record> records;
+    std::size_t total = 0;
+    for (const Parsed& chunk : parsed)
+        total += chunk.records.size();
+    records.reserve(total);
+    for (Parsed& chunk : parsed) {
+        for (Record& record : chunk.records)
+            records.push_back(std::move(record));
+        badLines.insert(badLines.end(), chunk.bad.begin(), chunk.bad.end());
+        if (error.empty())
+            error = chunk.error;
+    }
+    return records;
+}
+
+// One warning for the unreadable lines parseCsvParallel reported.
+inline void warnUnreadableLines(const std::string& path, const std::vector<std::size_t>& badLines,
+                                const std::string& error) {
+    if (!badLines.empty()) {
+        std::cerr << "Warning: skipped " << badLines.size() << " unreadable lines in " << path << " (line";
+        for (std::size_t i = 0; i < badLines.size() && i < 5; ++i)
+            std::cerr << (i ? ", " : " ") << badLines[i];
+        std::cerr << (badLines.size() > 5 ? ", ...)" : ")") << std::endl;
+    }
+    if (!error.empty())
+        std::cerr << "Warning: " << path << " " << error << std::endl;
+}
+
+#endif
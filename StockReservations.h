@@ -0,0 +1,282 @@
+// StockReservations.h
+#ifndef STOCKRESERVATIONS_H
+#define STOCKRESERVATIONS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "CustomHashTable.h"
+
+// Live stock levels and time-limited cart reservations.
+// Each product has an on-hand count (what the warehouse holds, persisted
+// through the product snapshots) and an atomic available count (on hand
+// minus everything reserved). Reserving is a compare-and-swap on the
+// available count, so concurrent carts never queue on a lock or touch the
+// disk. A reservation (Hold) either
+//   - commits at checkout: on hand drops, available already did;
+//   - is released when its cart is cleared: available goes back up; or
+//   - expires after the TTL: a timer wheel gives the stock back.
+// Holds live in the wheel's buckets, which are lock-free stacks. Advancing
+// the wheel visits each hold about once per TTL, so expiry costs O(1)
+// amortized per reservation.
+class StockReservations {
+private:
+    struct Stock {
+        std::atomic<int> available{0};
+        int onHand = 0;
+    };
+
+public:
+    class Hold {
+        friend class StockReservations;
+
+        enum State : std::uint8_t { Held, Claimed, Committed, Released, Expired };
+
+        Stock* stock;
+        int quantity;
+        std::int64_t expiresAt; // wheel ticks
+        std::atomic<std::uint8_t> state;
+        std::atomic<int> refs; // the cart and the wheel
+        Hold* next;
+
+        Hold(Stock* _stock, int _quantity, std::int64_t _expiresAt)
+            : stock(_stock), quantity(_quantity), expiresAt(_expiresAt), state(Held), refs(2),
+              next(nullptr) {}
+
+        bool transition(State from, State to) {
+            std::uint8_t expected = from;
+            return state.compare_exchange_strong(expected, to, std::memory_order_acq_rel);
+        }
+
+    public:
+        int getQuantity() const { return quantity; }
+        bool isExpired() const { return state.load(std::memory_order_acquire) == Expired; }
+    };
+
+private:
+    static constexpr std::size_t WHEEL_SLOTS = 1024; // power of two
+
+    CustomHashTable<std::string, std::uint32_t> slots;
+    std::deque<Stock> stocks; // stable addresses for Hold::stock
+    std::array<std::atomic<Hold*>, WHEEL_SLOTS> wheel;
+    std::chrono::milliseconds tick;
+    std::int64_t ttlTicks;
+    std::int64_t processedTick; // last tick the wheel has expired
+    std::chrono::steady_clock::time_point epoch;
+    std::mutex advanceMutex; // one thread advances the wheel at a time
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread expiryThread;
+
+    std::int64_t currentTick() const {
+        return (std::chrono::steady_clock::now() - epoch) / tick;
+    }
+
+    void schedule(Hold* hold, std::int64_t atTick) {
+        std::atomic<Hold*>& head = wheel[static_cast<std::size_t>(atTick) & (WHEEL_SLOTS - 1)];
+        hold->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(hold->next, hold, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        }
+    }
+
+    static void unref(Hold* hold) {
+        if (hold->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete hold;
+    }
+
+    static bool take(Stock& stock, int quantity) {
+        int current = stock.available.load(std::memory_order_relaxed);
+        while (current >= quantity) {
+            if (stock.available.compare_exchange_weak(current, current - quantity,
+                                                      std::memory_order_acq_rel))
+                return true;
+        }
+        return false;
+    }
+
+    void runExpiry() {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        while (!stopping) {
+            wake.wait_for(lock, tick);
+            lock.unlock();
+            expire();
+            lock.lock();
+        }
+    }
+
+public:
+    explicit StockReservations(std::chrono::milliseconds ttl = std::chrono::minutes(15),
+                               std::chrono::milliseconds tickLength = std::chrono::seconds(1))
+        : slots(1024), tick(tickLength), ttlTicks(std::max<std::int64_t>(1, ttl / tickLength)),
+          processedTick(0), epoch(std::chrono::steady_clock::now()), stopping(false) {
+        for (auto& head : wheel)
+            head.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~StockReservations() {
+        stop();
+        for (auto& head : wheel) {
+            for (Hold* hold = head.exchange(nullptr); hold;) {
+                Hold* next = hold->next;
+                unref(hold);
+                hold = next;
+            }
+        }
+    }
+
+    StockReservations(const StockReservations&) = delete;
+    StockReservations& operator=(const StockReservations&) = delete;
+
+    // Starts the background thread that returns expired holds to stock.
+    void start() {
+        if (!expiryThread.joinable())
+            expiryThread = std::thread([this] { runExpiry(); });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (expiryThread.joinable())
+            expiryThread.join();
+    }
+
+    // Sets the on-hand count after a load, an admin edit or a replayed log
+    // record; available moves by the same amount. Returns false, changing
+    // nothing, if carts hold more than `onHand` units. Adding a product must
+    // be excluded from concurrent lookups (the catalog's exclusive lock);
+    // changing one is serialized with commit() by the caller.
+    bool setOnHand(const std::string& productId, int onHand) {
+        Stock* stock;
+        if (const std::uint32_t* slot = slots.find(productId)) {
+            stock = &stocks[*slot];
+        } else {
+            slots.insert(productId, static_cast<std::uint32_t>(stocks.size()));
+            stocks.emplace_back();
+            stock = &stocks.back();
+        }
+        // A CAS rather than an add: reserve() may take units meanwhile.
+        int current = stock->available.load(std::memory_order_relaxed);
+        do {
+            if (current + onHand - stock->onHand < 0)
+                return false;
+        } while (!stock->available.compare_exchange_weak(current, current + onHand - stock->onHand,
+                                                         std::memory_order_acq_rel));
+        stock->onHand = onHand;
+        return true;
+    }
+
+    // Units held by carts: reserved or claimed but not yet committed.
+    int held(std::string_view productId) const {
+        const std::uint32_t* slot = slots.find(productId);
+        return slot ? stocks[*slot].onHand - stocks[*slot].available.load(std::memory_order_acquire) : 0;
+    }
+
+    int available(std::string_view productId) const {
+        const std::uint32_t* slot = slots.find(productId);
+        return slot ? stocks[*slot].available.load(std::memory_order_acquire) : 0;
+    }
+
+    int onHand(std::string_view productId) const {
+        const std::uint32_t* slot = slots.find(productId);
+        return slot ? stocks[*slot].onHand : 0;
+    }
+
+    // Holds `quantity` units for one TTL, or returns nullptr if fewer are
+    // available. Lock-free.
+    Hold* reserve(std::string_view productId, int quantity) {
+        const std::uint32_t* slot = slots.find(productId);
+        if (!slot || quantity <= 0 || !take(stocks[*slot], quantity))
+            return nullptr;
+        std::int64_t expiresAt = currentTick() + ttlTicks;
+        Hold* hold = new Hold(&stocks[*slot], quantity, expiresAt);
+        schedule(hold, expiresAt);
+        return hold;
+    }
+
+    // First step of checkout: pins a hold so it cannot expire. An expired
+    // hold is replaced by a fresh one (updating `hold`) if the stock is
+    // still there.
+    bool claim(Hold*& hold) {
+        if (hold->transition(Hold::Held, Hold::Claimed))
+            return true;
+        if (!hold->isExpired() || !take(*hold->stock, hold->quantity))
+            return false;
+        std::int64_t expiresAt = currentTick() + ttlTicks;
+        Hold* renewed = new Hold(hold->stock, hold->quantity, expiresAt);
+        renewed->state.store(Hold::Claimed, std::memory_order_relaxed);
+        schedule(renewed, expiresAt);
+        unref(hold);
+        hold = renewed;
+        return true;
+    }
+
+    // Undoes claim() when another item of the same checkout failed.
+    void unclaim(Hold* hold) { hold->transition(Hold::Claimed, Hold::Held); }
+
+    // Completes a claimed hold: the units leave on-hand stock. Callers
+    // serialize commits (checkout holds the journal lock). Returns the new
+    // on-hand count. The caller's reference is dropped.
+    int commit(Hold* hold) {
+        hold->transition(Hold::Claimed, Hold::Committed);
+        int remaining = hold->stock->onHand -= hold->quantity;
+        unref(hold);
+        return remaining;
+    }
+
+    // Gives a held reservation back and drops the caller's reference.
+    void release(Hold* hold) {
+        if (hold->transition(Hold::Held, Hold::Released))
+            hold->stock->available.fetch_add(hold->quantity, std::memory_order_acq_rel);
+        unref(hold);
+    }
+
+    // Advances the wheel to now, returning expired holds to stock. Returns
+    // how many expired. Called by the background thread; safe to call from
+    // anywhere.
+    std::size_t expire() {
+        std::lock_guard<std::mutex> lock(advanceMutex);
+        std::size_t expired = 0;
+        const std::int64_t now = currentTick();
+        // A long pause only needs one pass over the wheel.
+        std::int64_t from = std::max(processedTick + 1, now - static_cast<std::int64_t>(WHEEL_SLOTS) + 1);
+        for (std::int64_t t = from; t <= now; ++t) {
+            Hold* hold = wheel[static_cast<std::size_t>(t) & (WHEEL_SLOTS - 1)].exchange(
+                nullptr, std::memory_order_acquire);
+            while (hold) {
+                Hold* next = hold->next;
+                if (hold->expiresAt <= now && hold->transition(Hold::Held, Hold::Expired)) {
+                    hold->stock->available.fetch_add(hold->quantity, std::memory_order_acq_rel);
+                    ++expired;
+                }
+                std::uint8_t state = hold->state.load(std::memory_order_acquire);
+                if (state == Hold::Claimed)
+                    schedule(hold, now + 1); // checkout in progress; look again later
+                else if (state == Hold::Held)
+                    // Due on a later lap, or already due if a checkout
+                    // unclaimed it after the transition above failed: then
+                    // its slot was emptied by this pass, so use the next one.
+                    schedule(hold, std::max(hold->expiresAt, now + 1));
+                else
+                    unref(hold);
+                hold = next;
+            }
+        }
+        processedTick = now;
+        return expired;
+    }
+};
+
+#endif
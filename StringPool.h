@@ -0,0 +1,190 @@
+// StringPool.h
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include "AtomicFile.h"
+#include "CsvTokenizer.h"
+#include "CustomHashTable.h"
+#include "MappedFile.h"
+
+// Process-wide table of short, endlessly repeated strings (categories,
+// subcategories, payment methods), each stored once and named by a 32-bit
+// code. Entries are never removed or moved, so a code stays valid for the
+// life of the process and resolving one takes no lock: the strings sit in
+// fixed chunks that are allocated once and only ever appended to. Interning
+// takes a shared lock for strings already present and an exclusive one to
+// add a new string. Code 0 is the empty string.
+class StringPool {
+private:
+    static constexpr std::uint32_t CHUNK_BITS = 12;
+    static constexpr std::uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static constexpr std::uint32_t MAX_CHUNKS = 1024; // 4M distinct strings
+
+    std::unique_ptr<std::atomic<std::string*>[]> chunks;
+    std::atomic<std::uint32_t> count;
+    mutable std::shared_mutex mutex; // guards codes and appends
+    CustomHashTable<std::string, std::uint32_t> codes;
+
+    // Called with the exclusive lock held.
+    std::uint32_t append(std::string_view text) {
+        const std::uint32_t code = count.load(std::memory_order_relaxed);
+        const std::uint32_t chunk = code >> CHUNK_BITS;
+        if (chunk >= MAX_CHUNKS) {
+            std::cerr << "Error: string pool is full; \"" << text << "\" stored as empty" << std::endl;
+            return 0;
+        }
+        std::string* strings = chunks[chunk].load(std::memory_order_relaxed);
+        if (!strings) {
+            strings = new std::string[CHUNK_SIZE];
+            chunks[chunk].store(strings, std::memory_order_release);
+        }
+        strings[code & (CHUNK_SIZE - 1)].assign(text);
+        codes.insert(std::string(text), code);
+        count.store(code + 1, std::memory_order_release);
+        return code;
+    }
+
+public:
+    StringPool() : chunks(new std::atomic<std::string*>[MAX_CHUNKS]), count(0), codes(64) {
+        for (std::uint32_t i = 0; i < MAX_CHUNKS; ++i)
+            chunks[i].store(nullptr, std::memory_order_relaxed);
+        append(std::string_view());
+    }
+
+    ~StringPool() {
+        for (std::uint32_t i = 0; i < MAX_CHUNKS; ++i)
+            delete[] chunks[i].load(std::memory_order_relaxed);
+    }
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // The pool Symbol uses.
+    static StringPool& global() {
+        static StringPool pool;
+        return pool;
+    }
+
+    std::uint32_t intern(std::string_view text) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            if (const std::uint32_t* existing = codes.find(text))
+                return *existing;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (const std::uint32_t* existing = codes.find(text))
+            return *existing;
+        return append(text);
+    }
+
+    // Looks `text` up without adding it.
+    bool find(std::string_view text, std::uint32_t& code) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const std::uint32_t* existing = codes.find(text);
+        if (!existing)
+            return false;
+        code = *existing;
+        return true;
+    }
+
+    // `code` must have come from this pool.
+    const std::string& str(std::uint32_t code) const {
+        return chunks[code >> CHUNK_BITS].load(std::memory_order_acquire)[code & (CHUNK_SIZE - 1)];
+    }
+
+    std::size_t size() const { return count.load(std::memory_order_acquire); }
+
+    // Approximate bytes held by the pool: chunk arrays, out-of-line string
+    // buffers and one lookup table slot (with its copy of the key) per entry.
+    std::size_t memoryUsage() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const std::uint32_t n = count.load(std::memory_order_relaxed);
+        std::size_t bytes = ((n + CHUNK_SIZE - 1) >> CHUNK_BITS) * CHUNK_SIZE * sizeof(std::string);
+        for (std::uint32_t code = 0; code < n; ++code) {
+            const std::string& s = str(code);
+            if (s.capacity() > 15)
+                bytes += 2 * (s.capacity() + 1);
+        }
+        return bytes + codes.size() * (sizeof(std::string) + 2 * sizeof(std::uint32_t) + sizeof(std::size_t));
+    }
+
+    // symbols.txt: one string per line in code order, CSV-quoted where
+    // needed. Loading it into a fresh pool gives every string its old code.
+    bool save(const std::string& path) const {
+        bool ok = writeFileAtomically(path, [&](std::ostream& out) {
+            const std::uint32_t n = static_cast<std::uint32_t>(size());
+            for (std::uint32_t code = 1; code < n; ++code) {
+                writeCsvField(out, str(code));
+                out << "\n";
+            }
+        });
+        if (!ok)
+            std::cerr << "Error saving string pool to " << path << std::endl;
+        return ok;
+    }
+
+    // Interns every string in `path`. A missing file is not an error.
+    bool load(const std::string& path) {
+        MappedFile file;
+        if (!file.open(path))
+            return false;
+        CsvTokenizer tokenizer(std::string_view(file.data(), file.size()));
+        CsvRow row;
+        while (tokenizer.next(row)) {
+            if (row.size() == 1)
+                intern(row[0]);
+        }
+        if (!tokenizer.error().empty()) {
+            std::cerr << "Warning: " << path << " " << tokenizer.error() << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+// A string from StringPool::global(), held as its 32-bit code. Equal
+// symbols are equal strings, so comparing two is one integer compare.
+// Building one from text interns it; use find() for text that should not
+// be added, such as a search term.
+class Symbol {
+private:
+    std::uint32_t value;
+
+    explicit Symbol(std::uint32_t code, int) : value(code) {}
+
+public:
+    Symbol() : value(0) {}
+    explicit Symbol(std::string_view text) : value(text.empty() ? 0 : StringPool::global().intern(text)) {}
+    explicit Symbol(const std::string& text) : Symbol(std::string_view(text)) {}
+    explicit Symbol(const char* text) : Symbol(std::string_view(text)) {}
+
+    // The symbol for `text` if it has been interned.
+    static bool find(std::string_view text, Symbol& symbol) {
+        std::uint32_t code;
+        if (!StringPool::global().find(text, code))
+            return false;
+        symbol = Symbol(code, 0);
+        return true;
+    }
+
+    const std::string& str() const { return StringPool::global().str(value); }
+    std::uint32_t code() const { return value; }
+    bool empty() const { return value == 0; }
+
+    bool operator==(Symbol other) const { return value == other.value; }
+    bool operator!=(Symbol other) const { return value != other.value; }
+};
+
+inline std::ostream& operator<<(std::ostream& os, Symbol symbol) { return os << symbol.str(); }
+
+#endif
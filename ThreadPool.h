@@ -0,0 +1,154 @@
+// ThreadPool.h
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed set of worker threads draining one FIFO task queue. Tasks must not
+// throw; wait() blocks until the queue is empty and every worker is idle.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable idle;
+    std::size_t busy;
+    bool stopping;
+
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                ++busy;
+            }
+            task();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0 && tasks.empty())
+                idle.notify_all();
+        }
+    }
+
+public:
+    explicit ThreadPool(std::size_t threads) : busy(0), stopping(false) {
+        if (threads == 0)
+            threads = 1;
+        workers.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+            workers.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPool() { shutdown(); }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        ready.notify_one();
+    }
+
+    // Runs one queued task on the calling thread; false if none is queued.
+    bool runOne() {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty())
+                return false;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            ++busy;
+        }
+        task();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0 && tasks.empty())
+            idle.notify_all();
+        return true;
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return busy == 0 && tasks.empty(); });
+    }
+
+    // Runs the queued tasks to completion, then joins the workers.
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+                return;
+            stopping = true;
+        }
+        ready.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    std::size_t size() const { return workers.size(); }
+};
+
+// A set of pool tasks that can be waited for on its own, unlike
+// ThreadPool::wait(). The waiting thread runs queued tasks meanwhile, so a
+// task may itself fan out into a group and wait without starving the pool.
+class TaskGroup {
+private:
+    ThreadPool& pool;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t pending;
+
+public:
+    explicit TaskGroup(ThreadPool& _pool) : pool(_pool), pending(0) {}
+    ~TaskGroup() { wait(); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++pending;
+        }
+        pool.submit([this, task = std::move(task)] {
+            task();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0)
+                done.notify_all();
+        });
+    }
+
+    void wait() {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (pending == 0)
+                    return;
+            }
+            if (!pool.runOne()) {
+                // Our tasks are running elsewhere; wake up now and then in
+                // case one of them queued more work.
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait_for(lock, std::chrono::milliseconds(1), [this] { return pending == 0; });
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,180 @@
+// Validators.h
+#ifndef VALIDATORS_H
+#define VALIDATORS_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <string_view>
+
+// Input validation shared by the console menus, server commands and
+// imports. Each check is a single pass over the characters with no
+// allocation, and all of them are constexpr.
+namespace Validators {
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+constexpr bool isUpper(char c) { return c >= 'A' && c <= 'Z'; }
+constexpr bool isLower(char c) { return c >= 'a' && c <= 'z'; }
+constexpr bool isAlnum(char c) { return isDigit(c) || isUpper(c) || isLower(c); }
+
+constexpr bool isPasswordSymbol(char c) {
+    return c == '!' || c == '@' || c == '#' || c == '$' || c == '%' || c == '^' || c == '&' || c == '*';
+}
+
+// 4-20 letters, digits or underscores.
+constexpr bool isValidUsername(std::string_view text) {
+    if (text.size() < 4 || text.size() > 20)
+        return false;
+    for (char c : text) {
+        if (!isAlnum(c) && c != '_')
+            return false;
+    }
+    return true;
+}
+
+// At least 8 characters from letters, digits and !@#$%^&*, with at least
+// one upper-case letter, lower-case letter, digit and symbol.
+constexpr bool isValidPassword(std::string_view text) {
+    if (text.size() < 8)
+        return false;
+    bool upper = false, lower = false, digit = false, symbol = false;
+    for (char c : text) {
+        if (isUpper(c))
+            upper = true;
+        else if (isLower(c))
+            lower = true;
+        else if (isDigit(c))
+            digit = true;
+        else if (isPasswordSymbol(c))
+            symbol = true;
+        else
+            return false;
+    }
+    return upper && lower && digit && symbol;
+}
+
+// Product, order and tracking ids: 1-32 letters, digits, '-' or '_'.
+constexpr bool isValidId(std::string_view text) {
+    if (text.empty() || text.size() > 32)
+        return false;
+    for (char c : text) {
+        if (!isAlnum(c) && c != '-' && c != '_')
+            return false;
+    }
+    return true;
+}
+
+// Customer ids: 1-9 digits.
+constexpr bool isValidNumericId(std::string_view text) {
+    if (text.empty() || text.size() > 9)
+        return false;
+    for (char c : text) {
+        if (!isDigit(c))
+            return false;
+    }
+    return true;
+}
+
+// A free-text field (names, addresses, categories): non-empty, at most
+// maxLength, no control characters and no '|', which separates operation
+// log fields. Commas are fine; the CSV writers quote them.
+constexpr bool isValidField(std::string_view text, std::size_t maxLength = 100) {
+    if (text.empty() || text.size() > maxLength)
+        return false;
+    for (char c : text) {
+        if (c == '|' || (static_cast<unsigned char>(c) < 0x20) || c == 0x7f)
+            return false;
+    }
+    return true;
+}
+
+// local@domain.tld: a local part of letters, digits and ._%+-, a domain of
+// dot-separated labels (letters, digits, inner '-') with at least two
+// labels and a top-level label of two or more letters.
+constexpr bool isValidEmail(std::string_view text) {
+    if (text.size() > 254)
+        return false;
+    std::size_t at = text.find('@');
+    if (at == 0 || at == std::string_view::npos || at > 64)
+        return false;
+    for (char c : text.substr(0, at)) {
+        if (!isAlnum(c) && c != '.' && c != '_' && c != '%' && c != '+' && c != '-')
+            return false;
+    }
+    std::string_view domain = text.substr(at + 1);
+    std::size_t labels = 0, labelLength = 0, labelLetters = 0;
+    char previous = '.';
+    for (char c : domain) {
+        if (c == '.') {
+            if (labelLength == 0 || previous == '-')
+                return false;
+            ++labels;
+            labelLength = 0;
+            labelLetters = 0;
+        } else if (isAlnum(c) || (c == '-' && labelLength > 0)) {
+            ++labelLength;
+            labelLetters += isUpper(c) || isLower(c);
+        } else {
+            return false;
+        }
+        previous = c;
+    }
+    return labels >= 1 && labelLength >= 2 && labelLetters == labelLength;
+}
+
+// Phone numbers: an optional leading '+', then 7-15 digits that may be
+// grouped with single spaces or dashes.
+constexpr bool isValidPhone(std::string_view text) {
+    if (!text.empty() && text.front() == '+')
+        text.remove_prefix(1);
+    std::size_t digits = 0;
+    bool afterSeparator = true; // no leading separator
+    for (char c : text) {
+        if (isDigit(c)) {
+            ++digits;
+            afterSeparator = false;
+        } else if ((c == ' ' || c == '-') && !afterSeparator) {
+            afterSeparator = true;
+        } else {
+            return false;
+        }
+    }
+    return !afterSeparator && digits >= 7 && digits <= 15;
+}
+
+constexpr int twoDigits(std::string_view text, std::size_t pos) {
+    return (text[pos] - '0') * 10 + (text[pos + 1] - '0');
+}
+
+// "MM-YYYY" with a month of 01-12.
+constexpr bool isValidMonthYear(std::string_view text) {
+    if (text.size() != 7 || text[2] != '-')
+        return false;
+    for (std::size_t i : {0, 1, 3, 4, 5, 6}) {
+        if (!isDigit(text[i]))
+            return false;
+    }
+    int month = twoDigits(text, 0);
+    return month >= 1 && month <= 12;
+}
+
+// "YYYY-MM-DD" naming a real calendar day.
+constexpr bool isValidDate(std::string_view text) {
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-')
+        return false;
+    for (std::size_t i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        if (!isDigit(text[i]))
+            return false;
+    }
+    int year = twoDigits(text, 0) * 100 + twoDigits(text, 2);
+    int month = twoDigits(text, 5);
+    int day = twoDigits(text, 8);
+    if (month < 1 || month > 12 || day < 1)
+        return false;
+    constexpr int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return day <= days[month - 1] + (month == 2 && leap);
+}
+
+} // namespace Validators
+
+#endif
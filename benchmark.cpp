@@ -0,0 +1,1164 @@
+// benchmark.cpp
+// Benchmarks for the warehouse data structures and load paths.
+// Build: g++ -std=c++17 -O2 -pthread benchmark.cpp -o benchmark
+// Usage: ./benchmark [scenario|all] [rows] [--json]
+// With --json the table goes to stderr and stdout gets one JSON document
+// with ops/s, p50/p99 latency and heap traffic per measurement, for
+// comparing runs.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ArenaProductTree.h"
+#include "Cart.h"
+#include "Credentials.h"
+#include "CsvTokenizer.h"
+#include "CustomerIndex.h"
+#include "DataGenerator.h"
+#include "IdAllocator.h"
+#include "MappedFile.h"
+#include "Money.h"
+#include "Order.h"
+#include "OrderRepository.h"
+#include "Product.h"
+#include "ProductAVLTree.h"
+#include "ProductCatalogIndex.h"
+#include "ProductSnapshot.h"
+#include "SalesAggregator.h"
+#include "ShipmentStore.h"
+#include "StartupScheduler.h"
+#include "StringPool.h"
+#include "Validators.h"
+using namespace std;
+namespace fs = std::filesystem;
+
+// Deterministic synthetic catalog, sorted by id like the tree's in-order walk.
+static vector<Product> makeCatalog(size_t rows) {
+    static const char* categories[] = {"Men", "Women"};
+    static const char* subcategories[] = {"Casual", "Eid Edition", "New In", "Formal", "Summer Lawn"};
+    mt19937 rng(42);
+    vector<Product> catalog;
+    catalog.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        char id[24];
+        snprintf(id, sizeof(id), "P%08zu", i);
+        catalog.emplace_back(id, "Article " + to_string(rng() % 100000), categories[rng() % 2],
+                             subcategories[rng() % 5], Money::fromMinorUnits(50000 + (rng() % 50000) * 100),
+                             rng() % 200);
+    }
+    return catalog;
+}
+
+// Heap traffic of the whole process, counted by the replacement operator
+// new below; a measurement reports the difference across its run.
+static atomic<size_t> allocatedBytes{0}, allocationCount{0};
+
+void* operator new(size_t size) {
+    allocatedBytes.fetch_add(size, memory_order_relaxed);
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+// GCC flags free() in the inlined delete as mismatched with new; they are a pair.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct Result {
+    string scenario, name;
+    size_t ops;
+    double ms;
+    double p50Us, p99Us; // negative when not sampled per operation
+    size_t bytes, allocations;
+    bool throughput;     // ops counts bytes processed
+};
+
+static string currentScenario;
+static vector<Result> results;
+static size_t lastBytes = 0, lastAllocations = 0; // heap traffic of the last timeMs()
+
+template <typename F>
+static double timeMs(F&& f) {
+    const size_t bytes = allocatedBytes.load(), allocations = allocationCount.load();
+    auto start = chrono::steady_clock::now();
+    f();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    lastBytes = allocatedBytes.load() - bytes;
+    lastAllocations = allocationCount.load() - allocations;
+    return ms;
+}
+
+static void record(const string& name, size_t ops, double ms, double p50Us, double p99Us, bool throughput) {
+    size_t first = name.find_first_not_of(' ');
+    results.push_back({currentScenario, first == string::npos ? name : name.substr(first), ops, ms, p50Us, p99Us,
+                       lastBytes, lastAllocations, throughput});
+}
+
+static void report(const string& name, size_t ops, double ms) {
+    cout << left << setw(40) << name << right << setw(12) << fixed << setprecision(2) << ms
+         << " ms" << setw(14) << setprecision(0) << (ops / (ms / 1000.0)) << " ops/s" << endl;
+    record(name, ops, ms, -1, -1, false);
+}
+
+// Runs op(i) for i in [0, ops), timing each call, and reports throughput
+// with the median and 99th percentile latency.
+template <typename Op>
+static void measure(const string& name, size_t ops, const Op& op) {
+    vector<double> latencies(ops);
+    double ms = timeMs([&] {
+        for (size_t i = 0; i < ops; ++i) {
+            auto start = chrono::steady_clock::now();
+            op(i);
+            latencies[i] = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        }
+    });
+    auto percentile = [&](double q) {
+        if (latencies.empty())
+            return 0.0;
+        auto at = latencies.begin() + static_cast<ptrdiff_t>(q * (latencies.size() - 1));
+        nth_element(latencies.begin(), at, latencies.end());
+        return *at;
+    };
+    double p50 = percentile(0.50), p99 = percentile(0.99);
+    cout << left << setw(40) << name << right << setw(12) << fixed << setprecision(2) << ms << " ms"
+         << setw(14) << setprecision(0) << (ops / (ms / 1000.0)) << " ops/s" << setprecision(2) << "  p50 " << p50
+         << " us  p99 " << p99 << " us" << endl;
+    record(name, ops, ms, p50, p99, false);
+}
+
+static void writeJsonString(ostream& out, const string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            out << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec << setfill(' ');
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+static void writeJson(ostream& out, size_t rows) {
+    out << "{\n  \"rows\": " << rows << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        const double rate = r.ms > 0 ? r.ops / (r.ms / 1000.0) : 0;
+        out << (i ? ",\n" : "\n") << "    {\"scenario\": ";
+        writeJsonString(out, r.scenario);
+        out << ", \"name\": ";
+        writeJsonString(out, r.name);
+        out << fixed << setprecision(3) << ", \"ms\": " << r.ms;
+        if (r.throughput)
+            out << ", \"bytes\": " << r.ops << ", \"mb_per_s\": " << rate / 1048576.0;
+        else
+            out << ", \"ops\": " << r.ops << ", \"ops_per_s\": " << setprecision(1) << rate;
+        out << setprecision(3);
+        if (r.p50Us >= 0)
+            out << ", \"p50_us\": " << r.p50Us << ", \"p99_us\": " << r.p99Us;
+        else
+            out << ", \"p50_us\": null, \"p99_us\": null";
+        out << ", \"bytes_allocated\": " << r.bytes << ", \"allocations\": " << r.allocations << "}";
+    }
+    out << "\n  ]\n}" << endl;
+}
+
+// Cold catalog load: products.txt through getline/stringstream and n AVL
+// inserts (what loadProducts used to do) versus mapping products.bin and
+// bulk-building the arena index from the sorted columns.
+static void benchStartup(size_t rows) {
+    fs::path dir = fs::temp_directory_path() / "wearhouse_bench";
+    fs::create_directories(dir);
+    const string csvPath = (dir / "products.txt").string();
+    const string binPath = (dir / "products.bin").string();
+    {
+        vector<Product> catalog = makeCatalog(rows);
+        ofstream ofs(csvPath);
+        for (const auto& p : catalog)
+            ofs << p.toCsv() << "\n";
+        ofs.close();
+        writeProductSnapshot(binPath, catalog.size(), [&](const auto& visit) {
+            for (const auto& p : catalog)
+                visit(p);
+        });
+    }
+    cout << "startup (" << rows << " products, csv " << fs::file_size(csvPath) / 1024 << " KiB, bin "
+         << fs::file_size(binPath) / 1024 << " KiB)" << endl;
+
+    double csvMs = timeMs([&] {
+        ProductAVLTree tree;
+        ifstream ifs(csvPath);
+        string line;
+        while (getline(ifs, line))
+            tree.insert(Product::fromCsv(line));
+    });
+    report("  csv parse + AVL inserts", rows, csvMs);
+
+    double binMs = timeMs([&] {
+        ArenaProductTree tree;
+        ProductSnapshot snapshot;
+        if (snapshot.open(binPath))
+            tree.buildFromSorted(snapshot.size(), [&](size_t row) { return snapshot.product(row); });
+    });
+    report("  mmap snapshot + bulk build", rows, binMs);
+    cout << "  speedup: " << setprecision(1) << csvMs / binMs << "x" << endl;
+    fs::remove_all(dir);
+}
+
+// Runs the same workload against one product index implementation.
+template <typename Tree>
+static void benchIndexVariant(const string& label, const vector<Product>& catalog,
+                              const vector<size_t>& shuffled, const function<void(Tree&)>& configure) {
+    const size_t rows = catalog.size();
+    {
+        Tree tree;
+        configure(tree);
+        report(label + " insert (random order)", rows, timeMs([&] {
+                   for (size_t i : shuffled)
+                       tree.insert(catalog[i]);
+               }));
+    }
+    Tree tree;
+    configure(tree);
+    report(label + " bulk build (sorted)", rows, timeMs([&] {
+               tree.buildFromSorted(rows, [&](size_t i) { return catalog[i]; });
+           }));
+    size_t hits = 0;
+    report(label + " find (random hits)", rows, timeMs([&] {
+               for (size_t i : shuffled)
+                   hits += tree.find(catalog[i].id) != nullptr;
+           }));
+    size_t total = 0;
+    report(label + " in-order copy (getAllProducts)", rows,
+           timeMs([&] { total = tree.getAllProducts().size(); }));
+    size_t visited = 0;
+    report(label + " in-order visit (forEach)", rows,
+           timeMs([&] { tree.forEach([&](const Product&) { visited++; }); }));
+    report(label + " remove (half)", rows / 2, timeMs([&] {
+               for (size_t k = 0; k < rows / 2; ++k)
+                   tree.remove(catalog[shuffled[k]].id);
+           }));
+    if (hits != rows || total != rows || visited != rows)
+        cerr << "  " << label << ": unexpected result counts" << endl;
+}
+
+// find/insert/remove/in-order throughput of the pointer-based AVL tree
+// against the arena tree in both layouts.
+static void benchIndex(size_t rows) {
+    cout << "index (" << rows << " products)" << endl;
+    vector<Product> catalog = makeCatalog(rows);
+    vector<size_t> shuffled(rows);
+    for (size_t i = 0; i < rows; ++i)
+        shuffled[i] = i;
+    shuffle(shuffled.begin(), shuffled.end(), mt19937(7));
+    benchIndexVariant<ProductAVLTree>("  pointer AVL", catalog, shuffled, [](ProductAVLTree&) {});
+    benchIndexVariant<ArenaProductTree>("  arena AVL", catalog, shuffled, [](ArenaProductTree&) {});
+    benchIndexVariant<ArenaProductTree>("  arena Eytzinger", catalog, shuffled, [](ArenaProductTree& t) {
+        t.setLayout(ArenaProductTree::Layout::Eytzinger);
+    });
+}
+
+// Carrier feed ingestion: every shipment goes packed, shipped, delivered,
+// with the feed lines interleaved across shipments, against the old
+// dashboard scan of shipments.txt.
+static void benchShipments(size_t rows) {
+    fs::path dir = fs::temp_directory_path() / "wearhouse_bench";
+    fs::create_directories(dir);
+    const string storePath = (dir / "shipments.txt").string();
+    const string feedPath = (dir / "feed.txt").string();
+    ShipmentStore store;
+    for (size_t i = 0; i < rows; ++i) {
+        char trackingId[24];
+        snprintf(trackingId, sizeof(trackingId), "TRK%08zu", i);
+        store.add({"ORD" + string(trackingId + 3), trackingId, "Customer " + to_string(i), "Street " + to_string(i),
+                   ShipmentStatus::InProgress});
+    }
+    store.save(storePath);
+    {
+        static const char* steps[] = {"packed", "shipped", "delivered"};
+        vector<size_t> order(rows);
+        for (size_t i = 0; i < rows; ++i)
+            order[i] = i;
+        shuffle(order.begin(), order.end(), mt19937(11));
+        ofstream feed(feedPath);
+        for (const char* step : steps) {
+            for (size_t i : order) {
+                char trackingId[24];
+                snprintf(trackingId, sizeof(trackingId), "TRK%08zu", i);
+                feed << trackingId << "," << step << "\n";
+            }
+        }
+    }
+    cout << "shipments (" << rows << " shipments, feed " << fs::file_size(feedPath) / 1024 << " KiB)" << endl;
+
+    size_t delivered = 0;
+    report("  dashboard by rescanning file", rows, timeMs([&] {
+               ifstream ifs(storePath);
+               string line;
+               while (getline(ifs, line)) {
+                   string status = line.substr(line.rfind(',') + 1);
+                   transform(status.begin(), status.end(), status.begin(), ::tolower);
+                   delivered += status == "delivered";
+               }
+           }));
+    ShipmentStore loaded;
+    report("  load store", rows, timeMs([&] { loaded.load(storePath); }));
+    ShipmentFeedResult result;
+    report("  ingest carrier feed", rows * 3, timeMs([&] {
+               MappedFile feed;
+               feed.open(feedPath);
+               result = loaded.applyFeed(string_view(feed.data(), feed.size()));
+           }));
+    report("  save compacted store", rows, timeMs([&] { loaded.save(storePath); }));
+    if (result.applied != rows * 3 || loaded.count(ShipmentStatus::Delivered) != rows)
+        cerr << "  shipments: unexpected result counts" << endl;
+    fs::remove_all(dir);
+}
+
+// Admin login throughput at several KDF costs, against the old unsalted
+// std::hash check and a session-token resume (which skips the KDF).
+static void benchLogin(size_t rows) {
+    cout << "login" << endl;
+    const string password = "Admin@123";
+    LegacyHashBackend legacy;
+    const string legacyHash = legacy.hash(password);
+    size_t ok = 0;
+    report("  legacy std::hash", rows, timeMs([&] {
+               for (size_t i = 0; i < rows; ++i)
+                   ok += legacy.verify(password, legacyHash);
+           }));
+    for (uint32_t iterations : {1000u, 10000u, 100000u, 600000u}) {
+        Pbkdf2Backend backend(iterations);
+        const string stored = backend.hash(password);
+        // About two million PBKDF2 rounds per cost setting.
+        size_t logins = max<size_t>(2, 2000000 / iterations);
+        report("  pbkdf2-sha256 " + to_string(iterations) + " iterations", logins, timeMs([&] {
+                   for (size_t i = 0; i < logins; ++i)
+                       ok += backend.verify(password, stored);
+               }));
+    }
+    SessionTokenCache tokens;
+    const string token = tokens.issue("admin");
+    string username;
+    report("  session token resume", rows, timeMs([&] {
+               for (size_t i = 0; i < rows; ++i)
+                   ok += tokens.validate(token, username);
+           }));
+    if (ok == 0)
+        cerr << "  login: nothing verified" << endl;
+}
+
+// Bulk-import validation: the regexes AdminHashTable used to build on every
+// call (and the same regexes compiled once) against Validators.
+static void benchValidate(size_t rows) {
+    mt19937 rng(5);
+    static const char* passwordSamples[] = {"Admin@123", "weakpass", "Str0ng!Passw0rd", "NoDigits!!", "abc"};
+    static const char* emailSamples[] = {"ann@example.com", "bad@", "x.y+z@shop.example.pk", "no-at-sign", "a@b.c"};
+    vector<string> usernames, passwords, emails;
+    for (size_t i = 0; i < rows; ++i) {
+        usernames.push_back((rng() % 4 ? "user_" : "bad user ") + to_string(rng() % 100000));
+        passwords.push_back(passwordSamples[rng() % 5]);
+        emails.push_back(emailSamples[rng() % 5]);
+    }
+    const char* usernamePattern = "^[a-zA-Z0-9_]{4,20}$";
+    const char* passwordPattern = "^(?=.*[A-Z])(?=.*[a-z])(?=.*[0-9])(?=.*[!@#$%^&*])[A-Za-z0-9!@#$%^&*]{8,}$";
+    const char* emailPattern = "^[A-Za-z0-9._%+-]+@([A-Za-z0-9-]+\\.)+[A-Za-z]{2,}$";
+    cout << "validate (" << rows << " of each field)" << endl;
+    size_t regexValid = 0, compiledValid = 0, handValid = 0;
+    report("  regex built per call", rows * 3, timeMs([&] {
+               for (size_t i = 0; i < rows; ++i) {
+                   regexValid += regex_match(usernames[i], regex(usernamePattern));
+                   regexValid += regex_match(passwords[i], regex(passwordPattern));
+                   regexValid += regex_match(emails[i], regex(emailPattern));
+               }
+           }));
+    const regex username(usernamePattern), password(passwordPattern), email(emailPattern);
+    report("  regex compiled once", rows * 3, timeMs([&] {
+               for (size_t i = 0; i < rows; ++i) {
+                   compiledValid += regex_match(usernames[i], username);
+                   compiledValid += regex_match(passwords[i], password);
+                   compiledValid += regex_match(emails[i], email);
+               }
+           }));
+    report("  Validators", rows * 3, timeMs([&] {
+               for (size_t i = 0; i < rows; ++i) {
+                   handValid += Validators::isValidUsername(usernames[i]);
+                   handValid += Validators::isValidPassword(passwords[i]);
+                   handValid += Validators::isValidEmail(emails[i]);
+               }
+           }));
+    if (regexValid != handValid || compiledValid != handValid)
+        cerr << "  validate: results differ (regex " << regexValid << ", Validators " << handValid << ")" << endl;
+}
+
+static void reportThroughput(const string& name, size_t bytes, double ms) {
+    cout << left << setw(40) << name << right << setw(12) << fixed << setprecision(2) << ms
+         << " ms" << setw(14) << setprecision(1) << (bytes / 1048576.0) / (ms / 1000.0) << " MB/s" << endl;
+    record(name, bytes, ms, -1, -1, true);
+}
+
+// Loader parse throughput: getline plus a stringstream per line (the old
+// fromCsv) against CsvTokenizer over the mapped file with from_chars.
+static void benchParse(size_t rows) {
+    fs::path dir = fs::temp_directory_path() / "wearhouse_bench";
+    fs::create_directories(dir);
+    const string productsPath = (dir / "products.txt").string();
+    const string ordersPath = (dir / "orders.txt").string();
+    {
+        vector<Product> catalog = makeCatalog(rows);
+        ofstream products(productsPath);
+        for (const auto& p : catalog)
+            products << p.toCsv() << "\n";
+        mt19937 rng(9);
+        const Money unitPrice = Money::fromMinorUnits(150000);
+        ofstream orders(ordersPath);
+        for (size_t i = 0; i < rows; ++i) {
+            Order order("ORD" + to_string(i), "TRK" + to_string(i), "2024-05-17 10:42:00", "Customer " + to_string(i),
+                        "House " + to_string(rng() % 900) + " Street 4 Lahore", "0300-1234567", "Card");
+            for (size_t k = 0; k < 1 + rng() % 4; ++k)
+                order.items.push_back({catalog[rng() % catalog.size()].id, int(1 + rng() % 3), unitPrice});
+            order.totalPrice = unitPrice * order.items.size();
+            orders << order.toCsv() << "\n";
+        }
+    }
+    const size_t productBytes = fs::file_size(productsPath), orderBytes = fs::file_size(ordersPath);
+    cout << "parse (" << rows << " products, " << productBytes / 1024 << " KiB; " << rows << " orders, "
+         << orderBytes / 1024 << " KiB)" << endl;
+
+    double checksum[4] = {0, 0, 0, 0};
+    reportThroughput("  products getline + stringstream", productBytes, timeMs([&] {
+                         ifstream ifs(productsPath);
+                         string line, id, name, category, subcategory;
+                         while (getline(ifs, line)) {
+                             stringstream ss(line);
+                             double price = 0;
+                             int quantity = 0;
+                             getline(ss, id, ',');
+                             getline(ss, name, ',');
+                             getline(ss, category, ',');
+                             getline(ss, subcategory, ',');
+                             ss >> price;
+                             ss.ignore();
+                             ss >> quantity;
+                             checksum[0] += price + quantity;
+                         }
+                     }));
+    reportThroughput("  products CsvTokenizer", productBytes, timeMs([&] {
+                         MappedFile file;
+                         file.open(productsPath);
+                         CsvTokenizer tokenizer(string_view(file.data(), file.size()));
+                         CsvRow row;
+                         while (tokenizer.next(row)) {
+                             double price = 0;
+                             int quantity = 0;
+                             row.number(4, price);
+                             row.number(5, quantity);
+                             checksum[1] += price + quantity;
+                         }
+                     }));
+    reportThroughput("  orders getline + stringstream", orderBytes, timeMs([&] {
+                         ifstream ifs(ordersPath);
+                         string line, field, item;
+                         while (getline(ifs, line)) {
+                             stringstream ss(line);
+                             for (int f = 0; f < 7; ++f)
+                                 getline(ss, field, ',');
+                             double total = 0;
+                             ss >> total;
+                             ss.ignore();
+                             getline(ss, field);
+                             stringstream items(field);
+                             while (getline(items, item, ';'))
+                                 checksum[2] += stoi(item.substr(item.find(':') + 1));
+                             checksum[2] += total;
+                         }
+                     }));
+    reportThroughput("  orders CsvTokenizer", orderBytes, timeMs([&] {
+                         MappedFile file;
+                         file.open(ordersPath);
+                         CsvTokenizer tokenizer(string_view(file.data(), file.size()));
+                         CsvRow row;
+                         Order order;
+                         while (tokenizer.next(row)) {
+                             Order::fromRow(row, order);
+                             for (const OrderItem& item : order.items)
+                                 checksum[3] += item.quantity;
+                             checksum[3] += order.totalPrice.toDouble();
+                         }
+                     }));
+    if (checksum[0] != checksum[1] || checksum[2] != checksum[3])
+        cerr << "  parse: results differ" << endl;
+    fs::remove_all(dir);
+}
+
+// Cold start with the startup scheduler's building blocks: products.txt
+// parsed in parallel chunks and the order history opened with its
+// segments read in parallel, at increasing thread counts.
+static void benchColdStart(size_t rows) {
+    fs::path dir = fs::temp_directory_path() / "wearhouse_bench";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "orders");
+    const string productsPath = (dir / "products.txt").string();
+    vector<Product> catalog = makeCatalog(rows);
+    {
+        ofstream products(productsPath);
+        for (const auto& p : catalog)
+            products << p.toCsv() << "\n";
+        OrderRepository orders((dir / "orders").string(), 0);
+        orders.open();
+        mt19937 rng(11);
+        for (size_t i = 0; i < rows; ++i) {
+            Order order("ORD" + to_string(i), "TRK" + to_string(i), "2024-05-17 10:42:00", "Customer " + to_string(i),
+                        "House " + to_string(rng() % 900) + ", Lahore", "0300-1234567", "Cash");
+            order.items.push_back({catalog[rng() % catalog.size()].id, 1, Money::fromMinorUnits(150000)});
+            order.totalPrice = Money::fromMinorUnits(150000);
+            orders.add(move(order), false);
+        }
+        orders.sync();
+        // Drop the sealed segments' indexes so open() has to scan them.
+        for (const auto& entry : fs::directory_iterator(dir / "orders")) {
+            if (entry.path().extension() == ".idx")
+                fs::remove(entry.path());
+        }
+    }
+    cout << "coldstart (" << rows << " products, " << rows << " orders, " << thread::hardware_concurrency()
+         << " cores)" << endl;
+    MappedFile file;
+    file.open(productsPath);
+    for (size_t threads : {1, 2, 4, 8}) {
+        ThreadPool pool(threads);
+        vector<size_t> badLines;
+        string error;
+        size_t parsed = 0;
+        double productMs = timeMs([&] {
+            parsed = parseCsvParallel<Product>(string_view(file.data(), file.size()), pool, Product::fromRow,
+                                               badLines, error).size();
+        });
+        report("  products, " + to_string(threads) + " threads", parsed, productMs);
+        size_t opened = 0;
+        double orderMs = timeMs([&] {
+            OrderRepository orders((dir / "orders").string(), 0);
+            orders.open(&pool);
+            opened = orders.size();
+        });
+        report("  orders, " + to_string(threads) + " threads", opened, orderMs);
+        for (const auto& entry : fs::directory_iterator(dir / "orders")) {
+            if (entry.path().extension() == ".idx")
+                fs::remove(entry.path());
+        }
+    }
+    fs::remove_all(dir);
+}
+
+// A DataGenerator dataset scaled to `rows` orders, with a product for every
+// four orders and a customer for every eight.
+struct Dataset {
+    DatasetSpec spec;
+    vector<Product> products; // in id order
+    vector<DataGenerator::Customer> customers;
+    vector<Order> orders;
+    vector<string> popularIds; // product ids of every order line, so Zipfian
+};
+
+static Dataset makeDataset(size_t rows) {
+    Dataset data;
+    data.spec.orders = max<size_t>(rows, 1);
+    data.spec.products = max<size_t>(rows / 4, 100);
+    data.spec.customers = max<size_t>(rows / 8, 100);
+    DataGenerator generator(data.spec);
+    data.products = generator.products();
+    data.customers = generator.customers();
+    data.orders = generator.orders(data.products, data.customers);
+    for (const Order& order : data.orders) {
+        for (const OrderItem& item : order.items)
+            data.popularIds.push_back(item.productId);
+    }
+    return data;
+}
+
+static void buildArena(ArenaProductTree& tree, const vector<Product>& products) {
+    tree.buildFromSorted(products.size(), [&](size_t i) { return products[i]; });
+}
+
+// Point lookups with the popularity skew of real order lines: products in
+// each index layout and customers by id.
+static void benchLookups(size_t rows) {
+    Dataset data = makeDataset(rows);
+    cout << "lookups (" << data.products.size() << " products, " << data.customers.size() << " customers, "
+         << rows << " zipf queries)" << endl;
+    const vector<string>& ids = data.popularIds;
+    size_t hits = 0;
+    {
+        ProductAVLTree tree;
+        tree.buildFromSorted(data.products.size(), [&](size_t i) { return data.products[i]; });
+        measure("  pointer AVL find", rows, [&](size_t i) { hits += tree.find(ids[i % ids.size()]) != nullptr; });
+    }
+    ArenaProductTree arena;
+    buildArena(arena, data.products);
+    measure("  arena AVL find", rows, [&](size_t i) { hits += arena.find(ids[i % ids.size()]) != nullptr; });
+    arena.setLayout(ArenaProductTree::Layout::Eytzinger);
+    measure("  arena Eytzinger find", rows, [&](size_t i) { hits += arena.find(ids[i % ids.size()]) != nullptr; });
+
+    CustomHashTable<string, DataGenerator::Customer> customers;
+    for (const auto& c : data.customers)
+        customers.insert(c.id, c);
+    mt19937 rng(3);
+    vector<string> customerIds(rows);
+    for (string& id : customerIds)
+        id = to_string(1 + rng() % (data.customers.size() + data.customers.size() / 10)); // ~10% misses
+    size_t found = 0;
+    measure("  customer find by id", rows, [&](size_t i) { found += customers.find(customerIds[i]) != nullptr; });
+    if (hits != rows * 3 || found == 0 || found == rows)
+        cerr << "  lookups: unexpected result counts" << endl;
+}
+
+// Customer search on `rows` generated customers: exact email lookup, name
+// prefix and name substring with a 20-result limit, then churn (remove and
+// re-add) to show the indexes stay cheap to maintain.
+static void benchCustomers(size_t rows) {
+    DatasetSpec spec;
+    spec.customers = rows;
+    vector<DataGenerator::Customer> customers = DataGenerator(spec).customers();
+    cout << "customers (" << rows << " customers)" << endl;
+    CustomerIndex index;
+    index.reserve(rows);
+    report("  build indexes", rows, timeMs([&] {
+               for (const auto& c : customers)
+                   index.put(c.id, c.name, c.email);
+           }));
+    mt19937 rng(8);
+    const size_t queries = min<size_t>(rows, 20000);
+    vector<const DataGenerator::Customer*> picks(queries);
+    for (auto& pick : picks)
+        pick = &customers[rng() % customers.size()];
+    size_t found = 0;
+    measure("  find by email (upper case)", queries, [&](size_t i) {
+        string email = picks[i]->email;
+        transform(email.begin(), email.end(), email.begin(), ::toupper);
+        found += index.findByEmail(email) != nullptr;
+    });
+    measure("  name prefix (first name, 20)", queries, [&](size_t i) {
+        const string& name = picks[i]->name;
+        found += index.forEachNamePrefix(string_view(name).substr(0, name.find(' ') + 2), 20,
+                                         [](const string&) {}) > 0;
+    });
+    measure("  name contains (surname, 20)", queries, [&](size_t i) {
+        const string& name = picks[i]->name;
+        found += index.forEachNameContaining(string_view(name).substr(name.find(' ') + 1), 20,
+                                             [](const string&) {}) > 0;
+    });
+    measure("  name contains (rare, 20)", queries, [&](size_t) {
+        found += index.forEachNameContaining("zara q", 20, [](const string&) {}) > 0;
+    });
+    measure("  remove + re-add", queries, [&](size_t i) {
+        index.erase(picks[i]->id);
+        index.put(picks[i]->id, picks[i]->name, picks[i]->email);
+    });
+    if (found != queries * 4 || index.size() != rows)
+        cerr << "  customers: unexpected result counts" << endl;
+}
+
+// Catalog browsing: a category, a subcategory or a price band around a
+// product, each resolved through the product tree, and paging through the
+// whole catalog 20 at a time.
+static void benchBrowse(size_t rows) {
+    Dataset data = makeDataset(rows);
+    ArenaProductTree arena;
+    buildArena(arena, data.products);
+    ProductCatalogIndex index;
+    for (const Product& p : data.products)
+        index.upsert(p);
+    const size_t queries = max<size_t>(20, rows / 1000);
+    cout << "browse (" << data.products.size() << " products, " << queries << " queries each)" << endl;
+    mt19937 rng(4);
+    vector<const Product*> around(queries);
+    for (auto& p : around)
+        p = arena.find(data.popularIds[rng() % data.popularIds.size()]);
+    size_t visited = 0;
+    auto resolve = [&](const string& id) { visited += arena.find(id) != nullptr; };
+    measure("  category listing", queries, [&](size_t i) {
+        index.forEachInCategory(around[i]->category.str(), resolve);
+    });
+    measure("  subcategory listing", queries, [&](size_t i) {
+        index.forEachInSubcategory(around[i]->category.str(), around[i]->subcategory.str(), resolve);
+    });
+    measure("  price band +-500 in category", queries, [&](size_t i) {
+        const Money band = Money::fromMinorUnits(500 * Money::SCALE);
+        index.forEachInPriceRange(around[i]->category.str(), around[i]->price - band, around[i]->price + band,
+                                  resolve);
+    });
+    string token;
+    const size_t pages = (data.products.size() + 19) / 20;
+    measure("  page of 20 (whole catalog)", pages,
+            [&](size_t) { token = arena.forEachPage(token, 20, [&](const Product&) { ++visited; }); });
+    if (visited == 0 || !token.empty())
+        cerr << "  browse: unexpected result counts" << endl;
+}
+
+// Cart churn: popular products added with a stock reservation each and the
+// cart abandoned every five adds, then three-item carts checked out.
+static void benchCart(size_t rows) {
+    Dataset data = makeDataset(rows);
+    ArenaProductTree arena;
+    buildArena(arena, data.products);
+    StockReservations reservations;
+    for (const Product& p : data.products)
+        reservations.setOnHand(p.id, 1 << 30);
+    cout << "cart (" << data.products.size() << " products, " << rows << " adds)" << endl;
+    const vector<string>& ids = data.popularIds;
+    size_t held = 0, committed = 0;
+    Cart cart(&reservations);
+    auto add = [&](size_t i) {
+        const string& id = ids[i % ids.size()];
+        StockReservations::Hold* hold = reservations.reserve(id, 1);
+        held += hold != nullptr;
+        cart.addProduct(*arena.find(id), 1, hold);
+    };
+    measure("  add to cart (reserve)", rows, [&](size_t i) {
+        add(i);
+        if (i % 5 == 4)
+            cart.clearCart();
+    });
+    cart.clearCart();
+    measure("  checkout 3 items (claim + commit)", rows / 3, [&](size_t i) {
+        for (size_t k = 0; k < 3; ++k)
+            add(i * 3 + k);
+        string failed;
+        if (cart.claimHolds(failed))
+            cart.commitHolds([&](const string&, int) { ++committed; });
+        else
+            cart.clearCart();
+    });
+    // Line bookkeeping alone: the same few products added again and again,
+    // the way a shopper fills a cart, emptied every eight adds.
+    Cart churn;
+    size_t lines = 0;
+    measure("  cart churn (no reservation)", rows, [&](size_t i) {
+        churn.addProduct(*arena.find(ids[i % 6 % ids.size()]), 1);
+        if (i % 8 == 7) {
+            lines += churn.getItems().size();
+            churn.clearCart();
+        }
+    });
+    if (held != rows + rows / 3 * 3 || committed != rows / 3 * 3 || lines == 0)
+        cerr << "  cart: unexpected result counts" << endl;
+}
+
+// Order placement as checkout does it after the stock is committed: append
+// to the order history, book the sales rollup, open a shipment. Then
+// lookups by order and tracking id.
+static void benchOrders(size_t rows) {
+    Dataset data = makeDataset(rows);
+    ArenaProductTree arena;
+    buildArena(arena, data.products);
+    vector<Shipment> shipments = DataGenerator(data.spec).shipments(data.orders);
+    fs::path dir = fs::temp_directory_path() / "wearhouse_bench";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "orders");
+    cout << "orders (" << rows << " orders)" << endl;
+    {
+        OrderRepository history((dir / "orders").string());
+        history.open();
+        SalesAggregator sales;
+        ShipmentStore store;
+        auto categoryOf = [&](const string& id) {
+            const Product* p = arena.find(id);
+            return p ? p->category : Symbol();
+        };
+        vector<Order> placing;
+        placing.reserve(rows);
+        for (const Order& order : data.orders)
+            placing.push_back(order.clone());
+        measure("  place order", rows, [&](size_t i) {
+            sales.record(placing[i], categoryOf);
+            history.add(move(placing[i]));
+            store.add(shipments[i]);
+        });
+        mt19937 rng(6);
+        vector<size_t> picks(rows);
+        for (size_t& pick : picks)
+            pick = rng() % rows;
+        size_t found = 0;
+        Order order;
+        measure("  find by order id", rows,
+                [&](size_t i) { found += history.findByOrderId(data.orders[picks[i]].orderId, order); });
+        measure("  find by tracking id", rows,
+                [&](size_t i) { found += history.findByTrackingId(data.orders[picks[i]].trackingId, order); });
+        if (history.size() != rows || found != rows * 2)
+            cerr << "  orders: unexpected result counts" << endl;
+    }
+    fs::remove_all(dir);
+
+    // Orders are move-only; clone() is the explicit deep copy.
+    size_t lines = 0, bytes = 0;
+    vector<Order> copies(rows);
+    measure("  clone order", rows, [&](size_t i) {
+        copies[i] = data.orders[i].clone();
+        lines += copies[i].items.size();
+    });
+    vector<Order> moved(rows);
+    measure("  move order", rows, [&](size_t i) {
+        moved[i] = move(copies[i]);
+        lines += moved[i].items.size();
+    });
+    for (const Order& order : moved)
+        bytes += order.memoryUsage();
+    cout << left << setw(40) << "  memory per order" << right << fixed << setprecision(0)
+         << setw(12) << double(bytes) / max<size_t>(1, rows) << " bytes (" << sizeof(Order) << " inline)" << endl;
+    size_t expected = 0;
+    for (const Order& order : data.orders)
+        expected += order.items.size();
+    if (lines != 2 * expected)
+        cerr << "  orders: unexpected result counts" << endl;
+}
+
+// Order id allocation: leased in blocks of 10000 (one counters file write
+// each), against a durable write per id, and shared by four threads.
+static void benchIds(size_t rows) {
+    fs::path dir = fs::temp_directory_path() / "wearhouse_bench";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const string counters = (dir / "id_counters.txt").string();
+    cout << "ids (" << rows << " ids)" << endl;
+    size_t length = 0;
+    {
+        IdAllocator ids(counters, 2);
+        measure("  allocate + format (lease 10000)", rows, [&](size_t) {
+            uint64_t id;
+            ids.allocate(0, id);
+            length += IdAllocator::format("ORD", id).size();
+        });
+    }
+    {
+        IdAllocator ids(counters, 2, 1);
+        measure("  allocate + format (write per id)", max<size_t>(1, rows / 100), [&](size_t) {
+            uint64_t id;
+            ids.allocate(0, id);
+            length += IdAllocator::format("ORD", id).size();
+        });
+    }
+    const size_t threads = 4;
+    vector<vector<uint64_t>> handed(threads);
+    IdAllocator shared(counters, 2);
+    shared.load();
+    const uint64_t first = shared.peek(1);
+    report("  allocate, 4 threads (lease 10000)", rows, timeMs([&] {
+               vector<thread> workers;
+               for (size_t t = 0; t < threads; ++t) {
+                   workers.emplace_back([&, t] {
+                       handed[t].reserve(rows / threads);
+                       for (size_t i = t; i < rows; i += threads) {
+                           uint64_t id;
+                           shared.allocate(1, id);
+                           handed[t].push_back(id);
+                       }
+                   });
+               }
+               for (thread& worker : workers)
+                   worker.join();
+           }));
+    vector<uint64_t> all;
+    for (const auto& ids : handed)
+        all.insert(all.end(), ids.begin(), ids.end());
+    sort(all.begin(), all.end());
+    if (length == 0 || all.size() != rows || adjacent_find(all.begin(), all.end()) != all.end() ||
+        (!all.empty() && (all.front() != first || all.back() != first + rows - 1)))
+        cerr << "  ids: unexpected result counts" << endl;
+    fs::remove_all(dir);
+}
+
+// Interned categories against plain strings: the heap a catalog of `rows`
+// products takes with each, and a category + subcategory filter over it.
+static void benchSymbols(size_t rows) {
+    DatasetSpec spec;
+    spec.products = max<size_t>(rows, 1);
+    vector<Product> generated = DataGenerator(spec).products();
+    cout << "symbols (" << generated.size() << " products)" << endl;
+    // The Product layout before categories were interned.
+    struct TextProduct {
+        string id, name, category, subcategory;
+        double price;
+        int quantity;
+    };
+    vector<TextProduct> text;
+    report("  copy catalog (string categories)", generated.size(), timeMs([&] {
+               text.reserve(generated.size());
+               for (const Product& p : generated)
+                   text.push_back(
+                       {p.id, p.name, p.category.str(), p.subcategory.str(), p.price.toDouble(), p.quantity});
+           }));
+    const size_t textBytes = lastBytes;
+    vector<Product> interned;
+    report("  copy catalog (symbol categories)", generated.size(), timeMs([&] {
+               interned.reserve(generated.size());
+               for (const Product& p : generated)
+                   interned.push_back(p);
+           }));
+    const size_t symbolBytes = lastBytes;
+    const double mb = 1024.0 * 1024.0;
+    cout << fixed << setprecision(1) << "  catalog heap: " << textBytes / mb << " MB with strings, "
+         << symbolBytes / mb << " MB with symbols (" << sizeof(TextProduct) << " -> " << sizeof(Product)
+         << " bytes per product); pool " << StringPool::global().size() << " strings, "
+         << StringPool::global().memoryUsage() / 1024.0 << " KB" << endl;
+
+    const TextProduct& sample = text[text.size() / 2];
+    size_t textMatches = 0, symbolMatches = 0;
+    report("  filter category + subcategory (strings)", text.size(), timeMs([&] {
+               for (const TextProduct& p : text)
+                   textMatches += p.category == sample.category && p.subcategory == sample.subcategory;
+           }));
+    report("  filter category + subcategory (symbols)", interned.size(), timeMs([&] {
+               Symbol category, subcategory;
+               if (!Symbol::find(sample.category, category) || !Symbol::find(sample.subcategory, subcategory))
+                   return;
+               for (const Product& p : interned)
+                   symbolMatches += p.category == category && p.subcategory == subcategory;
+           }));
+    if (textMatches == 0 || textMatches != symbolMatches)
+        cerr << "  symbols: unexpected result counts" << endl;
+}
+
+// Money paths: the cart's running total against walking its lines, order
+// totals over a date range from the index column against reading the
+// orders, and valuing and repricing a catalog held as columns.
+static void benchMoney(size_t rows) {
+    Dataset data = makeDataset(rows);
+    cout << "money (" << data.products.size() << " products, " << rows << " orders)" << endl;
+    const vector<string>& ids = data.popularIds;
+    ArenaProductTree arena;
+    buildArena(arena, data.products);
+    Cart cart;
+    Money running, walked;
+    measure("  cart add + total (running)", rows, [&](size_t i) {
+        cart.addProduct(*arena.find(ids[i % ids.size()]), 1);
+        running += cart.getTotalPrice();
+        if (i % 4 == 3)
+            cart.clearCart();
+    });
+    const size_t runningBytes = lastBytes;
+    cart.clearCart();
+    measure("  cart add + total (walk lines)", rows, [&](size_t i) {
+        cart.addProduct(*arena.find(ids[i % ids.size()]), 1);
+        Money total;
+        for (const CartItem& item : cart.getItems())
+            total += item.unitPrice * item.quantity;
+        walked += total;
+        if (i % 4 == 3)
+            cart.clearCart();
+    });
+
+    fs::path dir = fs::temp_directory_path() / "wearhouse_bench";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "orders");
+    size_t mismatches = 0;
+    {
+        OrderRepository history((dir / "orders").string(), 0);
+        history.open();
+        for (const Order& order : data.orders)
+            history.add(order.clone(), false);
+        vector<pair<string, string>> ranges;
+        for (const Order& order : data.orders) {
+            if (ranges.size() == 64)
+                break;
+            ranges.push_back({order.timestamp.substr(0, 7), order.timestamp.substr(0, 10)});
+        }
+        vector<Money> fromIndex(ranges.size()), fromOrders(ranges.size());
+        history.totalInTimeRange("", ""); // settle the time order outside the timing
+        measure("  month-to-date total (index column)", ranges.size(), [&](size_t i) {
+            fromIndex[i] = history.totalInTimeRange(ranges[i].first, ranges[i].second);
+        });
+        const size_t rangeBytes = lastBytes;
+        measure("  month-to-date total (read orders)", ranges.size(), [&](size_t i) {
+            history.forEachInTimeRange(ranges[i].first, ranges[i].second,
+                                       [&](const Order& order) { fromOrders[i] += order.totalPrice; });
+        });
+        for (size_t i = 0; i < ranges.size(); ++i)
+            mismatches += fromIndex[i] != fromOrders[i];
+        if (runningBytes != 0 || rangeBytes != 0)
+            cerr << "  money: totals path allocated " << runningBytes + rangeBytes << " bytes" << endl;
+    }
+    fs::remove_all(dir);
+
+    const size_t repeats = max<size_t>(1, 10000000 / max<size_t>(data.products.size(), 1));
+    vector<Money> prices;
+    vector<int32_t> quantities;
+    for (const Product& p : data.products) {
+        prices.push_back(p.price);
+        quantities.push_back(p.quantity);
+    }
+    Money kernelValue;
+    double floatingValue = 0;
+    report("  stock value (columns, kernel)", repeats * prices.size(), timeMs([&] {
+               for (size_t r = 0; r < repeats; ++r)
+                   kernelValue = stockValue(prices.data(), quantities.data(), prices.size());
+           }));
+    report("  stock value (products, double)", repeats * prices.size(), timeMs([&] {
+               for (size_t r = 0; r < repeats; ++r) {
+                   floatingValue = 0;
+                   for (const Product& p : data.products)
+                       floatingValue += p.price.toDouble() * p.quantity;
+               }
+           }));
+    Money reversed;
+    for (size_t i = prices.size(); i-- > 0;)
+        reversed += prices[i] * quantities[i];
+    report("  reprice catalog +5% (scaled)", prices.size(), timeMs([&] {
+               for (Money& price : prices)
+                   price = price.scaled(105, 100);
+           }));
+    cout << "  stock value " << kernelValue << " exact, " << fixed << setprecision(2) << floatingValue
+         << " as double; after +5% " << stockValue(prices.data(), quantities.data(), prices.size()) << endl;
+    if (running != walked || mismatches != 0 || kernelValue != reversed)
+        cerr << "  money: unexpected result counts" << endl;
+}
+
+// Save and reload of each persisted structure, filled from the dataset.
+static void benchPersistence(size_t rows) {
+    Dataset data = makeDataset(rows);
+    fs::path dir = fs::temp_directory_path() / "wearhouse_bench";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "orders");
+    const string productsPath = (dir / "products.txt").string();
+    const string binPath = (dir / "products.bin").string();
+    const string shipmentsPath = (dir / "shipments.txt").string();
+    const string salesPath = (dir / "sales_rollup.txt").string();
+    const size_t products = data.products.size();
+    cout << "persistence (" << products << " products, " << rows << " orders)" << endl;
+
+    ArenaProductTree arena;
+    buildArena(arena, data.products);
+    report("  save products.txt", products, timeMs([&] {
+               ofstream out(productsPath);
+               arena.forEach([&](const Product& p) {
+                   p.writeCsv(out);
+                   out << "\n";
+               });
+           }));
+    size_t loaded = 0;
+    report("  load products.txt", products, timeMs([&] {
+               MappedFile file;
+               file.open(productsPath);
+               CsvTokenizer tokenizer(string_view(file.data(), file.size()));
+               CsvRow row;
+               vector<Product> parsed;
+               Product product;
+               while (tokenizer.next(row)) {
+                   if (Product::fromRow(row, product))
+                       parsed.push_back(move(product));
+               }
+               ArenaProductTree tree;
+               buildArena(tree, parsed);
+               loaded += tree.size();
+           }));
+    report("  save products.bin", products, timeMs([&] {
+               writeProductSnapshot(binPath, arena.size(), [&](const auto& visit) { arena.forEach(visit); });
+           }));
+    report("  load products.bin", products, timeMs([&] {
+               ProductSnapshot snapshot;
+               ArenaProductTree tree;
+               if (snapshot.open(binPath))
+                   tree.buildFromSorted(snapshot.size(), [&](size_t row) { return snapshot.product(row); });
+               loaded += tree.size();
+           }));
+
+    ShipmentStore store;
+    for (const Shipment& s : DataGenerator(data.spec).shipments(data.orders))
+        store.add(s);
+    report("  save shipments", rows, timeMs([&] { store.save(shipmentsPath); }));
+    report("  load shipments", rows, timeMs([&] {
+               ShipmentStore reloaded;
+               reloaded.load(shipmentsPath);
+               loaded += reloaded.size();
+           }));
+
+    SalesAggregator sales;
+    {
+        OrderRepository history((dir / "orders").string());
+        history.open();
+        for (const Order& order : data.orders) {
+            sales.record(order, [&](const string& id) { return arena.find(id)->category; });
+            history.add(order.clone(), false);
+        }
+        history.sync();
+    }
+    report("  save sales rollup", rows, timeMs([&] { sales.save(salesPath); }));
+    report("  load sales rollup", rows, timeMs([&] {
+               SalesAggregator reloaded;
+               reloaded.load(salesPath);
+           }));
+    report("  reopen order history", rows, timeMs([&] {
+               OrderRepository history((dir / "orders").string());
+               history.open();
+               loaded += history.size();
+           }));
+    if (loaded != products * 2 + rows * 2)
+        cerr << "  persistence: unexpected result counts" << endl;
+    fs::remove_all(dir);
+}
+
+int main(int argc, char* argv[]) {
+    const map<string, function<void(size_t)>> scenarios = {
+        {"browse", benchBrowse},
+        {"cart", benchCart},
+        {"coldstart", benchColdStart},
+        {"customers", benchCustomers},
+        {"ids", benchIds},
+        {"index", benchIndex},
+        {"login", benchLogin},
+        {"lookups", benchLookups},
+        {"money", benchMoney},
+        {"orders", benchOrders},
+        {"parse", benchParse},
+        {"persistence", benchPersistence},
+        {"shipments", benchShipments},
+        {"startup", benchStartup},
+        {"symbols", benchSymbols},
+        {"validate", benchValidate},
+    };
+    vector<string> args;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--json")
+            json = true;
+        else
+            args.push_back(argv[i]);
+    }
+    string which = args.size() > 0 ? args[0] : "all";
+    size_t rows = args.size() > 1 ? stoul(args[1]) : 200000;
+    auto it = scenarios.find(which);
+    if (which != "all" && it == scenarios.end()) {
+        cerr << "Unknown scenario: " << which << "\nAvailable:";
+        for (const auto& scenario : scenarios)
+            cerr << " " << scenario.first;
+        cerr << endl;
+        return 1;
+    }
+    streambuf* stdoutBuffer = json ? cout.rdbuf(cerr.rdbuf()) : nullptr;
+    for (const auto& scenario : scenarios) {
+        if (which == "all" || scenario.first == which) {
+            currentScenario = scenario.first;
+            scenario.second(rows);
+        }
+    }
+    if (json) {
+        cout.rdbuf(stdoutBuffer);
+        writeJson(cout, rows);
+    }
+    return 0;
+}
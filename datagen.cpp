@@ -0,0 +1,47 @@
+// datagen.cpp
+// Writes a deterministic synthetic wearhouse/ dataset (see DataGenerator.h)
+// for benchmarks and load tests. Run the application from <dir> afterwards;
+// it imports the generated orders.txt on first start.
+// Build: g++ -std=c++17 -O2 datagen.cpp -o datagen
+// Usage: ./datagen <dir> [--products N] [--customers N] [--orders N] [--zipf S] [--seed N]
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "DataGenerator.h"
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0]
+             << " <dir> [--products N] [--customers N] [--orders N] [--zipf S] [--seed N]" << endl;
+        return 1;
+    }
+    DatasetSpec spec;
+    for (int i = 2; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--products")
+            spec.products = strtoul(value, nullptr, 10);
+        else if (arg == "--customers")
+            spec.customers = strtoul(value, nullptr, 10);
+        else if (arg == "--orders")
+            spec.orders = strtoul(value, nullptr, 10);
+        else if (arg == "--zipf")
+            spec.zipfExponent = atof(value);
+        else if (arg == "--seed")
+            spec.seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+    if (!DataGenerator(spec).write(argv[1]))
+        return 1;
+    cout << "Wrote " << spec.products << " products, " << spec.customers << " customers and " << spec.orders
+         << " orders with shipments to " << argv[1] << "/wearhouse" << endl;
+    return 0;
+}
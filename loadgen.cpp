@@ -0,0 +1,210 @@
+// loadgen.cpp
+// Load generator for server mode. Starts `wearhouse --serve` in a scratch
+// directory for each thread count, drives it from that many client
+// threads (one session each: ADD then ORDER, repeated) and reports
+// orders/sec and checkout latency percentiles.
+// Build: g++ -std=c++17 -O2 -pthread loadgen.cpp -o loadgen
+// Usage: ./loadgen <path-to-wearhouse> [orders-per-thread] [max-threads] [always|interval|never]
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+int main() {
+    std::cerr << "loadgen needs a POSIX system" << std::endl;
+    return 1;
+}
+#else
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+namespace fs = std::filesystem;
+
+// One running server and the sessions waiting on its replies. Each session
+// has at most one request in flight, so replies are matched by session id.
+class ServerConnection {
+private:
+    struct Pending {
+        string reply;
+        bool ready = false;
+    };
+
+    pid_t pid = -1;
+    int toServer = -1;
+    FILE* fromServer = nullptr;
+    thread reader;
+    mutex writeMutex;
+    mutex pendingMutex;
+    condition_variable replied;
+    map<string, Pending> pending;
+
+    void readReplies() {
+        char buffer[65536];
+        while (fgets(buffer, sizeof(buffer), fromServer)) {
+            string line(buffer);
+            if (!line.empty() && line.back() == '\n')
+                line.pop_back();
+            size_t space = line.find(' ');
+            if (space == string::npos)
+                continue;
+            lock_guard<mutex> lock(pendingMutex);
+            auto it = pending.find(line.substr(0, space));
+            if (it == pending.end())
+                continue;
+            it->second.reply = line.substr(space + 1);
+            it->second.ready = true;
+            replied.notify_all();
+        }
+    }
+
+public:
+    bool start(const string& binary, const string& directory, const vector<string>& args) {
+        int in[2], out[2];
+        if (pipe(in) != 0 || pipe(out) != 0)
+            return false;
+        pid = fork();
+        if (pid < 0)
+            return false;
+        if (pid == 0) {
+            dup2(in[0], STDIN_FILENO);
+            dup2(out[1], STDOUT_FILENO);
+            close(in[1]);
+            close(out[0]);
+            if (chdir(directory.c_str()) != 0)
+                _exit(127);
+            FILE* log = freopen("server.log", "w", stderr);
+            (void)log;
+            vector<char*> argv;
+            argv.push_back(const_cast<char*>(binary.c_str()));
+            for (const string& arg : args)
+                argv.push_back(const_cast<char*>(arg.c_str()));
+            argv.push_back(nullptr);
+            execv(binary.c_str(), argv.data());
+            _exit(127);
+        }
+        close(in[0]);
+        close(out[1]);
+        toServer = in[1];
+        fromServer = fdopen(out[0], "r");
+        reader = thread([this] { readReplies(); });
+        return true;
+    }
+
+    string request(const string& session, const string& command) {
+        {
+            lock_guard<mutex> lock(pendingMutex);
+            pending[session] = Pending();
+        }
+        string line = session + " " + command + "\n";
+        {
+            lock_guard<mutex> lock(writeMutex);
+            if (write(toServer, line.data(), line.size()) != static_cast<ssize_t>(line.size()))
+                return "ERR write failed";
+        }
+        unique_lock<mutex> lock(pendingMutex);
+        replied.wait(lock, [&] { return pending[session].ready; });
+        return pending[session].reply;
+    }
+
+    // Closes the server's input, which makes it checkpoint and exit.
+    int stop() {
+        close(toServer);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        reader.join();
+        fclose(fromServer);
+        return status;
+    }
+};
+
+static double percentile(vector<double>& samples, double p) {
+    if (samples.empty())
+        return 0;
+    size_t rank = static_cast<size_t>(p * (samples.size() - 1));
+    nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0]
+             << " <path-to-wearhouse> [orders-per-thread] [max-threads] [always|interval|never]" << endl;
+        return 1;
+    }
+    const string binary = fs::absolute(argv[1]).string();
+    const size_t ordersPerThread = argc > 2 ? stoul(argv[2]) : 500;
+    const size_t maxThreads = argc > 3 ? stoul(argv[3]) : max(1u, thread::hardware_concurrency()) * 2;
+    const string fsyncPolicy = argc > 4 ? argv[4] : "interval";
+    const size_t catalogSize = 100;
+
+    cout << "fsync=" << fsyncPolicy << ", " << ordersPerThread << " orders per client thread" << endl;
+    cout << left << setw(10) << "threads" << right << setw(12) << "orders/s" << setw(12) << "p50 ms"
+         << setw(12) << "p99 ms" << setw(12) << "errors" << endl;
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        fs::path directory = fs::temp_directory_path() / ("wearhouse_loadgen_" + to_string(threads));
+        fs::remove_all(directory);
+        fs::create_directories(directory);
+        ServerConnection server;
+        if (!server.start(binary, directory.string(),
+                          {"--serve", "--threads", to_string(threads), "--fsync", fsyncPolicy})) {
+            cerr << "Could not start " << binary << endl;
+            return 1;
+        }
+        if (server.request("setup", "LOGIN admin Admin@123").rfind("OK", 0) != 0) {
+            cerr << "Admin login failed" << endl;
+            server.stop();
+            return 1;
+        }
+        for (size_t i = 0; i < catalogSize; ++i) {
+            server.request("setup", "PUT L" + to_string(1000 + i) + ",Load Item " + to_string(i) +
+                                        ",Men,Casual," + to_string(500 + i) + ",100000000");
+        }
+
+        vector<vector<double>> latencies(threads);
+        vector<size_t> errors(threads, 0);
+        vector<thread> clients;
+        auto start = chrono::steady_clock::now();
+        for (size_t t = 0; t < threads; ++t) {
+            clients.emplace_back([&, t] {
+                mt19937 rng(static_cast<unsigned>(t + 1));
+                const string session = "client" + to_string(t);
+                latencies[t].reserve(ordersPerThread);
+                for (size_t i = 0; i < ordersPerThread; ++i) {
+                    auto begin = chrono::steady_clock::now();
+                    string added = server.request(session, "ADD L" + to_string(1000 + rng() % catalogSize) + " 1");
+                    string placed = server.request(session, "ORDER Load Client|1 Test Road|0300-1234567|cash");
+                    latencies[t].push_back(
+                        chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count());
+                    if (added.rfind("OK", 0) != 0 || placed.rfind("OK", 0) != 0)
+                        ++errors[t];
+                }
+            });
+        }
+        for (thread& client : clients)
+            client.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        server.stop();
+
+        vector<double> all;
+        size_t errorCount = 0;
+        for (size_t t = 0; t < threads; ++t) {
+            all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+            errorCount += errors[t];
+        }
+        cout << left << setw(10) << threads << right << fixed << setw(12) << setprecision(0)
+             << (all.size() / seconds) << setw(12) << setprecision(3) << percentile(all, 0.50)
+             << setw(12) << percentile(all, 0.99) << setw(12) << errorCount << endl;
+        fs::remove_all(directory);
+    }
+    return 0;
+}
+#endif
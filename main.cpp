@@ -1,345 +1,49 @@
 #include <algorithm>
+#include <charconv>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
-#include <queue>
 #include <sstream>
 #include <string>
 #include <unordered_map>
-#include <regex>
+#include <initializer_list>
 #include <limits>
+#include <memory>
+#include <optional>
+#include <mutex>
+#include <shared_mutex>
+#include <deque>
+#include <thread>
+#include "AtomicFile.h"
 #include "CustomHashTable.h"
+#include "CustomerIndex.h"
+#include "OperationLog.h"
+#include "Product.h"
+#include "ArenaProductTree.h"
+#include "ProductCatalogIndex.h"
+#include "ProductSnapshot.h"
+#include "Cart.h"
+#include "Order.h"
+#include "OrderRepository.h"
+#include "ThreadPool.h"
+#include "StockReservations.h"
+#include "SalesAggregator.h"
+#include "ShipmentStore.h"
+#include "Credentials.h"
+#include "Validators.h"
+#include "MappedFile.h"
+#include "BulkImport.h"
+#include "CsvTokenizer.h"
+#include "StartupScheduler.h"
+#include "CheckpointService.h"
+#include "IdAllocator.h"
+#include "StringPool.h"
+#include "Metrics.h"
 using namespace std;
 namespace fs = std::filesystem;
 
-// Product class
-class Product {
-public:
-    string id, name, category, subcategory;
-    double price;
-    int quantity;
-
-    Product(string _id = "", string _name = "", string _category = "",
-            string _subcategory = "", double _price = 0.0, int _quantity = 0)
-        : id(_id), name(_name), category(_category), subcategory(_subcategory),
-          price(_price), quantity(_quantity) {}
-
-    string toString() const {
-        return "ID: " + id + ", Name: " + name + ", Category: " + category + " - " +
-               subcategory + ", Price: $" + to_string(price) +
-               ", Stock: " + to_string(quantity);
-    }
-
-    bool operator<(const Product& other) const { return id < other.id; }
-    bool operator==(const Product& other) const { return id == other.id; }
-};
-
-// AVL Tree Node for Products
-struct AVLNode {
-    Product data;
-    AVLNode* left;
-    AVLNode* right;
-    int height;
-    AVLNode(const Product& _data)
-        : data(_data), left(nullptr), right(nullptr), height(1) {}
-};
-
-// ProductAVLTree class
-class ProductAVLTree {
-private:
-    AVLNode* root;
-
-    int getHeight(AVLNode* node) const { return node ? node->height : 0; }
-
-    int getBalance(AVLNode* node) const {
-        return node ? getHeight(node->left) - getHeight(node->right) : 0;
-    }
-
-    AVLNode* rightRotate(AVLNode* y) {
-        AVLNode* x = y->left;
-        AVLNode* T2 = x->right;
-        x->right = y;
-        y->left = T2;
-        y->height = max(getHeight(y->left), getHeight(y->right)) + 1;
-        x->height = max(getHeight(x->left), getHeight(x->right)) + 1;
-        return x;
-    }
-
-    AVLNode* leftRotate(AVLNode* x) {
-        AVLNode* y = x->right;
-        AVLNode* T2 = y->left;
-        y->left = x;
-        x->right = T2;
-        x->height = max(getHeight(x->left), getHeight(x->right)) + 1;
-        y->height = max(getHeight(y->left), getHeight(y->right)) + 1;
-        return y;
-    }
-
-    AVLNode* insertNode(AVLNode* node, const Product& product) {
-        if (!node)
-            return new AVLNode(product);
-
-        if (product.id < node->data.id)
-            node->left = insertNode(node->left, product);
-        else if (product.id > node->data.id)
-            node->right = insertNode(node->right, product);
-        else {
-            node->data = product; // Update existing product
-            return node;
-        }
-
-        node->height = max(getHeight(node->left), getHeight(node->right)) + 1;
-        int balance = getBalance(node);
-
-        if (balance > 1 && product.id < node->left->data.id)
-            return rightRotate(node);
-        if (balance < -1 && product.id > node->right->data.id)
-            return leftRotate(node);
-        if (balance > 1 && product.id > node->left->data.id) {
-            node->left = leftRotate(node->left);
-            return rightRotate(node);
-        }
-        if (balance < -1 && product.id < node->right->data.id) {
-            node->right = rightRotate(node->right);
-            return leftRotate(node);
-        }
-        return node;
-    }
-
-    AVLNode* minValueNode(AVLNode* node) {
-        AVLNode* current = node;
-        while (current->left)
-            current = current->left;
-        return current;
-    }
-
-    AVLNode* removeNode(AVLNode* node, const string& id) {
-        if (!node)
-            return node;
-
-        if (id < node->data.id)
-            node->left = removeNode(node->left, id);
-        else if (id > node->data.id)
-            node->right = removeNode(node->right, id);
-        else {
-            if (!node->left || !node->right) {
-                AVLNode* temp = node->left ? node->left : node->right;
-                if (!temp) {
-                    temp = node;
-                    node = nullptr;
-                } else {
-                    *node = *temp;
-                }
-                delete temp;
-            } else {
-                AVLNode* temp = minValueNode(node->right);
-                node->data = temp->data;
-                node->right = removeNode(node->right, temp->data.id);
-            }
-        }
-
-        if (!node)
-            return node;
-
-        node->height = max(getHeight(node->left), getHeight(node->right)) + 1;
-        int balance = getBalance(node);
-
-        if (balance > 1 && getBalance(node->left) >= 0)
-            return rightRotate(node);
-        if (balance > 1 && getBalance(node->left) < 0) {
-            node->left = leftRotate(node->left);
-            return rightRotate(node);
-        }
-        if (balance < -1 && getBalance(node->right) <= 0)
-            return leftRotate(node);
-        if (balance < -1 && getBalance(node->right) > 0) {
-            node->right = rightRotate(node->right);
-            return leftRotate(node);
-        }
-        return node;
-    }
-
-    AVLNode* findNode(AVLNode* node, const string& id) const {
-        if (!node || node->data.id == id)
-            return node;
-        if (id < node->data.id)
-            return findNode(node->left, id);
-        return findNode(node->right, id);
-    }
-
-    void inOrder(AVLNode* node, vector<Product>& result) const {
-        if (node) {
-            inOrder(node->left, result);
-            result.push_back(node->data);
-            inOrder(node->right, result);
-        }
-    }
-
-    void deleteTree(AVLNode* node) {
-        if (node) {
-            deleteTree(node->left);
-            deleteTree(node->right);
-            delete node;
-        }
-    }
-
-public:
-    ProductAVLTree() : root(nullptr) {}
-    ~ProductAVLTree() { deleteTree(root); }
-
-    void insert(const Product& product) { root = insertNode(root, product); }
-
-    bool remove(const string& id) {
-        AVLNode* node = findNode(root, id);
-        if (!node)
-            return false;
-        root = removeNode(root, id);
-        return true;
-    }
-
-    Product* find(const string& id) {
-        AVLNode* node = findNode(root, id);
-        return node ? &node->data : nullptr;
-    }
-
-    vector<Product> getAllProducts() const {
-        vector<Product> result;
-        inOrder(root, result);
-        return result;
-    }
-};
-
-// Linked List Node (generic)
-template <typename T>
-struct Node {
-    T data;
-    Node* next;
-    Node(const T& _data) : data(_data), next(nullptr) {}
-};
-
-// Linked List (generic)
-template <typename T>
-class LinkedList {
-private:
-    Node<T>* head;
-    size_t size;
-
-public:
-    LinkedList() : head(nullptr), size(0) {}
-    ~LinkedList() { clear(); }
-
-    void push_back(const T& item) {
-        Node<T>* newNode = new Node<T>(item);
-        if (!head) {
-            head = newNode;
-        } else {
-            Node<T>* curr = head;
-            while (curr->next)
-                curr = curr->next;
-            curr->next = newNode;
-        }
-        size++;
-    }
-
-    bool remove(const T& item) {
-        Node<T>* curr = head;
-        Node<T>* prev = nullptr;
-        while (curr) {
-            if (curr->data == item) {
-                if (prev) {
-                    prev->next = curr->next;
-                } else {
-                    head = curr->next;
-                }
-                delete curr;
-                size--;
-                return true;
-            }
-            prev = curr;
-            curr = curr->next;
-        }
-        return false;
-    }
-
-    Node<T>* find(const string& id) const {
-        Node<T>* curr = head;
-        while (curr) {
-            if constexpr (is_same_v<T, CartItem>) {
-                if (curr->data.product.id == id)
-                    return curr;
-            } else if constexpr (is_same_v<T, pair<Product, int>>) {
-                if (curr->data.first.id == id)
-                    return curr;
-            }
-            curr = curr->next;
-        }
-        return nullptr;
-    }
-
-    Node<T>* begin() const { return head; }
-    size_t getSize() const { return size; }
-
-    void clear() {
-        Node<T>* curr = head;
-        while (curr) {
-            Node<T>* next = curr->next;
-            delete curr;
-            curr = next;
-        }
-        head = nullptr;
-        size = 0;
-    }
-};
-
-// Cart Item structure
-struct CartItem {
-    Product product;
-    int quantity;
-
-    CartItem(const Product& _product, int _quantity)
-        : product(_product), quantity(_quantity) {}
-    bool operator==(const CartItem& other) const {
-        return product.id == other.product.id;
-    }
-};
-
-// Order class
-class Order {
-public:
-    string orderId, trackingId, timestamp, customerName, customerAddress,
-           customerPhone, paymentMethod;
-    LinkedList<pair<Product, int>> items;
-    double totalPrice;
-
-    Order(string _orderId = "", string _trackingId = "", string _timestamp = "",
-          string _customerName = "", string _customerAddress = "",
-          string _customerPhone = "", string _paymentMethod = "",
-          const LinkedList<pair<Product, int>>& _items = LinkedList<pair<Product, int>>(),
-          double _totalPrice = 0.0)
-        : orderId(_orderId), trackingId(_trackingId), timestamp(_timestamp),
-          customerName(_customerName), customerAddress(_customerAddress),
-          customerPhone(_customerPhone), paymentMethod(_paymentMethod),
-          items(_items), totalPrice(_totalPrice) {}
-
-    string toString() const {
-        stringstream ss;
-        ss << "Order ID: " << orderId << "\nTracking ID: " << trackingId
-           << "\nTimestamp: " << timestamp << "\nCustomer: " << customerName << ", "
-           << customerAddress << ", " << customerPhone
-           << "\nPayment Method: " << paymentMethod << "\nItems:\n";
-        for (Node<pair<Product, int>>* node = items.begin(); node;
-             node = node->next) {
-            const auto& item = node->data;
-            ss << item.first.name << " x " << item.second << " = $"
-               << (item.first.price * item.second) << "\n";
-        }
-        ss << "Total: $" << totalPrice;
-        return ss.str();
-    }
-};
-
 // Customer class
 class Customer {
 public:
@@ -349,206 +53,219 @@ public:
     string toString() const {
         return "ID: " + id + ", Name: " + name + ", Email: " + email;
     }
+
+    // One line of customers.txt: id,name,email
+    string toCsv() const {
+        string line;
+        appendCsvField(line, id);
+        line += ',';
+        appendCsvField(line, name);
+        line += ',';
+        appendCsvField(line, email);
+        return line;
+    }
+
+    static bool fromRow(const CsvRow& row, Customer& customer) {
+        if (row.size() != 3 || row[0].empty())
+            return false;
+        customer = Customer(row.str(0), row.str(1), row.str(2));
+        return true;
+    }
 };
 
 // Specialization for Customer value type
 template <>
-void CustomHashTable<string, Customer>::save(const string& filename) const {
-    ofstream ofs(filename);
-    if (ofs.is_open()) {
-        for (const auto& bucket : table) {
-            for (const auto& node : bucket) {
-                ofs << node.first << "," << node.second.name << "," << node.second.email << "\n";
-            }
-        }
-        ofs.close();
-    } else {
+bool CustomHashTable<string, Customer>::save(const string& filename) const {
+    bool ok = writeFileAtomically(filename, [&](ostream& ofs) {
+        forEach([&](const string&, const Customer& customer) { ofs << customer.toCsv() << "\n"; });
+    });
+    if (!ok)
         cerr << "Error saving to " << filename << endl;
-    }
-}
-
-template <>
-void CustomHashTable<string, Customer>::load(const string& filename) {
-    ifstream ifs(filename);
-    if (ifs.is_open()) {
-        string line;
-        while (getline(ifs, line)) {
-            stringstream ss(line);
-            string id, name, email;
-            getline(ss, id, ',');
-            getline(ss, name, ',');
-            getline(ss, email);
-            insert(id, Customer(id, name, email));
-        }
-        ifs.close();
-    }
+    return ok;
 }
 
 // Customer Hash Table
+// Customers by id, plus CustomerIndex for lookup by email and search by
+// name. Customers are only changed through insert/remove so the indexes
+// stay in step; an email may belong to one customer only.
 class CustomerHashTable {
 private:
     CustomHashTable<string, Customer> table;
+    CustomerIndex index;
     const string CUSTOMERS_FILE = "wearhouse/customers.txt";
 
 public:
     CustomerHashTable() : table(100) {}
 
-    void insert(const Customer& customer) {
+    // Adds or replaces a customer. Returns false, changing nothing, if the
+    // email is already another customer's.
+    bool insert(const Customer& customer) {
+        if (!index.put(customer.id, customer.name, customer.email))
+            return false;
         table.insert(customer.id, customer);
+        return true;
     }
 
     bool remove(const string& id) {
+        index.erase(id);
         return table.remove(id);
     }
 
-    Customer* find(const string& id) {
-        return const_cast<Customer*>(table.find(id)); // Safe cast
-    }
-
-    vector<Customer> getAllCustomers() const {
-        return table.getAll();
-    }
-
-    bool isEmpty() const {
-        return table.isEmpty();
+    const Customer* find(const string& id) const {
+        return table.find(id);
     }
 
-    void save() const {
-        table.save(CUSTOMERS_FILE);
-        cout << "Customers saved successfully." << endl;
+    const Customer* findByEmail(const string& email) const {
+        const string* id = index.findByEmail(email);
+        return id ? table.find(*id) : nullptr;
     }
 
-    void load() {
-        table.load(CUSTOMERS_FILE);
+    // Up to `limit` customers whose name starts with `prefix`, by name.
+    vector<const Customer*> searchNamePrefix(const string& prefix, size_t limit) const {
+        vector<const Customer*> result;
+        index.forEachNamePrefix(prefix, limit, [&](const string& id) { result.push_back(table.find(id)); });
+        return result;
     }
-};
-
-// Sales Hash Table
-class SalesHashTable {
-private:
-    CustomHashTable<string, double> table;
-    const string SALES_FILE = "wearhouse/sales.txt";
-
-public:
-    SalesHashTable() : table(100) {}
 
-    void insert(const string& monthYear, double amount) {
-        double* existing = const_cast<double*>(table.find(monthYear)); // Safe cast
-        if (existing) {
-            *existing += amount;
-            table.insert(monthYear, *existing);
-        } else {
-            table.insert(monthYear, amount);
-        }
+    // Up to `limit` customers whose name contains `text` (any case).
+    vector<const Customer*> searchNameContaining(const string& text, size_t limit) const {
+        vector<const Customer*> result;
+        index.forEachNameContaining(text, limit, [&](const string& id) { result.push_back(table.find(id)); });
+        return result;
     }
 
-    double get(const string& monthYear) const {
-        const double* value = table.find(monthYear); // Now works with const
-        return value ? *value : 0.0;
-    }
+    // Range over const Customer references; no copies.
+    CustomHashTable<string, Customer>::const_iterator begin() const { return table.begin(); }
+    CustomHashTable<string, Customer>::const_iterator end() const { return table.end(); }
 
-    void save() const {
-        table.save(SALES_FILE);
+    template <typename Visit>
+    void forEach(const Visit& visit) const {
+        table.forEach([&](const string&, const Customer& customer) { visit(customer); });
     }
 
-    void load() {
-        table.load(SALES_FILE);
+    // Paged listing; pass 0 to start and the returned token to continue (0 = done).
+    template <typename Visit>
+    size_t forEachPage(size_t resumeToken, size_t limit, const Visit& visit) const {
+        return table.forEachPage(resumeToken, limit,
+                                 [&](const string&, const Customer& customer) { visit(customer); });
     }
-};
-
-// Cart class
-class Cart {
-private:
-    LinkedList<CartItem> items;
-
-public:
-    Cart() {}
 
-    void addProduct(const Product& product, int quantity) {
-        Node<CartItem>* node = items.find(product.id);
-        if (node) {
-            node->data.quantity += quantity;
-        } else {
-            items.push_back(CartItem(product, quantity));
-        }
+    bool isEmpty() const {
+        return table.isEmpty();
     }
 
-    const LinkedList<CartItem>& getItems() const { return items; }
-
-    double getTotalPrice() const {
-        double total = 0.0;
-        for (Node<CartItem>* node = items.begin(); node; node = node->next) {
-            total += node->data.product.price * node->data.quantity;
-        }
-        return total;
+    // A copy of the customers for a checkpoint to save() after it has
+    // released its locks.
+    CustomHashTable<string, Customer> snapshot() const {
+        return table;
     }
 
-    void displayCart() const {
-        if (items.getSize() == 0) {
-            cout << "Cart is empty." << endl;
+    // Parsed in parallel chunks on `pool`; a later line for the same id wins.
+    void load(ThreadPool& pool) {
+        MappedFile file;
+        if (!file.open(CUSTOMERS_FILE))
             return;
-        }
-        cout << "\n--- Cart Contents ---" << endl;
-        for (Node<CartItem>* node = items.begin(); node; node = node->next) {
-            const auto& item = node->data;
-            cout << item.product.name << " x " << item.quantity << " = $"
-                 << (item.product.price * item.quantity) << endl;
-        }
-        cout << "Total: $" << getTotalPrice() << endl;
-    }
-
-    void clearCart() { items.clear(); }
-};
-
-// Comparator for priority_queue
-struct OrderComparator {
-    bool operator()(const Order& a, const Order& b) const {
-        return a.totalPrice < b.totalPrice; // Max-heap: higher totalPrice first
+        vector<size_t> badLines;
+        string error;
+        vector<Customer> rows = parseCsvParallel<Customer>(string_view(file.data(), file.size()), pool,
+                                                           Customer::fromRow, badLines, error);
+        table.reserve(rows.size());
+        index.reserve(rows.size());
+        size_t emailConflicts = 0;
+        for (const Customer& customer : rows) {
+            if (!insert(customer))
+                ++emailConflicts;
+        }
+        warnUnreadableLines(CUSTOMERS_FILE, badLines, error);
+        if (emailConflicts > 0)
+            cerr << "Warning: skipped " << emailConflicts << " customers in " << CUSTOMERS_FILE
+                 << " whose email belongs to another customer" << endl;
     }
 };
 
 // Admin Hash Table
+// Password hashes are made and checked by a pluggable CredentialBackend
+// (PBKDF2 by default). Hashes written by older versions still verify and
+// are replaced with the current backend's format on that login. A login
+// can hand out a session token that later proves the same identity
+// without paying for the KDF again.
 class AdminHashTable {
 private:
     CustomHashTable<string, string> adminHashTable;
     const string ADMIN_FILE = "wearhouse/admins.txt";
+    shared_ptr<const CredentialBackend> backend; // tableMutex; callers hash through a copy
+    LegacyHashBackend legacyBackend;
+    SessionTokenCache tokens;
+    mutable mutex tableMutex; // server sessions log in concurrently
 
-    string hashPassword(const string& password) {
-        hash<string> hasher;
-        return to_string(hasher(password));
+    shared_ptr<const CredentialBackend> currentBackend() const {
+        lock_guard<mutex> lock(tableMutex);
+        return backend;
     }
 
-    bool isValidUsername(const string& username) {
-        regex pattern("^[a-zA-Z0-9_]{4,20}$");
-        return regex_match(username, pattern);
-    }
+public:
+    AdminHashTable() : adminHashTable(100), backend(make_shared<Pbkdf2Backend>()) {}
 
-    bool isValidPassword(const string& password) {
-        regex pattern("^(?=.*[A-Z])(?=.*[a-z])(?=.*[0-9])(?=.*[!@#$%^&*])[A-Za-z0-9!@#$%^&*]{8,}$");
-        return regex_match(password, pattern);
+    // Takes effect for new hashes and for the rehash after each login.
+    void setBackend(unique_ptr<CredentialBackend> newBackend) {
+        lock_guard<mutex> lock(tableMutex);
+        backend = move(newBackend);
     }
 
-public:
-    AdminHashTable() : adminHashTable(100) { loadAdmins(); }
-
+    // The KDF runs outside the lock, so concurrent logins do not queue.
     bool authenticate(const string& username, const string& password) {
-        string* hashedPassword = const_cast<string*>(adminHashTable.find(username));
-        if (hashedPassword) {
-            return *hashedPassword == hashPassword(password);
+        string stored;
+        shared_ptr<const CredentialBackend> current;
+        {
+            lock_guard<mutex> lock(tableMutex);
+            if (const string* found = adminHashTable.find(username))
+                stored = *found;
+            current = backend;
+        }
+        const CredentialBackend* verifier = current->recognizes(stored) ? current.get()
+                                          : legacyBackend.recognizes(stored) ? &legacyBackend : nullptr;
+        if (!verifier) {
+            current->hash(password); // same cost as a wrong password for a real user
+            return false;
         }
-        return false;
+        if (!verifier->verify(password, stored))
+            return false;
+        if (verifier != current.get() || current->needsRehash(stored)) {
+            string upgraded = current->hash(password);
+            lock_guard<mutex> lock(tableMutex);
+            const string* latest = adminHashTable.find(username);
+            if (latest && *latest == stored) {
+                adminHashTable.insert(username, upgraded);
+                saveAdmins();
+            }
+        }
+        return true;
     }
 
+    // authenticate() that also issues a session token for resume().
+    bool login(const string& username, const string& password, string& token) {
+        if (!authenticate(username, password))
+            return false;
+        token = tokens.issue(username);
+        return true;
+    }
+
+    bool resume(const string& token, string& username) const {
+        return tokens.validate(token, username);
+    }
+
+    void logout(const string& token) { tokens.revoke(token); }
+
     bool addAdmin(const string& username, const string& password, const string& confirmPassword) {
-        if (adminHashTable.find(username)) {
+        if (exists(username)) {
             cout << "Username already exists. Choose a different username." << endl;
             return false;
         }
-        if (!isValidUsername(username)) {
+        if (!Validators::isValidUsername(username)) {
             cout << "Username must be 4–20 characters long and contain only letters, numbers, or underscores." << endl;
             return false;
         }
-        if (!isValidPassword(password)) {
+        if (!Validators::isValidPassword(password)) {
             cout << "Password must be at least 8 characters long and include an uppercase letter, lowercase letter, digit, and special character." << endl;
             return false;
         }
@@ -557,45 +274,124 @@ public:
             return false;
         }
 
-        adminHashTable.insert(username, hashPassword(password));
-        saveAdmins();
+        string hashed = currentBackend()->hash(password);
+        {
+            lock_guard<mutex> lock(tableMutex);
+            // Checked again: another session may have taken the name while hashing.
+            if (adminHashTable.find(username)) {
+                cout << "Username already exists. Choose a different username." << endl;
+                return false;
+            }
+            adminHashTable.insert(username, hashed);
+            saveAdmins();
+        }
         cout << "Admin added successfully." << endl;
         return true;
     }
 
+    bool exists(const string& username) const {
+        lock_guard<mutex> lock(tableMutex);
+        return adminHashTable.find(username) != nullptr;
+    }
+
     void saveAdmins() const {
         adminHashTable.save(ADMIN_FILE);
     }
 
     void loadAdmins() {
         if (!fs::exists(ADMIN_FILE)) {
-            adminHashTable.insert("admin", hashPassword("Admin@123"));
+            adminHashTable.insert("admin", currentBackend()->hash("Admin@123"));
             saveAdmins();
             return;
         }
         adminHashTable.load(ADMIN_FILE);
     }
 
-    bool isEmpty() const { return adminHashTable.isEmpty(); }
+    bool isEmpty() const {
+        lock_guard<mutex> lock(tableMutex);
+        return adminHashTable.isEmpty();
+    }
 };
 
 // FaminEcommerce class
 class FaminEcommerce {
 private:
-    ProductAVLTree products;
-    priority_queue<Order, vector<Order>, OrderComparator> orders;
+    ArenaProductTree products;
+    ProductCatalogIndex catalogIndex;
     CustomerHashTable customers;
-    SalesHashTable monthlySales;
+    SalesAggregator sales;
+    ShipmentStore shipments;
     AdminHashTable adminTable;
-    Cart cart;
+    StockReservations reservations;
+    Cart cart{&reservations};
     const string PRODUCTS_FILE = "wearhouse/products.txt";
-    const string ORDERS_FILE = "wearhouse/orders.txt";
+    const string PRODUCTS_SNAPSHOT_FILE = "wearhouse/database/products.bin";
+    const string ORDERS_FILE = "wearhouse/orders.txt"; // legacy, imported once into ORDERS_DIR
+    const string ORDERS_DIR = "wearhouse/database/orders";
     const string CUSTOMERS_FILE = "wearhouse/customers.txt";
-    const string SALES_FILE = "wearhouse/sales.txt";
+    const string SALES_ROLLUP_FILE = "wearhouse/database/sales_rollup.txt";
     const string SHIPMENTS_FILE = "wearhouse/database/shipments.txt";
-    static unsigned long nextOrderId;
-    static unsigned long nextTrackingId;
     const string ID_COUNTERS_FILE = "wearhouse/id_counters.txt";
+    const string SYMBOLS_FILE = "wearhouse/database/symbols.txt"; // StringPool dictionary
+    enum IdSequence : size_t { ORDER_IDS, TRACKING_IDS, ID_SEQUENCES };
+    const uint64_t ID_LEASE_BLOCK = 10000; // ids per durable counters write
+    IdAllocator ids{ID_COUNTERS_FILE, ID_SEQUENCES, ID_LEASE_BLOCK};
+    const string OPS_LOG_FILE = "wearhouse/database/operations.log";
+    const string CHECKPOINT_FILE = "wearhouse/database/checkpoint.txt";
+    const size_t CHECKPOINT_INTERVAL = 500; // log records between snapshot rewrites
+    const size_t PRODUCT_PAGE_SIZE = 50;
+    OperationLog opLog{OPS_LOG_FILE, FsyncPolicy::Always};
+    const size_t ORDER_LIST_LIMIT = 20;
+    const size_t CUSTOMER_SEARCH_LIMIT = 20;
+    OrderRepository orders{ORDERS_DIR};
+    StartupScheduler startup;
+    size_t startupThreads;
+    vector<Order> legacyOrders; // parsed from ORDERS_FILE, added once products are loaded
+    bool salesSnapshotLoaded = false;
+
+    // Locking for server mode and the checkpoint thread (console mode
+    // takes the same locks for its edits, mostly uncontended). Order:
+    // catalogMutex, then journalMutex.
+    //   catalogMutex  - shared to look products up or capture a checkpoint,
+    //                   exclusive to add, change or remove one. The tree
+    //                   stays in the AVL layout, whose lookups do not
+    //                   mutate it.
+    //   journalMutex  - operation log, id counters, orders, sales,
+    //                   customers, shipments, and on-hand stock changes at
+    //                   checkout.
+    // Live stock is kept by `reservations`, which needs no lock to reserve;
+    // the quantity stored in the tree is only refreshed from it on save.
+    mutable shared_mutex catalogMutex;
+    mutable mutex journalMutex;
+
+    // The stores a checkpoint writes, copied under the locks. Empty members
+    // had no changes since the last checkpoint.
+    struct CheckpointCapture {
+        uint64_t lsn = 0;
+        optional<vector<Product>> products; // id order, on-hand stock
+        optional<CustomHashTable<string, Customer>> customers;
+        optional<SalesAggregator> sales;
+        optional<ShipmentStore> shipments;
+        string ordersSegment; // active order segment to fsync, if orders were placed
+    };
+    static constexpr uint32_t ALL_STORES = ~0u;
+    uint32_t unloggedChanges = 0; // journalMutex; OperationLog::opBit()s
+
+    // A connected shopper or admin in server mode.
+    struct Session {
+        explicit Session(StockReservations* reservations) : cart(reservations) {}
+        Cart cart;
+        bool admin = false;
+        deque<string> pending; // commands not yet run, in arrival order
+        bool scheduled = false; // a pool task is draining `pending`
+        bool closed = false;    // the last command run was QUIT
+    };
+    mutex sessionsMutex;
+    unordered_map<string, unique_ptr<Session>> sessions;
+    mutex outputMutex;
+
+    // Declared last so its thread stops before anything it reads goes away.
+    CheckpointService checkpoints{[this] { runCheckpoint(); }};
 
     bool isDirectoryWritable(const string& dirPath) const {
         try {
@@ -632,251 +428,697 @@ private:
     }
 
     void loadIdCounters() {
-        if (!fs::exists(ID_COUNTERS_FILE))
-            return;
-        ifstream ifs(ID_COUNTERS_FILE);
-        if (ifs.is_open()) {
-            string line;
-            if (getline(ifs, line)) {
-                stringstream ss(line);
-                ss >> nextOrderId >> nextTrackingId;
+        if (fs::exists(ID_COUNTERS_FILE))
+            ids.load();
+    }
+
+    // Items from orders.txt files written before unit prices were recorded
+    // take the current catalog price.
+    Order parseOrderLine(string_view line) const {
+        Order order = Order::fromCsv(line);
+        fillLegacyPrices(order);
+        return order;
+    }
+
+    // Orders written before line items carried a unit price get the
+    // product's current price.
+    void fillLegacyPrices(Order& order) const {
+        for (OrderItem& item : order.items) {
+            if (item.unitPrice >= Money())
+                continue;
+            const Product* product = products.find(item.productId);
+            if (product) {
+                item.unitPrice = product->price;
+            } else {
+                item.unitPrice = Money();
+                cerr << "Product ID " << item.productId << " not found for order " << order.orderId << endl;
             }
+        }
+    }
+
+    string productName(const string& id) const {
+        const Product* product = products.find(id);
+        return product ? product->name : id + " (removed)";
+    }
+
+    static Customer parseCustomerLine(string_view line) {
+        Customer customer;
+        CsvRow row;
+        if (CsvTokenizer::splitLine(line, row))
+            Customer::fromRow(row, customer);
+        return customer;
+    }
+
+    uint64_t loadCheckpointLsn() const {
+        uint64_t lsn = 0;
+        ifstream ifs(CHECKPOINT_FILE);
+        if (ifs.is_open()) {
+            ifs >> lsn;
             ifs.close();
+        }
+        return lsn;
+    }
+
+    bool saveCheckpointLsn(uint64_t lsn) const {
+        bool ok = writeFileAtomically(CHECKPOINT_FILE, [&](ostream& ofs) { ofs << lsn << "\n"; });
+        if (!ok)
+            cerr << "Error saving checkpoint to " << CHECKPOINT_FILE << endl;
+        return ok;
+    }
+
+    void applyLogRecord(LogOp op, const string& payload) {
+        switch (op) {
+        case LogOp::ProductPut: {
+            Product product = Product::fromCsv(payload);
+            if (!product.id.empty())
+                putProduct(product);
+            break;
+        }
+        case LogOp::ProductDelete:
+            eraseProduct(payload);
+            break;
+        case LogOp::OrderAdd: {
+            // A crash between writing snapshots and the checkpoint LSN leaves
+            // records the snapshot already contains; add() skips known ids.
+            Order order = parseOrderLine(payload);
+            ids.advancePast(ORDER_IDS, IdAllocator::parse("ORD", order.orderId));
+            ids.advancePast(TRACKING_IDS, IdAllocator::parse("TRK", order.trackingId));
+            addOrder(move(order));
+            break;
+        }
+        case LogOp::CustomerPut: {
+            Customer customer = parseCustomerLine(payload);
+            if (!customer.id.empty())
+                customers.insert(customer);
+            break;
+        }
+        case LogOp::CustomerDelete:
+            customers.remove(payload);
+            break;
+        case LogOp::SalesSet:
+            // Written by older versions; sales are now derived from the
+            // orders themselves.
+            break;
+        case LogOp::ShipmentPut: {
+            Shipment shipment;
+            if (ShipmentStore::parseLine(payload, shipment))
+                shipments.add(shipment);
+            break;
+        }
+        case LogOp::ShipmentAdvance: {
+            size_t comma = payload.find(',');
+            ShipmentStatus status;
+            if (comma != string::npos && ShipmentStore::parseStatus(string_view(payload).substr(comma + 1), status))
+                shipments.advance(string_view(payload).substr(0, comma), status);
+            break;
+        }
+        case LogOp::IdCounters: {
+            // Written by older versions: the next id of each sequence. Ids
+            // are now leased in blocks through `ids` instead.
+            CsvRow row;
+            uint64_t orderId = 0, trackingId = 0;
+            if (!CsvTokenizer::splitLine(payload, row, ' ') || !row.number(0, orderId) || !row.number(1, trackingId))
+                break;
+            if (orderId > 0)
+                ids.advancePast(ORDER_IDS, orderId - 1);
+            if (trackingId > 0)
+                ids.advancePast(TRACKING_IDS, trackingId - 1);
+            break;
+        }
+        }
+    }
+
+    void replayLog() {
+        size_t applied = opLog.replay(loadCheckpointLsn(), [this](LogOp op, const string& payload) {
+            applyLogRecord(op, payload);
+        });
+        if (applied > 0)
+            cout << "Recovered " << applied << " operations from " << OPS_LOG_FILE << endl;
+    }
+
+    // Makes the buffered log records durable and asks the checkpoint
+    // service to compact the log into the snapshots once enough records
+    // have accumulated; the caller does not wait for that.
+    // Must be called without holding any of the locks above.
+    void commitLog() {
+        METRIC_TIME(CommitLog);
+        bool due;
+        {
+            lock_guard<mutex> journal(journalMutex);
+            opLog.commit();
+            due = opLog.recordsSinceCheckpoint() >= CHECKPOINT_INTERVAL;
+        }
+        if (due)
+            checkpoints.request();
+    }
+
+    // Checkpoints on the calling thread. `unlogged` names, as
+    // OperationLog::opBit()s, the stores changed without log records (bulk
+    // imports, rebuilt rollups) so they are written too.
+    // Must be called without holding any of the locks above.
+    void checkpoint(uint32_t unlogged = 0) {
+        {
+            lock_guard<mutex> journal(journalMutex);
+            unloggedChanges |= unlogged;
+        }
+        checkpoints.runNow();
+    }
+
+    // Run by `checkpoints`, one at a time. Only the stores with log records
+    // (or unlogged changes) since the last checkpoint are copied, under the
+    // locks, and the log is rotated there. The copies are written to
+    // temporary files, fsynced and renamed into place with the locks
+    // released, and the rotated log is dropped after the checkpoint LSN.
+    // A crash before that replays it; a failed write makes the next
+    // checkpoint rewrite everything.
+    void runCheckpoint() {
+        METRIC_TIME(Checkpoint);
+        CheckpointCapture capture;
+        if (!captureCheckpoint(capture))
+            return;
+        METRIC_ADD(Checkpoints, 1);
+        if (writeCheckpoint(capture)) {
+            opLog.dropRotated();
         } else {
-            cerr << "Warning: Could not open " << ID_COUNTERS_FILE << endl;
+            lock_guard<mutex> journal(journalMutex);
+            unloggedChanges = ALL_STORES;
         }
     }
 
-    void saveIdCounters() const {
-        ofstream ofs(ID_COUNTERS_FILE);
-        if (ofs.is_open()) {
-            ofs << nextOrderId << " " << nextTrackingId << "\n";
-            ofs.close();
-        } else {
-            cerr << "Error saving ID counters to " << ID_COUNTERS_FILE << endl;
-        }
-    }
-
-    string generateOrderId() {
-        string currentId = to_string(nextOrderId);
-        string id = "ORD" + string(6 - currentId.length(), '0') + currentId;
-        nextOrderId++;
-        saveIdCounters();
-        return id;
-    }
-
-    string generateTrackingId() {
-        string currentId = to_string(nextTrackingId);
-        string id = "TRK" + string(6 - currentId.length(), '0') + currentId;
-        nextTrackingId++;
-        saveIdCounters();
-        return id;
-    }
-
-    void loadProducts() {
-        if (fs::exists(PRODUCTS_FILE)) {
-            ifstream ifs(PRODUCTS_FILE);
-            if (ifs.is_open()) {
-                string line;
-                while (getline(ifs, line)) {
-                    stringstream ss(line);
-                    string id, name, category, subcategory;
-                    double price;
-                    int quantity;
-                    getline(ss, id, ',');
-                    getline(ss, name, ',');
-                    getline(ss, category, ',');
-                    getline(ss, subcategory, ',');
-                    ss >> price;
-                    ss.ignore();
-                    ss >> quantity;
-                    products.insert(Product(id, name, category, subcategory, price, quantity));
-                }
-                ifs.close();
-            } else {
-                cerr << "Warning: Could not open " << PRODUCTS_FILE << endl;
+    // Returns false if nothing changed since the last checkpoint.
+    bool captureCheckpoint(CheckpointCapture& capture) {
+        METRIC_TIME(CheckpointCapture);
+        shared_lock<shared_mutex> catalog(catalogMutex);
+        lock_guard<mutex> journal(journalMutex);
+        opLog.commit();
+        const uint32_t changed = opLog.opsSinceRotate() | unloggedChanges;
+        if (changed == 0)
+            return false;
+        auto any = [changed](initializer_list<LogOp> ops) {
+            for (LogOp op : ops) {
+                if (changed & OperationLog::opBit(op))
+                    return true;
             }
+            return false;
+        };
+        capture.lsn = opLog.lastLsn();
+        if (any({LogOp::ProductPut, LogOp::ProductDelete})) {
+            capture.products.emplace();
+            capture.products->reserve(products.size());
+            products.forEach([&](const Product& p) { capture.products->push_back(withStock(p, true)); });
+        }
+        if (any({LogOp::CustomerPut, LogOp::CustomerDelete}))
+            capture.customers.emplace(customers.snapshot());
+        if (any({LogOp::OrderAdd})) {
+            capture.ordersSegment = orders.flush();
+            capture.sales.emplace(sales);
+        }
+        if (any({LogOp::ShipmentPut, LogOp::ShipmentAdvance}))
+            capture.shipments.emplace(shipments);
+        unloggedChanges = 0;
+        opLog.rotate();
+        return true;
+    }
+
+    // Writes a capture; the checkpoint LSN only moves once everything else
+    // is on disk. Takes no locks.
+    bool writeCheckpoint(const CheckpointCapture& capture) const {
+        bool ok = true;
+        uintmax_t bytes = 0;
+        if (capture.products) {
+            ok = writeProductFiles(*capture.products) && ok;
+            bytes += fileBytes(PRODUCTS_FILE) + fileBytes(PRODUCTS_SNAPSHOT_FILE);
+        }
+        if (!capture.ordersSegment.empty()) {
+            METRIC_TIME(SaveOrders);
+            ok = StringPool::global().save(SYMBOLS_FILE) && ok; // payment methods
+            ok = (!fs::exists(capture.ordersSegment) || syncPath(capture.ordersSegment)) && ok;
+        }
+        if (capture.customers) {
+            ok = capture.customers->save(CUSTOMERS_FILE) && ok;
+            bytes += fileBytes(CUSTOMERS_FILE);
+        }
+        if (capture.sales) {
+            ok = capture.sales->save(SALES_ROLLUP_FILE) && ok;
+            bytes += fileBytes(SALES_ROLLUP_FILE);
+        }
+        if (capture.shipments) {
+            ok = capture.shipments->save(SHIPMENTS_FILE) && ok;
+            bytes += fileBytes(SHIPMENTS_FILE);
+        }
+        METRIC_ADD(CheckpointBytes, bytes);
+        return ok && saveCheckpointLsn(capture.lsn);
+    }
+
+    // ORD000001 onwards; past ORD999999 the ids just get longer. False if
+    // no id could be leased.
+    bool generateOrderId(string& id) {
+        uint64_t number;
+        if (!ids.allocate(ORDER_IDS, number))
+            return false;
+        id = IdAllocator::format("ORD", number);
+        return true;
+    }
+
+    bool generateTrackingId(string& id) {
+        uint64_t number;
+        if (!ids.allocate(TRACKING_IDS, number))
+            return false;
+        id = IdAllocator::format("TRK", number);
+        return true;
+    }
+
+    // Every catalog mutation goes through these two so the secondary
+    // indexes and the stock ledger stay in step with the tree. Stock levels
+    // are not indexed; queries read them live from `reservations`. Both
+    // refuse, changing nothing, to leave less stock than carts hold.
+    bool putProduct(const Product& product) {
+        if (!reservations.setOnHand(product.id, product.quantity))
+            return false;
+        products.insert(product);
+        catalogIndex.upsert(product);
+        return true;
+    }
+
+    bool eraseProduct(const string& id) {
+        if (!products.find(id) || !reservations.setOnHand(id, 0))
+            return false;
+        catalogIndex.erase(id);
+        return products.remove(id);
+    }
+
+    string heldMessage(const string& id) const {
+        return to_string(reservations.held(id)) + " units of " + id + " are reserved in carts.";
+    }
+
+    // A copy of `product` carrying live stock: what customers can still
+    // reserve, or with onHand the units in the warehouse.
+    Product withStock(const Product& product, bool onHand = false) const {
+        Product live = product;
+        live.quantity = onHand ? reservations.onHand(product.id) : reservations.available(product.id);
+        return live;
+    }
+
+    // The binary snapshot is preferred unless products.txt was edited after it.
+    bool productSnapshotIsCurrent() const {
+        try {
+            return fs::exists(PRODUCTS_SNAPSHOT_FILE) &&
+                   (!fs::exists(PRODUCTS_FILE) ||
+                    fs::last_write_time(PRODUCTS_SNAPSHOT_FILE) >= fs::last_write_time(PRODUCTS_FILE));
+        } catch (const fs::filesystem_error&) {
+            return false;
+        }
+    }
+
+    // Replaces the catalog with `count` products sorted by id.
+    template <typename RowSource>
+    void buildCatalog(size_t count, const RowSource& row) {
+        catalogIndex.clear();
+        products.buildFromSorted(count, [&](size_t i) {
+            Product product = row(i);
+            catalogIndex.upsert(product);
+            reservations.setOnHand(product.id, product.quantity);
+            return product;
+        });
+    }
+
+    bool loadProductSnapshot() {
+        ProductSnapshot snapshot;
+        if (!snapshot.open(PRODUCTS_SNAPSHOT_FILE))
+            return false;
+        buildCatalog(snapshot.size(), [&](size_t row) { return snapshot.product(row); });
+        return true;
+    }
+
+    // products.txt is tokenized in parallel chunks, then sorted by id (a
+    // later line for the same id wins) and bulk-built like the snapshot.
+    void loadProductsCsv(ThreadPool& pool) {
+        MappedFile file;
+        if (!file.open(PRODUCTS_FILE)) {
+            cerr << "Warning: Could not open " << PRODUCTS_FILE << endl;
+            return;
         }
+        vector<size_t> badLines;
+        string error;
+        vector<Product> rows = parseCsvParallel<Product>(string_view(file.data(), file.size()), pool,
+                                                         Product::fromRow, badLines, error);
+        warnUnreadableLines(PRODUCTS_FILE, badLines, error);
+        stable_sort(rows.begin(), rows.end());
+        size_t unique = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (unique > 0 && rows[unique - 1].id == rows[i].id)
+                rows[unique - 1] = move(rows[i]);
+            else if (unique++ != i)
+                rows[unique - 1] = move(rows[i]);
+        }
+        buildCatalog(unique, [&](size_t i) { return rows[i]; });
+    }
+
+    void loadProducts(ThreadPool& pool) {
+        METRIC_TIME(LoadProducts);
+        bool fromSnapshot = productSnapshotIsCurrent() && loadProductSnapshot();
+        if (!fromSnapshot && fs::exists(PRODUCTS_FILE))
+            loadProductsCsv(pool);
         if (!products.find("1")) {
-            products.insert(Product("1", "Lablis", "Women", "Eid Edition", 25700.00, 10));
-            products.insert(Product("2", "T-Shirt", "Men", "Casual", 1500.00, 20));
+            putProduct(Product("1", "Lablis", "Women", "Eid Edition", Money::fromMinorUnits(2570000), 10));
+            putProduct(Product("2", "T-Shirt", "Men", "Casual", Money::fromMinorUnits(150000), 20));
             saveProducts();
         }
     }
 
-    void saveProducts() const {
-        ofstream ofs(PRODUCTS_FILE);
-        if (ofs.is_open()) {
-            auto allProducts = products.getAllProducts();
-            for (const auto& p : allProducts) {
-                ofs << p.id << "," << p.name << "," << p.category << ","
-                    << p.subcategory << "," << p.price << "," << p.quantity << "\n";
+    static uintmax_t fileBytes(const string& path) {
+        error_code ec;
+        uintmax_t size = fs::file_size(path, ec);
+        return ec ? 0 : size;
+    }
+
+    // products.txt and then the binary snapshot, from rows in id order
+    // carrying on-hand stock, so the snapshot is never older than the text.
+    bool writeProductFiles(const vector<Product>& rows) const {
+        METRIC_TIME(SaveProducts);
+        // The symbol dictionary goes first, so it always covers the files.
+        bool ok = StringPool::global().save(SYMBOLS_FILE);
+        ok = ok && writeFileAtomically(PRODUCTS_FILE, [&](ostream& ofs) {
+            for (const Product& p : rows) {
+                p.writeCsv(ofs);
+                ofs << "\n";
             }
-            ofs.close();
-            cout << "Products saved successfully." << endl;
-        } else {
+        });
+        ok = ok && writeProductSnapshot(PRODUCTS_SNAPSHOT_FILE, rows.size(), [&](const auto& visit) {
+            for (const Product& p : rows)
+                visit(p);
+        });
+        if (!ok)
             cerr << "Error saving products to " << PRODUCTS_FILE << endl;
-        }
+        return ok;
+    }
+
+    void saveProducts() const {
+        vector<Product> rows;
+        rows.reserve(products.size());
+        products.forEach([&](const Product& p) { rows.push_back(withStock(p, true)); });
+        if (writeProductFiles(rows))
+            cout << "Products saved successfully." << endl;
     }
 
-    void loadOrders() {
-        if (!fs::exists(ORDERS_FILE))
+    // Order history lives in segment files under ORDERS_DIR. An orders.txt
+    // from an older version is imported into it once and then left alone;
+    // it is only parsed here, since its prices may need the catalog (see
+    // resolveLegacyOrders).
+    void loadOrders(ThreadPool& pool) {
+        METRIC_TIME(LoadOrders);
+        if (!orders.open(&pool)) {
+            cerr << "Warning: Could not open order history in " << ORDERS_DIR << endl;
             return;
-        ifstream ifs(ORDERS_FILE);
-        if (ifs.is_open()) {
-            string line;
-            while (getline(ifs, line)) {
-                stringstream ss(line);
-                string orderId, trackingId, timestamp, customerName, customerAddress,
-                       customerPhone, paymentMethod, itemsStr;
-                double totalPrice;
-                getline(ss, orderId, ',');
-                getline(ss, trackingId, ',');
-                getline(ss, timestamp, ',');
-                getline(ss, customerName, ',');
-                getline(ss, customerAddress, ',');
-                getline(ss, customerPhone, ',');
-                getline(ss, paymentMethod, ',');
-                ss >> totalPrice;
-                ss.ignore();
-                getline(ss, itemsStr);
-                LinkedList<pair<Product, int>> orderItems;
-                stringstream itemsSs(itemsStr);
-                string item;
-                while (getline(itemsSs, item, ';')) {
-                    if (item.empty())
-                        continue;
-                    size_t colonPos = item.find(':');
-                    if (colonPos == string::npos)
-                        continue;
-                    string productId = item.substr(0, colonPos);
-                    int quantity;
-                    try {
-                        quantity = stoi(item.substr(colonPos + 1));
-                    } catch (...) {
-                        cerr << "Invalid quantity in order items: " << item << endl;
-                        continue;
-                    }
-                    Product* product = products.find(productId);
-                    if (product) {
-                        orderItems.push_back({*product, quantity});
-                    } else {
-                        cerr << "Product ID " << productId << " not found for order " << orderId << endl;
-                    }
-                }
-                orders.push(Order(orderId, trackingId, timestamp, customerName, customerAddress, customerPhone, paymentMethod, orderItems, totalPrice));
-            }
-            ifs.close();
-        } else {
+        }
+        if (!orders.empty() || !fs::exists(ORDERS_FILE))
+            return;
+        MappedFile file;
+        if (!file.open(ORDERS_FILE)) {
             cerr << "Warning: Could not open " << ORDERS_FILE << endl;
+            return;
         }
+        vector<size_t> badLines;
+        string error;
+        legacyOrders = parseCsvParallel<Order>(string_view(file.data(), file.size()), pool, Order::fromRow,
+                                               badLines, error);
+        warnUnreadableLines(ORDERS_FILE, badLines, error);
     }
 
-    void saveOrders() const {
-        ofstream ofs(ORDERS_FILE);
-        if (ofs.is_open()) {
-            priority_queue<Order, vector<Order>, OrderComparator> temp = orders;
-            while (!temp.empty()) {
-                const Order& order = temp.top();
-                ofs << order.orderId << "," << order.trackingId << ","
-                    << order.timestamp << "," << order.customerName << ","
-                    << order.customerAddress << "," << order.customerPhone << ","
-                    << order.paymentMethod << "," << order.totalPrice;
-                string itemsStr;
-                for (Node<pair<Product, int>>* node = order.items.begin(); node;
-                     node = node->next) {
-                    if (!itemsStr.empty())
-                        itemsStr += ";";
-                    itemsStr += node->data.first.id + ":" + to_string(node->data.second);
-                }
-                ofs << "," << itemsStr << "\n";
-                temp.pop();
-            }
-            ofs.close();
-            cout << "Orders saved successfully." << endl;
-        } else {
-            cerr << "Error saving orders to " << ORDERS_FILE << endl;
+    // Join of the products and orders phases: prices the parsed legacy
+    // orders from the catalog and appends them to the history.
+    void resolveLegacyOrders() {
+        if (legacyOrders.empty())
+            return;
+        size_t imported = 0;
+        for (Order& order : legacyOrders) {
+            fillLegacyPrices(order);
+            if (orders.add(move(order), false))
+                ++imported;
         }
+        legacyOrders = vector<Order>();
+        orders.sync();
+        cout << "Imported " << imported << " orders from " << ORDERS_FILE << endl;
+    }
+
+    void loadCustomers(ThreadPool& pool) {
+        customers.load(pool);
     }
 
-    void loadCustomers() {
-        customers.load();
+    Symbol productCategory(const string& id) const {
+        static const Symbol uncategorized("Uncategorized");
+        const Product* product = products.find(id);
+        return product ? product->category : uncategorized;
     }
 
-    void saveCustomers() const {
-        customers.save();
+    // Books the sale and moves the order into the history, unless its id is
+    // already there.
+    bool addOrder(Order order, bool flush = true) {
+        if (orders.contains(order.orderId))
+            return false;
+        recordSale(order);
+        return orders.add(move(order), flush);
+    }
+
+    void recordSale(const Order& order) {
+        sales.record(order, [this](const string& id) { return productCategory(id); });
     }
 
-    void loadSales() {
-        monthlySales.load();
+    // Drops the rollups and replays the whole order history into them.
+    void rebuildSales() {
+        sales.clear();
+        orders.forEachPlacedSince(0, [this](const Order& order) { recordSale(order); });
     }
 
-    void saveSales() const {
-        monthlySales.save();
+    void loadSalesSnapshot() {
+        salesSnapshotLoaded = sales.load(SALES_ROLLUP_FILE);
+    }
+
+    // The rollup snapshot remembers how many orders it covers, so only the
+    // orders placed after the last checkpoint are replayed. A snapshot that
+    // claims more orders than the history holds is rebuilt from scratch.
+    // Needs the snapshot, the order history and the catalog (categories).
+    void catchUpSales() {
+        if (!salesSnapshotLoaded || sales.ordersRecorded() > orders.size()) {
+            rebuildSales();
+            return;
+        }
+        orders.forEachPlacedSince(sales.ordersRecorded(), [this](const Order& order) { recordSale(order); });
+    }
+
+    void loadShipments() {
+        if (fs::exists(SHIPMENTS_FILE) && !shipments.load(SHIPMENTS_FILE))
+            cerr << "Warning: Could not open " << SHIPMENTS_FILE << endl;
     }
 
     void displayProducts() const {
-        auto allProducts = products.getAllProducts();
-        if (allProducts.empty()) {
+        if (products.size() == 0) {
             cout << "No products available." << endl;
             return;
         }
         cout << "\n--- Products ---" << endl;
-        for (const auto& p : allProducts) {
-            cout << p.toString() << endl;
+        string token;
+        while (true) {
+            token = products.forEachPage(token, PRODUCT_PAGE_SIZE,
+                                         [this](const Product& p) { cout << withStock(p).toString() << endl; });
+            if (token.empty())
+                break;
+            cout << "Show more products? (yes/no): ";
+            string more;
+            getline(cin, more);
+            transform(more.begin(), more.end(), more.begin(), ::tolower);
+            if (more != "yes")
+                break;
         }
     }
 
     void filterAndDisplayProducts(const string& category) const {
-        auto allProducts = products.getAllProducts();
         bool found = false;
         cout << "\n--- " << category << " Products ---" << endl;
-        for (const auto& p : allProducts) {
-            if (p.category == category) {
-                cout << p.toString() << endl;
+        catalogIndex.forEachInCategory(category, [&](const string& id) {
+            if (const Product* p = products.find(id)) {
+                cout << withStock(*p).toString() << endl;
                 found = true;
             }
-        }
+        });
         if (!found) {
             cout << "No products in category: " << category << endl;
         }
     }
 
-    void addToCart(const string& productId, int quantity) {
-        if (quantity <= 0) {
-            cout << "Quantity must be positive." << endl;
+    void searchProducts() const {
+        cout << "\n--- Search Products ---" << endl;
+        string category, subcategory, minStr, maxStr, inStock;
+        cout << "Category (Men/Women, or press Enter for any): ";
+        getline(cin, category);
+        cout << "Subcategory (or press Enter for any): ";
+        getline(cin, subcategory);
+        cout << "Minimum price (or press Enter for none): ";
+        getline(cin, minStr);
+        cout << "Maximum price (or press Enter for none): ";
+        getline(cin, maxStr);
+        cout << "In stock only? (yes/no): ";
+        getline(cin, inStock);
+        Money minPrice, maxPrice = Money::max();
+        if ((!minStr.empty() && !Money::parse(minStr, minPrice)) ||
+            (!maxStr.empty() && !Money::parse(maxStr, maxPrice))) {
+            cout << "Prices must be valid numbers." << endl;
             return;
         }
-        Product* product = products.find(productId);
+        transform(inStock.begin(), inStock.end(), inStock.begin(), ::tolower);
+        bool inStockOnly = inStock == "yes";
+        size_t matches = 0;
+        cout << "\n--- Matching Products (Cheapest First) ---" << endl;
+        // A subcategory no product has ever used matches nothing.
+        Symbol wantedSubcategory;
+        bool anySubcategory = subcategory.empty();
+        if (anySubcategory || Symbol::find(subcategory, wantedSubcategory)) {
+            catalogIndex.forEachInPriceRange(category, minPrice, maxPrice, [&](const string& id) {
+                const Product* p = products.find(id);
+                if (!p || (inStockOnly && reservations.available(id) <= 0) ||
+                    (!anySubcategory && p->subcategory != wantedSubcategory))
+                    return;
+                cout << withStock(*p).toString() << endl;
+                matches++;
+            });
+        }
+        if (matches == 0) {
+            cout << "No matching products." << endl;
+        }
+    }
+
+    // Reserves `quantity` units of a product into `targetCart`. Nothing is
+    // written to disk until checkout; unclaimed reservations expire.
+    // `message` says what was added or why nothing was.
+    bool reserveToCart(Cart& targetCart, const string& productId, int quantity, string& message) {
+        if (quantity <= 0) {
+            message = "Quantity must be positive.";
+            return false;
+        }
+        shared_lock<shared_mutex> catalog(catalogMutex);
+        const Product* product = products.find(productId);
         if (!product) {
-            cout << "Product ID " << productId << " not found." << endl;
-        } else if (product->quantity < quantity) {
-            cout << "Insufficient stock for " << product->name
-                 << ". Available: " << product->quantity << endl;
-        } else {
-            cart.addProduct(*product, quantity);
-            product->quantity -= quantity;
-            products.insert(*product);
-            saveProducts();
-            cout << quantity << " x " << product->name << " added to cart." << endl;
+            message = "Product ID " + productId + " not found.";
+            return false;
+        }
+        StockReservations::Hold* hold = reservations.reserve(productId, quantity);
+        if (!hold) {
+            message = "Insufficient stock for " + product->name +
+                      ". Available: " + to_string(reservations.available(productId));
+            return false;
         }
+        targetCart.addProduct(*product, quantity, hold);
+        message = to_string(quantity) + " x " + product->name + " added to cart.";
+        return true;
+    }
+
+    static bool validCustomerDetails(const string& name, const string& address, const string& phone,
+                                     string& error) {
+        if (name.empty() || address.empty() || phone.empty()) {
+            error = "All customer details are required.";
+            return false;
+        }
+        if (!Validators::isValidField(name) || !Validators::isValidField(address, 200)) {
+            error = "Name and address cannot contain '|'.";
+            return false;
+        }
+        if (!Validators::isValidPhone(phone)) {
+            error = "Phone must have 7-15 digits (spaces, dashes and a leading + allowed).";
+            return false;
+        }
+        return true;
+    }
+
+    // What the shopper is told about a placed order.
+    struct Receipt {
+        string orderId, trackingId;
+        Money total;
+    };
+
+    // Turns `sourceCart` into an order and empties it. The cart's
+    // reservations are claimed first, so either every unit is sold or none.
+    // The order itself is moved into the history.
+    bool checkout(Cart& sourceCart, const string& name, const string& address, const string& phone,
+                  const string& paymentMethod, Receipt& receipt, string& error) {
+        METRIC_TIME(PlaceOrder);
+        if (sourceCart.getItems().empty()) {
+            error = "Cart is empty.";
+            return false;
+        }
+        if (!validCustomerDetails(name, address, phone, error))
+            return false;
+        OrderItems orderItems;
+        orderItems.reserve(sourceCart.getItems().size());
+        for (const CartItem& item : sourceCart.getItems())
+            orderItems.push_back({item.productId, item.quantity, item.unitPrice});
+        {
+            shared_lock<shared_mutex> catalog(catalogMutex);
+            lock_guard<mutex> journal(journalMutex);
+            // Ids first: a failed claim only skips them, but nothing may
+            // fail once the holds are claimed.
+            string orderId, trackingId;
+            if (!generateOrderId(orderId) || !generateTrackingId(trackingId)) {
+                error = "Could not assign an order ID; check that " + ID_COUNTERS_FILE + " is writable.";
+                return false;
+            }
+            // A product deleted since it was added to the cart has no holds
+            // left to claim but is checked by name: nothing may be sold
+            // that is no longer in the catalog.
+            for (const CartItem& item : sourceCart.getItems()) {
+                if (!products.find(item.productId)) {
+                    error = item.productId + " is no longer sold; clear the cart and try again.";
+                    return false;
+                }
+            }
+            string unavailable;
+            if (!sourceCart.claimHolds(unavailable)) {
+                const Product* product = products.find(unavailable);
+                error = "Reservation expired and " + (product ? product->name : unavailable) +
+                        " is no longer available. Available: " + to_string(reservations.available(unavailable));
+                return false;
+            }
+            time_t now = time(nullptr);
+            char timestamp[20];
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+            Order placed(orderId, trackingId, timestamp, name, address, phone, paymentMethod, move(orderItems),
+                         sourceCart.getTotalPrice());
+            sourceCart.commitHolds([&](const string& productId, int onHand) {
+                Product sold = *products.find(productId); // checked above, under the same lock
+                sold.quantity = onHand;
+                opLog.append(LogOp::ProductPut, sold.toCsv());
+            });
+            opLog.append(LogOp::OrderAdd, placed.toCsv());
+            receipt = Receipt{orderId, trackingId, placed.totalPrice};
+            addOrder(move(placed));
+            Shipment shipment{orderId, trackingId, name, address, ShipmentStatus::InProgress};
+            shipments.add(shipment);
+            opLog.append(LogOp::ShipmentPut, ShipmentStore::toLine(shipment));
+        }
+        commitLog();
+        METRIC_ADD(OrdersPlaced, 1);
+        return true;
+    }
+
+    void addToCart(const string& productId, int quantity) {
+        string message;
+        reserveToCart(cart, productId, quantity, message);
+        cout << message << endl;
     }
 
     void placeOrder() {
-        if (cart.getItems().getSize() == 0) {
+        if (cart.getItems().empty()) {
             cout << "Cart is empty." << endl;
             return;
         }
         cout << "\nEnter customer details:\nName: ";
-        string name, address, phone;
-        cin.ignore();
+        string name, address, phone, error;
         getline(cin, name);
         cout << "Address: ";
         getline(cin, address);
         cout << "Phone: ";
         getline(cin, phone);
-        if (name.empty() || address.empty() || phone.empty()) {
-            cout << "All customer details are required." << endl;
+        if (!validCustomerDetails(name, address, phone, error)) {
+            cout << error << endl;
             return;
         }
         cout << "Select payment method (1: Cash, 2: Online Payment): ";
@@ -889,50 +1131,32 @@ private:
         }
         cin.ignore();
         string paymentMethod = paymentChoice == 1 ? "Cash" : "Online Payment";
-        string orderId = generateOrderId();
-        string trackingId = generateTrackingId();
-        time_t now = time(nullptr);
-        char timestamp[20];
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
-        LinkedList<pair<Product, int>> orderItems;
-        for (Node<CartItem>* node = cart.getItems().begin(); node; node = node->next) {
-            orderItems.push_back({node->data.product, node->data.quantity});
-        }
-        Order order(orderId, trackingId, timestamp, name, address, phone, paymentMethod, orderItems, cart.getTotalPrice());
-        orders.push(order);
-        saveOrders();
-        string monthYear = string(timestamp).substr(5, 5);
-        monthlySales.insert(monthYear, cart.getTotalPrice());
-        saveSales();
-        appendShipment(orderId, trackingId, name, address, "in progress");
-        cout << "\nOrder placed successfully!\nOrder ID: " << orderId
-             << "\nTracking ID: " << trackingId << "\nTotal: $" << cart.getTotalPrice() << endl;
-        cart.clearCart();
-    }
-
-    void appendShipment(const string& orderId, const string& trackingId,
-                        const string& customerName, const string& address,
-                        const string& status) {
-        ofstream ofs(SHIPMENTS_FILE, ios::app);
-        if (ofs.is_open()) {
-            ofs << orderId << "," << trackingId << "," << customerName << ","
-                << address << "," << status << "\n";
-            ofs.close();
-        } else {
-            cerr << "Error writing to " << SHIPMENTS_FILE << endl;
+        Receipt placed;
+        if (!checkout(cart, name, address, phone, paymentMethod, placed, error)) {
+            cout << error << endl;
+            return;
         }
+        cout << "\nOrder placed successfully!\nOrder ID: " << placed.orderId
+             << "\nTracking ID: " << placed.trackingId << "\nTotal: $" << placed.total << endl;
     }
 
     void listProducts() const { displayProducts(); }
 
+    // Like stod for the console forms: throws invalid_argument on bad input.
+    static Money parsePrice(const string& text) {
+        Money price;
+        if (!Money::parse(text, price))
+            throw invalid_argument("price");
+        return price;
+    }
+
     void addProduct() {
         cout << "\n--- Add Product ---" << endl;
         string id, name, category, subcategory, priceStr, quantityStr;
         cout << "Enter Product ID: ";
-        cin.ignore();
         getline(cin, id);
-        if (id.empty() || id.find(',') != string::npos) {
-            cout << "Product ID cannot be empty or contain commas." << endl;
+        if (!Validators::isValidId(id)) {
+            cout << "Product ID must be 1-32 letters, digits, '-' or '_'." << endl;
             return;
         }
         if (products.find(id)) {
@@ -949,15 +1173,29 @@ private:
         getline(cin, priceStr);
         cout << "Enter Quantity: ";
         getline(cin, quantityStr);
+        if (!Validators::isValidField(name) || !Validators::isValidField(category) ||
+            !Validators::isValidField(subcategory)) {
+            cout << "Name, category and subcategory are required and cannot contain '|'." << endl;
+            return;
+        }
         try {
-            double price = stod(priceStr);
+            Money price = parsePrice(priceStr);
             int quantity = stoi(quantityStr);
-            if (price < 0 || quantity < 0) {
+            if (price < Money() || quantity < 0) {
                 cout << "Price and quantity cannot be negative." << endl;
                 return;
             }
-            products.insert(Product(id, name, category, subcategory, price, quantity));
-            saveProducts();
+            Product product(id, name, category, subcategory, price, quantity);
+            {
+                unique_lock<shared_mutex> catalog(catalogMutex);
+                lock_guard<mutex> journal(journalMutex);
+                if (!putProduct(product)) {
+                    cout << heldMessage(id) << " Quantity cannot be lower." << endl;
+                    return;
+                }
+                opLog.append(LogOp::ProductPut, product.toCsv());
+            }
+            commitLog();
             cout << "Product added successfully." << endl;
         } catch (...) {
             cout << "Price and Quantity must be valid numbers." << endl;
@@ -968,14 +1206,13 @@ private:
         cout << "\n--- Edit Product ---" << endl;
         string id;
         cout << "Enter Product ID to edit: ";
-        cin.ignore();
         getline(cin, id);
-        Product* product = products.find(id);
+        const Product* product = products.find(id);
         if (!product) {
             cout << "Product ID not found." << endl;
             return;
         }
-        cout << "Current Product: " << product->toString() << endl;
+        cout << "Current Product: " << withStock(*product, true).toString() << endl;
         string name, category, subcategory, priceStr, quantityStr;
         cout << "Enter new Product Name (or press Enter to keep current): ";
         getline(cin, name);
@@ -990,18 +1227,31 @@ private:
 
         try {
             name = name.empty() ? product->name : name;
-            category = category.empty() ? product->category : category;
-            subcategory = subcategory.empty() ? product->subcategory : subcategory;
-            double price = priceStr.empty() ? product->price : stod(priceStr);
-            int quantity = quantityStr.empty() ? product->quantity : stoi(quantityStr);
+            category = category.empty() ? product->category.str() : category;
+            subcategory = subcategory.empty() ? product->subcategory.str() : subcategory;
+            if (!Validators::isValidField(name) || !Validators::isValidField(category) ||
+                !Validators::isValidField(subcategory)) {
+                cout << "Name, category and subcategory cannot contain '|'." << endl;
+                return;
+            }
+            Money price = priceStr.empty() ? product->price : parsePrice(priceStr);
+            int quantity = quantityStr.empty() ? reservations.onHand(id) : stoi(quantityStr);
 
-            if (price < 0 || quantity < 0) {
+            if (price < Money() || quantity < 0) {
                 cout << "Price and quantity cannot be negative." << endl;
                 return;
             }
-            products.remove(id);
-            products.insert(Product(id, name, category, subcategory, price, quantity));
-            saveProducts();
+            Product updated(id, name, category, subcategory, price, quantity);
+            {
+                unique_lock<shared_mutex> catalog(catalogMutex);
+                lock_guard<mutex> journal(journalMutex);
+                if (!putProduct(updated)) {
+                    cout << heldMessage(id) << " Quantity cannot be lower." << endl;
+                    return;
+                }
+                opLog.append(LogOp::ProductPut, updated.toCsv());
+            }
+            commitLog();
             cout << "Product updated successfully." << endl;
         } catch (...) {
             cout << "Price and Quantity must be valid numbers." << endl;
@@ -1012,53 +1262,84 @@ private:
         cout << "\n--- Delete Product ---" << endl;
         string id;
         cout << "Enter Product ID to delete: ";
-        cin.ignore();
         getline(cin, id);
-        Product* product = products.find(id);
+        const Product* product = products.find(id);
         if (!product) {
             cout << "Product ID not found." << endl;
             return;
         }
-        cout << "Product to delete: " << product->toString() << endl;
+        cout << "Product to delete: " << withStock(*product, true).toString() << endl;
         cout << "Confirm deletion (yes/no): ";
         string confirm;
         getline(cin, confirm);
         transform(confirm.begin(), confirm.end(), confirm.begin(), ::tolower);
         if (confirm == "yes") {
-            products.remove(id);
-            saveProducts();
+            {
+                unique_lock<shared_mutex> catalog(catalogMutex);
+                lock_guard<mutex> journal(journalMutex);
+                if (!eraseProduct(id)) {
+                    cout << heldMessage(id) << " Try again once those carts are cleared or expire." << endl;
+                    return;
+                }
+                opLog.append(LogOp::ProductDelete, id);
+            }
+            commitLog();
             cout << "Product deleted successfully." << endl;
         } else {
             cout << "Deletion cancelled." << endl;
         }
     }
 
-    Customer* findCustomer(const string& id) {
+    const Customer* findCustomer(const string& id) const {
         return customers.find(id);
     }
 
-    void findCustomerMenu() {
+    void findCustomerMenu() const {
         cout << "\n--- Find Customer ---" << endl;
-        string id;
-        cout << "Enter Customer ID: ";
-        cin.ignore();
-        getline(cin, id);
-        Customer* customer = findCustomer(id);
-        if (customer) {
-            cout << "Customer found: " << customer->toString() << endl;
-        } else {
-            cout << "Customer ID not found." << endl;
+        cout << "1. By ID\n2. By Email\n3. Name Starts With\n4. Name Contains\nChoice: ";
+        string choice, query;
+        getline(cin, choice);
+        if (choice != "1" && choice != "2" && choice != "3" && choice != "4") {
+            cout << "Invalid choice." << endl;
+            return;
+        }
+        cout << (choice == "1" ? "Enter Customer ID: " : choice == "2" ? "Enter Email: " : "Enter Name: ");
+        getline(cin, query);
+        if (choice == "1" || choice == "2") {
+            const Customer* customer = choice == "1" ? findCustomer(query) : customers.findByEmail(query);
+            if (customer)
+                cout << "Customer found: " << customer->toString() << endl;
+            else
+                cout << (choice == "1" ? "Customer ID not found." : "No customer has that email.") << endl;
+            return;
+        }
+        vector<const Customer*> matches = choice == "3"
+                                              ? customers.searchNamePrefix(query, CUSTOMER_SEARCH_LIMIT + 1)
+                                              : customers.searchNameContaining(query, CUSTOMER_SEARCH_LIMIT + 1);
+        if (matches.empty()) {
+            cout << "No matching customers." << endl;
+            return;
         }
+        for (size_t i = 0; i < matches.size() && i < CUSTOMER_SEARCH_LIMIT; ++i)
+            cout << matches[i]->toString() << endl;
+        if (matches.size() > CUSTOMER_SEARCH_LIMIT)
+            cout << "(showing the first " << CUSTOMER_SEARCH_LIMIT << "; refine the search for more)" << endl;
     }
 
     void removeCustomer() {
         cout << "\n--- Remove Customer ---" << endl;
         string id;
         cout << "Enter Customer ID: ";
-        cin.ignore();
         getline(cin, id);
-        if (customers.remove(id)) {
-            saveCustomers();
+        bool removed;
+        {
+            lock_guard<mutex> journal(journalMutex);
+            removed = customers.remove(id);
+            if (removed)
+                opLog.append(LogOp::CustomerDelete, id);
+        }
+        if (removed) {
+            commitLog();
             cout << "Customer removed successfully." << endl;
         } else {
             cout << "Customer ID not found." << endl;
@@ -1071,21 +1352,247 @@ private:
             return;
         }
         cout << "\n--- Order List (Sorted by Total Price, Highest First) ---" << endl;
-        priority_queue<Order, vector<Order>, OrderComparator> temp = orders;
-        while (!temp.empty()) {
-            cout << temp.top().toString() << "\n---" << endl;
-            temp.pop();
+        orders.forEachTopByTotal(ORDER_LIST_LIMIT, [this](const Order& order) {
+            cout << order.toString([this](const string& id) { return productName(id); }) << "\n---" << endl;
+        });
+        if (orders.size() > ORDER_LIST_LIMIT) {
+            cout << "Showing the " << ORDER_LIST_LIMIT << " largest of " << orders.size()
+                 << " orders." << endl;
+        }
+    }
+
+    void findOrderMenu() const {
+        cout << "\n--- Find Order ---" << endl;
+        string id;
+        cout << "Enter Order ID or Tracking ID: ";
+        getline(cin, id);
+        Order order;
+        if (orders.findByOrderId(id, order) || orders.findByTrackingId(id, order)) {
+            cout << order.toString([this](const string& productId) { return productName(productId); }) << endl;
+        } else {
+            cout << "Order not found." << endl;
+        }
+    }
+
+    // Import rows are single lines, so each is tokenized on its own; the
+    // row buffer is reused by the pool thread parsing the chunk.
+    static bool tokenizeRow(string_view line, size_t fields, CsvRow& row, string& error) {
+        if (!CsvTokenizer::splitLine(line, row)) {
+            error = "unterminated quoted field";
+            return false;
+        }
+        return row.size() == fields;
+    }
+
+    static bool parseProductRow(string_view line, Product& product, string& error) {
+        thread_local CsvRow row;
+        Money price;
+        int quantity;
+        if (!tokenizeRow(line, 6, row, error)) {
+            if (error.empty())
+                error = "expected id,name,category,subcategory,price,quantity";
+        } else if (!Validators::isValidId(row[0])) {
+            error = "invalid product id";
+        } else if (!Validators::isValidField(row[1]) || !Validators::isValidField(row[2]) ||
+                   !Validators::isValidField(row[3])) {
+            error = "name, category and subcategory are required and cannot contain '|'";
+        } else if (!Money::parse(row[4], price) || !row.number(5, quantity) || price < Money() || quantity < 0) {
+            error = "price and quantity must be non-negative numbers";
+        } else {
+            product = Product(row.str(0), row.str(1), row.str(2), row.str(3), price, quantity);
+            return true;
         }
+        return false;
+    }
+
+    static bool parseCustomerRow(string_view line, Customer& customer, string& error) {
+        thread_local CsvRow row;
+        if (!tokenizeRow(line, 3, row, error)) {
+            if (error.empty())
+                error = "expected id,name,email";
+        } else if (!Validators::isValidNumericId(row[0])) {
+            error = "customer id must be a number of up to 9 digits";
+        } else if (!Validators::isValidField(row[1])) {
+            error = "name is required and cannot contain '|'";
+        } else if (!Validators::isValidEmail(row[2])) {
+            error = "invalid email address";
+        } else {
+            customer = Customer(row.str(0), row.str(1), row.str(2));
+            return true;
+        }
+        return false;
+    }
+
+    static bool parseOrderRow(string_view line, Order& order, string& error) {
+        thread_local CsvRow row;
+        if (!tokenizeRow(line, 9, row, error) || !Order::fromRow(row, order)) {
+            if (error.empty())
+                error = "expected orderId,trackingId,timestamp,name,address,phone,payment,total,items";
+        } else if (!Validators::isValidId(order.orderId) || !Validators::isValidId(order.trackingId)) {
+            error = "invalid order or tracking id";
+        } else if (order.timestamp.size() < 10 || !Validators::isValidDate(string_view(order.timestamp).substr(0, 10))) {
+            error = "timestamp must start with YYYY-MM-DD";
+        } else if (!SalesAggregator::inWindow(order.timestamp)) {
+            error = "timestamp must be between 1970-01-01 and a year from today";
+        } else if (order.items.empty() || order.totalPrice < Money()) {
+            error = "an order needs items and a non-negative total";
+        } else {
+            return true;
+        }
+        return false;
+    }
+
+    // Bulk import of products, customers or orders, in the same layout as
+    // their files under wearhouse/. Rows are parsed and validated on a
+    // thread pool, deduplicated, applied under the catalog and journal
+    // locks and made durable by one checkpoint. Orders are never replaced,
+    // so for them upsert behaves like skip.
+    bool importCsv(const string& entity, const string& path, ConflictPolicy policy, ImportReport& report) {
+        MappedFile file;
+        if (!file.open(path)) {
+            cerr << "Cannot open " << path << endl;
+            return false;
+        }
+        string_view text(file.data(), file.size());
+        ThreadPool pool(max(1u, thread::hardware_concurrency()));
+        uint32_t changed = 0; // imported rows are not journaled one by one
+        if (entity == "products") {
+            changed = OperationLog::opBit(LogOp::ProductPut);
+            auto rows = CsvImportPipeline<Product>::prepare(text, pool, parseProductRow,
+                                                            [](const Product& p) { return p.id; }, report);
+            unique_lock<shared_mutex> catalog(catalogMutex);
+            lock_guard<mutex> journal(journalMutex);
+            CsvImportPipeline<Product>::apply(
+                rows, policy, [this](const Product& p) { return products.find(p.id) != nullptr; },
+                [this](Product& p, bool, string& reason) {
+                    if (putProduct(p))
+                        return true;
+                    reason = heldMessage(p.id);
+                    return false;
+                },
+                report);
+        } else if (entity == "customers") {
+            changed = OperationLog::opBit(LogOp::CustomerPut);
+            auto rows = CsvImportPipeline<Customer>::prepare(text, pool, parseCustomerRow,
+                                                             [](const Customer& c) { return c.id; }, report);
+            unique_lock<shared_mutex> catalog(catalogMutex);
+            lock_guard<mutex> journal(journalMutex);
+            CsvImportPipeline<Customer>::apply(
+                rows, policy, [this](const Customer& c) { return customers.find(c.id) != nullptr; },
+                [this](Customer& c, bool, string& reason) {
+                    if (customers.insert(c))
+                        return true;
+                    reason = "email already belongs to another customer";
+                    return false;
+                },
+                report);
+        } else if (entity == "orders") {
+            changed = OperationLog::opBit(LogOp::OrderAdd);
+            auto rows = CsvImportPipeline<Order>::prepare(text, pool, parseOrderRow,
+                                                          [](const Order& o) { return o.orderId; }, report);
+            unique_lock<shared_mutex> catalog(catalogMutex);
+            lock_guard<mutex> journal(journalMutex);
+            CsvImportPipeline<Order>::apply(
+                rows, policy == ConflictPolicy::Upsert ? ConflictPolicy::Skip : policy,
+                [this](const Order& o) { return orders.contains(o.orderId); },
+                [this](Order& o, bool, string&) {
+                    fillLegacyPrices(o);
+                    ids.advancePast(ORDER_IDS, IdAllocator::parse("ORD", o.orderId));
+                    ids.advancePast(TRACKING_IDS, IdAllocator::parse("TRK", o.trackingId));
+                    addOrder(move(o), false);
+                    return true;
+                },
+                report);
+            // One write for the whole batch, so evicted rows read back; the
+            // checkpoint below fsyncs it.
+            orders.flush();
+        } else {
+            cerr << "Unknown import type " << entity << " (products, customers or orders)" << endl;
+            return false;
+        }
+        if (report.inserted + report.updated > 0)
+            checkpoint(changed);
+        return true;
+    }
+
+    // Writes products, customers or orders to `path` in their wearhouse/
+    // file layout. Both locks are held throughout, so the file is one
+    // consistent snapshot; lines are formatted on a thread pool.
+    bool exportCsv(const string& entity, const string& path, size_t& written) {
+        ThreadPool pool(max(1u, thread::hardware_concurrency()));
+        shared_lock<shared_mutex> catalog(catalogMutex);
+        lock_guard<mutex> journal(journalMutex);
+        if (entity == "products") {
+            vector<const Product*> items;
+            items.reserve(products.size());
+            products.forEach([&](const Product& p) { items.push_back(&p); });
+            written = items.size();
+            return writeCsvParallel(path, items, pool, [this](const Product* p, string& out) {
+                out += withStock(*p, true).toCsv();
+                out += '\n';
+            });
+        }
+        if (entity == "customers") {
+            vector<const Customer*> items;
+            customers.forEach([&](const Customer& c) { items.push_back(&c); });
+            written = items.size();
+            return writeCsvParallel(path, items, pool, [](const Customer* c, string& out) {
+                out += c->toCsv();
+                out += '\n';
+            });
+        }
+        if (entity == "orders") {
+            vector<Order> items;
+            items.reserve(orders.size());
+            orders.forEachPlacedSince(0, [&](const Order& o) { items.push_back(o.clone()); });
+            written = items.size();
+            return writeCsvParallel(path, items, pool, [](const Order& o, string& out) {
+                out += o.toCsv();
+                out += '\n';
+            });
+        }
+        cerr << "Unknown export type " << entity << " (products, customers or orders)" << endl;
+        return false;
+    }
+
+    void bulkImportMenu() {
+        cout << "\n--- Bulk Import ---" << endl;
+        string entity, path, policyText;
+        cout << "Import what (products/customers/orders): ";
+        getline(cin, entity);
+        cout << "CSV file path: ";
+        getline(cin, path);
+        cout << "On existing IDs (upsert/skip/fail): ";
+        getline(cin, policyText);
+        ConflictPolicy policy;
+        if (!parseConflictPolicy(policyText, policy)) {
+            cout << "Unknown policy." << endl;
+            return;
+        }
+        ImportReport report;
+        if (importCsv(entity, path, policy, report))
+            report.print(cout);
+    }
+
+    void bulkExportMenu() {
+        cout << "\n--- Bulk Export ---" << endl;
+        string entity, path;
+        cout << "Export what (products/customers/orders): ";
+        getline(cin, entity);
+        cout << "CSV file path: ";
+        getline(cin, path);
+        size_t written = 0;
+        if (exportCsv(entity, path, written))
+            cout << "Exported " << written << " " << entity << " to " << path << endl;
     }
 
     void addCustomer() {
         cout << "\n--- Add Customer ---" << endl;
         string id, name, email;
         cout << "Enter Customer ID: ";
-        cin.ignore();
         getline(cin, id);
-        if (id.empty() || id.find(',') != string::npos) {
-            cout << "Customer ID cannot be empty or contain commas." << endl;
+        if (!Validators::isValidNumericId(id)) {
+            cout << "Customer ID must be a number of up to 9 digits." << endl;
             return;
         }
         if (customers.find(id)) {
@@ -1096,18 +1603,24 @@ private:
         getline(cin, name);
         cout << "Enter Customer Email: ";
         getline(cin, email);
-        if (name.empty() || email.empty()) {
-            cout << "All fields are required." << endl;
+        if (!Validators::isValidField(name)) {
+            cout << "Name is required and cannot contain '|'." << endl;
             return;
         }
-        try {
-            stoi(id);
-            customers.insert(Customer(id, name, email));
-            saveCustomers();
-            cout << "Customer added successfully." << endl;
-        } catch (...) {
-            cout << "Customer ID must be a valid number." << endl;
+        if (!Validators::isValidEmail(email)) {
+            cout << "Invalid email address." << endl;
+            return;
+        }
+        {
+            lock_guard<mutex> journal(journalMutex);
+            if (!customers.insert(Customer(id, name, email))) {
+                cout << "That email already belongs to another customer." << endl;
+                return;
+            }
+            opLog.append(LogOp::CustomerPut, Customer(id, name, email).toCsv());
         }
+        commitLog();
+        cout << "Customer added successfully." << endl;
     }
 
     void listCustomers() const {
@@ -1116,76 +1629,245 @@ private:
             return;
         }
         cout << "\n--- Customer List ---" << endl;
-        auto allCustomers = customers.getAllCustomers();
-        for (const auto& c : allCustomers) {
+        for (const Customer& c : customers) {
             cout << c.toString() << endl;
         }
     }
 
+    static void printSalesTotals(const string& label, const SalesTotals& totals) {
+        cout << label << ": $" << totals.revenue << " from " << totals.orders << " orders, "
+             << totals.units << " units" << endl;
+    }
+
+    void printSalesSplits(int32_t fromDay, int32_t toDay) const {
+        cout << "By payment method:" << endl;
+        sales.forEachPaymentMethod(fromDay, toDay, [](const string& method, const SalesTotals& totals) {
+            printSalesTotals("  " + method, totals);
+        });
+        cout << "By category:" << endl;
+        sales.forEachCategory(fromDay, toDay, [](const string& category, const SalesTotals& totals) {
+            printSalesTotals("  " + category, totals);
+        });
+    }
+
     void viewMonthlySales() {
         cout << "\n--- Monthly Sales ---" << endl;
         string monthYear;
         cout << "Enter month and year (e.g., 06-2025): ";
-        cin.ignore();
         getline(cin, monthYear);
-        if (monthYear.length() != 7 || monthYear[2] != '-') {
+        if (!Validators::isValidMonthYear(monthYear)) {
             cout << "Invalid format. Use MM-YYYY." << endl;
             return;
         }
-        double sales = monthlySales.get(monthYear);
-        cout << "Sales for " << monthYear << ": $" << sales << endl;
-        cout << "Update sales from orders? (yes/no): ";
+        int month = stoi(monthYear.substr(0, 2)), year = stoi(monthYear.substr(3));
+        SalesTotals totals = sales.monthTotals(year, month);
+        printSalesTotals("Sales for " + monthYear, totals);
+        if (totals.orders > 0) {
+            int32_t first = SalesAggregator::dayNumber(year, month, 1);
+            int32_t last = SalesAggregator::dayNumber(month == 12 ? year + 1 : year, month % 12 + 1, 1) - 1;
+            printSalesSplits(first, last);
+            vector<pair<string, SalesTotals>> top;
+            sales.forEachProductInMonth(year, month, [&](const string& id, const SalesTotals& productTotals) {
+                top.push_back({id, productTotals});
+            });
+            size_t shown = min<size_t>(top.size(), 5);
+            partial_sort(top.begin(), top.begin() + shown, top.end(), [](const auto& a, const auto& b) {
+                return a.second.revenue > b.second.revenue;
+            });
+            cout << "Top products:" << endl;
+            for (size_t i = 0; i < shown; ++i)
+                printSalesTotals("  " + productName(top[i].first) + " (" + top[i].first + ")", top[i].second);
+        }
+        cout << "Rebuild sales from order history? (yes/no): ";
         string update;
         getline(cin, update);
         transform(update.begin(), update.end(), update.begin(), ::tolower);
         if (update == "yes") {
-            priority_queue<Order, vector<Order>, OrderComparator> temp = orders;
-            while (!temp.empty()) {
-                const Order& order = temp.top();
-                string orderMonthYear = order.timestamp.substr(5, 5);
-                monthlySales.insert(orderMonthYear, order.totalPrice);
-                temp.pop();
+            {
+                lock_guard<mutex> journal(journalMutex);
+                rebuildSales();
             }
-            saveSales();
-            sales = monthlySales.get(monthYear);
-            cout << "Updated sales for " << monthYear << ": $" << sales << endl;
+            checkpoint(OperationLog::opBit(LogOp::OrderAdd));
+            printSalesTotals("Rebuilt sales for " + monthYear, sales.monthTotals(year, month));
         }
     }
 
-    void trackShipments() const {
-        if (!fs::exists(SHIPMENTS_FILE)) {
-            cout << "Shipments.txt file not found." << endl;
+    void salesReport() const {
+        cout << "\n--- Sales Report ---" << endl;
+        string from, to;
+        cout << "From date (YYYY-MM-DD): ";
+        getline(cin, from);
+        cout << "To date (YYYY-MM-DD): ";
+        getline(cin, to);
+        if (!Validators::isValidDate(from) || !Validators::isValidDate(to)) {
+            cout << "Invalid date. Use YYYY-MM-DD." << endl;
             return;
         }
-        ifstream ifs(SHIPMENTS_FILE);
-        if (!ifs.is_open()) {
-            cout << "Cannot open Shipments.txt. Please check file permissions." << endl;
+        int y, m, d;
+        SalesAggregator::parseDate(from, y, m, d);
+        int32_t fromDay = SalesAggregator::dayNumber(y, m, d);
+        SalesAggregator::parseDate(to, y, m, d);
+        int32_t toDay = SalesAggregator::dayNumber(y, m, d);
+        if (toDay < fromDay) {
+            cout << "The end date is before the start date." << endl;
             return;
         }
-        int deliveredCount = 0, inProgressCount = 0;
-        string line;
-        while (getline(ifs, line)) {
-            size_t pos = line.rfind(",");
-            if (pos != string::npos) {
-                string status = line.substr(pos + 1);
-                transform(status.begin(), status.end(), status.begin(), ::tolower);
-                if (status == "delivered")
-                    deliveredCount++;
-                else if (status == "in progress")
-                    inProgressCount++;
+        SalesTotals totals = sales.dailyRange(fromDay, toDay);
+        printSalesTotals("Sales from " + from + " to " + to, totals);
+        if (totals.orders > 0)
+            printSalesSplits(fromDay, toDay);
+    }
+
+    // Stock on hand valued at current prices. Prices and on-hand counts are
+    // copied into two columns under the locks, then summed exactly by the
+    // stockValue kernel.
+    void inventoryValue() const {
+        vector<Money> prices;
+        vector<int32_t> quantities;
+        {
+            shared_lock<shared_mutex> catalog(catalogMutex);
+            lock_guard<mutex> journal(journalMutex); // checkout moves on-hand counts
+            prices.reserve(products.size());
+            quantities.reserve(products.size());
+            products.forEach([&](const Product& p) {
+                prices.push_back(p.price);
+                quantities.push_back(reservations.onHand(p.id));
+            });
+        }
+        int64_t units = 0;
+        for (int32_t quantity : quantities)
+            units += quantity;
+        cout << "\n--- Inventory Value ---" << endl;
+        cout << prices.size() << " products, " << units << " units on hand, worth $"
+             << stockValue(prices.data(), quantities.data(), prices.size()) << endl;
+    }
+
+    // Raises or lowers every price in a category (or the whole catalog) by a
+    // whole percentage, rounded to the cent. Each change is journaled like
+    // an edit.
+    void repriceProducts() {
+        cout << "\n--- Reprice Products ---" << endl;
+        string category, percentStr;
+        cout << "Category (or press Enter for all products): ";
+        getline(cin, category);
+        cout << "Percent change (e.g. 5 or -10): ";
+        getline(cin, percentStr);
+        int percent;
+        try {
+            percent = stoi(percentStr);
+        } catch (...) {
+            cout << "Percent must be a whole number." << endl;
+            return;
+        }
+        if (percent <= -100 || percent > 1000) {
+            cout << "Percent must be above -100 and at most 1000." << endl;
+            return;
+        }
+        size_t repriced = 0;
+        {
+            unique_lock<shared_mutex> catalog(catalogMutex);
+            lock_guard<mutex> journal(journalMutex);
+            vector<Product> updated;
+            auto reprice = [&](const Product& p) {
+                Product next = withStock(p, true);
+                next.price = p.price.scaled(100 + percent, 100);
+                if (next.price != p.price)
+                    updated.push_back(move(next));
+            };
+            if (category.empty()) {
+                products.forEach(reprice);
+            } else {
+                catalogIndex.forEachInCategory(category, [&](const string& id) {
+                    if (const Product* p = products.find(id))
+                        reprice(*p);
+                });
+            }
+            for (const Product& p : updated) {
+                putProduct(p); // same on-hand count, so never refused
+                opLog.append(LogOp::ProductPut, p.toCsv());
             }
+            repriced = updated.size();
         }
-        ifs.close();
+        commitLog();
+        cout << repriced << " products repriced." << endl;
+    }
+
+    void trackShipments() const {
         cout << "\n--- Shipment Status ---" << endl;
-        cout << "Delivered Orders: " << deliveredCount
-             << "\nIn-Progress Orders: " << inProgressCount << endl;
+        cout << "In-Progress Orders: " << shipments.count(ShipmentStatus::InProgress)
+             << "\nPacked Orders: " << shipments.count(ShipmentStatus::Packed)
+             << "\nShipped Orders: " << shipments.count(ShipmentStatus::Shipped)
+             << "\nDelivered Orders: " << shipments.count(ShipmentStatus::Delivered) << endl;
+    }
+
+    void updateShipmentStatus() {
+        cout << "\n--- Update Shipment Status ---" << endl;
+        string trackingId, statusText;
+        cout << "Enter Tracking ID: ";
+        getline(cin, trackingId);
+        cout << "New status (packed/shipped/delivered): ";
+        getline(cin, statusText);
+        ShipmentStatus status;
+        if (!ShipmentStore::parseStatus(statusText, status)) {
+            cout << "Unknown status." << endl;
+            return;
+        }
+        ShipmentStore::Update result;
+        {
+            lock_guard<mutex> journal(journalMutex);
+            result = shipments.advance(trackingId, status);
+            if (result == ShipmentStore::Update::Applied)
+                opLog.append(LogOp::ShipmentAdvance, trackingId + "," + ShipmentStore::statusName(status));
+        }
+        commitLog();
+        switch (result) {
+        case ShipmentStore::Update::Applied:
+            cout << "Shipment " << trackingId << " is now " << ShipmentStore::statusName(status) << "." << endl;
+            break;
+        case ShipmentStore::Update::Unchanged:
+            cout << "Shipment is already " << ShipmentStore::statusName(status) << "." << endl;
+            break;
+        case ShipmentStore::Update::Backwards:
+            cout << "Shipment is already "
+                 << ShipmentStore::statusName(shipments.find(trackingId)->status) << "; status cannot go back." << endl;
+            break;
+        case ShipmentStore::Update::Unknown:
+            cout << "Shipment not found." << endl;
+            break;
+        }
+    }
+
+    // Applies a carrier feed of "trackingId,status" lines. The updates are
+    // not journaled one by one; a checkpoint right after makes them durable
+    // in a single rewrite. Feeds only move shipments forward, so importing
+    // the same file again after a crash is safe.
+    void importCarrierFeed() {
+        cout << "\n--- Import Carrier Feed ---" << endl;
+        string path;
+        cout << "Feed file path: ";
+        getline(cin, path);
+        MappedFile feed;
+        if (!feed.open(path)) {
+            cout << "Cannot open " << path << endl;
+            return;
+        }
+        ShipmentFeedResult result;
+        {
+            lock_guard<mutex> journal(journalMutex);
+            result = shipments.applyFeed(string_view(feed.data(), feed.size()));
+        }
+        if (result.applied > 0)
+            checkpoint(OperationLog::opBit(LogOp::ShipmentAdvance));
+        cout << "Applied " << result.applied << " updates (" << result.unchanged << " unchanged, "
+             << result.unknown << " unknown tracking IDs, " << result.malformed << " malformed lines)." << endl;
     }
 
     void customerMenu() {
         while (true) {
             cout << "\n--- FAMIN E-Commerce Customer Menu ---" << endl;
             cout << "1. View All Products\n2. View Men Products\n3. View Women Products\n"
-                 << "4. Add to Cart\n5. View Cart\n6. Place Order\n0. Back to Main Menu\nChoice: ";
+                 << "4. Add to Cart\n5. View Cart\n6. Place Order\n7. Search Products\n8. Clear Cart\n"
+                 << "0. Back to Main Menu\nChoice: ";
             int choice;
             if (!(cin >> choice)) {
                 cout << "Invalid input. Enter a number." << endl;
@@ -1223,11 +1905,18 @@ private:
                 break;
             }
             case 5:
-                cart.displayCart();
+                cart.displayCart([this](const string& id) { return productName(id); });
                 break;
             case 6:
                 placeOrder();
                 break;
+            case 7:
+                searchProducts();
+                break;
+            case 8:
+                cart.clearCart();
+                cout << "Cart cleared; reserved stock returned." << endl;
+                break;
             default:
                 cout << "Invalid choice." << endl;
             }
@@ -1257,7 +1946,9 @@ private:
             cout << "\n--- FAMIN Admin Control Panel ---" << endl;
             cout << "1. List Products\n2. Add Product\n3. Edit Product\n4. Delete Product\n"
                  << "5. Find Customer\n6. Remove Customer\n7. List Orders\n8. View Monthly Sales\n"
-                 << "9. Track Shipments\n10. Add New Admin\n0. Back to Main Menu\nChoice: ";
+                 << "9. Track Shipments\n10. Add New Admin\n11. Find Order\n12. Sales Report\n"
+                 << "13. Update Shipment Status\n14. Import Carrier Feed\n15. Bulk Import\n16. Bulk Export\n"
+                 << "17. Metrics\n18. Inventory Value\n19. Reprice Products\n0. Back to Main Menu\nChoice: ";
             int choice;
             if (!(cin >> choice)) {
                 cout << "Invalid input. Enter a number." << endl;
@@ -1299,12 +1990,53 @@ private:
             case 10:
                 addNewAdmin();
                 break;
+            case 11:
+                findOrderMenu();
+                break;
+            case 12:
+                salesReport();
+                break;
+            case 13:
+                updateShipmentStatus();
+                break;
+            case 14:
+                importCarrierFeed();
+                break;
+            case 15:
+                bulkImportMenu();
+                break;
+            case 16:
+                bulkExportMenu();
+                break;
+            case 17:
+                metricsMenu();
+                break;
+            case 18:
+                inventoryValue();
+                break;
+            case 19:
+                repriceProducts();
+                break;
             default:
                 cout << "Invalid choice." << endl;
             }
         }
     }
 
+    void metricsMenu() const {
+#if WEARHOUSE_METRICS
+        cout << "\n--- Metrics (since start) ---" << endl;
+        Metrics::print(cout);
+        cout << "Write Prometheus text to file (blank to skip): ";
+        string path;
+        getline(cin, path);
+        if (!path.empty())
+            writeMetrics(path);
+#else
+        cout << "Metrics are compiled out of this build (WEARHOUSE_METRICS=0)." << endl;
+#endif
+    }
+
     void addNewAdmin() {
         string username, password, confirmPassword;
         cout << "\n--- Add New Admin ---" << endl;
@@ -1318,17 +2050,277 @@ private:
         adminTable.addAdmin(username, password, confirmPassword);
     }
 
+    // Server protocol: each input line is "<session> <COMMAND> [arguments]"
+    // and gets exactly one reply line "<session> OK ..." or
+    // "<session> ERR ...". Sessions are created on first use and each has
+    // its own cart; commands of one session run in order, different
+    // sessions run in parallel on the pool.
+    //   ADD <productId> <qty>          reserve stock into the session cart
+    //   CART                           total=<t> then id:qty pairs
+    //   CLEAR                          empty the cart
+    //   ORDER name|address|phone|cash  place the order (cash or online)
+    //   SHOW <productId>               one products.txt line
+    //   PRODUCTS [afterId]             next=<token or -> then up to 50 products
+    //   LOGIN <user> <password>        make this an admin session; replies
+    //                                  with a token for RESUME
+    //   RESUME <token>                 admin session from an earlier LOGIN
+    //   LOGOUT <token>                 revoke a LOGIN token; this session
+    //                                  loses admin rights
+    //   PUT <products.txt line>        add or replace a product (admin)
+    //   FIND <orderId|trackingId>      one orders.txt line (admin)
+    //   QUIT                           drop the cart and admin rights and
+    //                                  forget the session
+    string executeCommand(Session& session, const string& line) {
+        stringstream ss(line);
+        string command, rest;
+        ss >> command;
+        transform(command.begin(), command.end(), command.begin(), ::toupper);
+        ss >> ws;
+        getline(ss, rest);
+        string message;
+        if (command == "ADD") {
+            stringstream args(rest);
+            string id;
+            int quantity;
+            if (!(args >> id >> quantity))
+                return "ERR usage: ADD <productId> <quantity>";
+            bool ok = reserveToCart(session.cart, id, quantity, message);
+            return (ok ? "OK " : "ERR ") + message;
+        }
+        if (command == "CART") {
+            string reply = "OK total=" + session.cart.getTotalPrice().toString();
+            for (const CartItem& item : session.cart.getItems())
+                reply += " " + item.productId + ":" + to_string(item.quantity);
+            return reply;
+        }
+        if (command == "CLEAR") {
+            session.cart.clearCart();
+            return "OK";
+        }
+        if (command == "ORDER") {
+            vector<string> fields;
+            stringstream args(rest);
+            string field;
+            while (getline(args, field, '|'))
+                fields.push_back(field);
+            if (fields.size() != 4)
+                return "ERR usage: ORDER name|address|phone|cash or online";
+            transform(fields[3].begin(), fields[3].end(), fields[3].begin(), ::tolower);
+            if (fields[3] != "cash" && fields[3] != "online")
+                return "ERR Invalid payment method.";
+            Receipt placed;
+            if (!checkout(session.cart, fields[0], fields[1], fields[2],
+                          fields[3] == "cash" ? "Cash" : "Online Payment", placed, message))
+                return "ERR " + message;
+            return "OK " + placed.orderId + " " + placed.trackingId + " " + placed.total.toString();
+        }
+        if (command == "SHOW") {
+            shared_lock<shared_mutex> catalog(catalogMutex);
+            const Product* product = products.find(rest);
+            if (!product)
+                return "ERR Product ID " + rest + " not found.";
+            return "OK " + withStock(*product).toCsv();
+        }
+        if (command == "PRODUCTS") {
+            string reply;
+            shared_lock<shared_mutex> catalog(catalogMutex);
+            string next = products.forEachPage(rest, PRODUCT_PAGE_SIZE, [&](const Product& product) {
+                reply += ";" + withStock(product).toCsv();
+            });
+            return "OK next=" + (next.empty() ? string("-") : next) + " " + reply.substr(min<size_t>(1, reply.size()));
+        }
+        if (command == "LOGIN") {
+            stringstream args(rest);
+            string username, password;
+            args >> username >> password;
+            string token;
+            session.admin = adminTable.login(username, password, token);
+            return session.admin ? "OK " + token : "ERR Invalid username or password!";
+        }
+        if (command == "RESUME") {
+            string username;
+            session.admin = adminTable.resume(rest, username);
+            return session.admin ? "OK " + username : "ERR Invalid or expired token";
+        }
+        if (command == "LOGOUT") {
+            if (rest.empty())
+                return "ERR expected LOGOUT <token>";
+            adminTable.logout(rest);
+            session.admin = false;
+            return "OK";
+        }
+        if (command == "PUT" || command == "FIND") {
+            if (!session.admin)
+                return "ERR admin login required";
+        }
+        if (command == "PUT") {
+            Product product = Product::fromCsv(rest);
+            if (!Validators::isValidId(product.id) || !Validators::isValidField(product.name) ||
+                !Validators::isValidField(product.category.str()) ||
+                !Validators::isValidField(product.subcategory.str()) ||
+                product.price < Money() || product.quantity < 0)
+                return "ERR expected id,name,category,subcategory,price,quantity";
+            {
+                unique_lock<shared_mutex> catalog(catalogMutex);
+                lock_guard<mutex> journal(journalMutex);
+                if (!putProduct(product))
+                    return "ERR " + heldMessage(product.id);
+                opLog.append(LogOp::ProductPut, product.toCsv());
+            }
+            commitLog();
+            return "OK";
+        }
+        if (command == "FIND") {
+            Order order;
+            lock_guard<mutex> journal(journalMutex);
+            if (orders.findByOrderId(rest, order) || orders.findByTrackingId(rest, order))
+                return "OK " + order.toCsv();
+            return "ERR Order not found.";
+        }
+        if (command == "QUIT") {
+            session.cart.clearCart();
+            session.admin = false;
+            session.closed = true;
+            return "OK";
+        }
+        return "ERR unknown command " + command;
+    }
+
+    // Pool task: runs a session's queued commands until none are left. A
+    // session that ended on QUIT is then erased; a later line with its id
+    // starts a new one.
+    void drainSession(const string& sessionId, Session& session, ostream& out) {
+        while (true) {
+            string line;
+            {
+                lock_guard<mutex> lock(sessionsMutex);
+                if (session.pending.empty()) {
+                    session.scheduled = false;
+                    if (session.closed)
+                        sessions.erase(sessionId);
+                    return;
+                }
+                line = move(session.pending.front());
+                session.pending.pop_front();
+                session.closed = false;
+            }
+            string reply = executeCommand(session, line);
+            lock_guard<mutex> lock(outputMutex);
+            out << sessionId << " " << reply << endl;
+        }
+    }
+
 public:
-    FaminEcommerce() {
+    explicit FaminEcommerce(size_t orderMemoryBudget = 4 * 1024 * 1024,
+                            uint32_t kdfIterations = Pbkdf2Backend::DEFAULT_ITERATIONS,
+                            size_t loadThreads = max(1u, thread::hardware_concurrency()))
+        : startupThreads(loadThreads) {
         if (!ensureDirectoriesExist()) {
             cerr << "Fatal error: Cannot initialize directories. Exiting..." << endl;
             exit(1);
         }
-        loadIdCounters();
-        loadProducts();
-        loadOrders();
-        loadCustomers();
-        loadSales();
+        // Loaded only once the directories exist; a first run used to fail
+        // writing the default admin before wearhouse/ was created.
+        adminTable.setBackend(make_unique<Pbkdf2Backend>(kdfIterations));
+        adminTable.loadAdmins();
+        orders.setResidentBudget(orderMemoryBudget);
+        // The loaders touch disjoint state, so they run side by side; the
+        // joins wait for what they read. Each loader also splits its own
+        // file across the pool.
+        // The saved symbols are interned first so they keep their codes.
+        startup.add("symbols", {}, [this](ThreadPool&) { StringPool::global().load(SYMBOLS_FILE); });
+        startup.add("id counters", {}, [this](ThreadPool&) { loadIdCounters(); });
+        startup.add("products", {"symbols"}, [this](ThreadPool& pool) { loadProducts(pool); });
+        startup.add("orders", {"symbols"}, [this](ThreadPool& pool) { loadOrders(pool); });
+        startup.add("customers", {}, [this](ThreadPool& pool) { loadCustomers(pool); });
+        startup.add("shipments", {}, [this](ThreadPool&) { loadShipments(); });
+        startup.add("sales snapshot", {}, [this](ThreadPool&) { loadSalesSnapshot(); });
+        startup.add("order prices", {"products", "orders"}, [this](ThreadPool&) { resolveLegacyOrders(); });
+        startup.add("sales catch-up", {"sales snapshot", "order prices"}, [this](ThreadPool&) { catchUpSales(); });
+        {
+            ThreadPool pool(startupThreads);
+            startup.run(pool);
+        }
+        replayLog();
+        reservations.start();
+        checkpoints.start();
+    }
+
+    // Per-phase load times of the constructor.
+    void printStartupTimings(ostream& out) const { startup.printTimings(out, startupThreads); }
+
+    void setFsyncPolicy(FsyncPolicy policy) { opLog.setFsyncPolicy(policy); }
+
+    // --import / --export from the command line. Returns the exit status.
+    int runImport(const string& entity, const string& path, ConflictPolicy policy) {
+        ImportReport report;
+        if (!importCsv(entity, path, policy, report))
+            return 1;
+        report.print(cout);
+        return report.aborted || report.invalid > 0 ? 2 : 0;
+    }
+
+    int runExport(const string& entity, const string& path) {
+        size_t written = 0;
+        if (!exportCsv(entity, path, written))
+            return 1;
+        cout << "Exported " << written << " " << entity << " to " << path << endl;
+        return 0;
+    }
+
+    // Writes every counter and histogram in Prometheus text format, e.g.
+    // for a node exporter's textfile collector.
+    static bool writeMetrics(const string& path) {
+#if WEARHOUSE_METRICS
+        ofstream out(path);
+        Metrics::writePrometheus(out);
+        out.close();
+        if (!out) {
+            cerr << "Error writing metrics to " << path << endl;
+            return false;
+        }
+        cout << "Metrics written to " << path << endl;
+        return true;
+#else
+        (void)path;
+        cerr << "Metrics are compiled out of this build (WEARHOUSE_METRICS=0)." << endl;
+        return false;
+#endif
+    }
+
+    // Line-protocol server over stdin/stdout (see executeCommand). Replies
+    // go to `out`; anything else the program prints should be sent
+    // elsewhere by the caller. Returns at end of input.
+    void serve(size_t threads, ostream& out) {
+        ThreadPool pool(threads);
+        string line;
+        while (getline(cin, line)) {
+            stringstream ss(line);
+            string sessionId, command;
+            ss >> sessionId >> ws;
+            getline(ss, command);
+            if (sessionId.empty())
+                continue;
+            if (command.empty()) {
+                lock_guard<mutex> lock(outputMutex);
+                out << sessionId << " ERR empty command" << endl;
+                continue;
+            }
+            lock_guard<mutex> lock(sessionsMutex);
+            unique_ptr<Session>& session = sessions[sessionId];
+            if (!session)
+                session.reset(new Session(&reservations));
+            session->pending.push_back(move(command));
+            if (!session->scheduled) {
+                session->scheduled = true;
+                Session* target = session.get();
+                pool.submit([this, sessionId, target, &out] { drainSession(sessionId, *target, out); });
+            }
+        }
+        pool.shutdown();
+        // End of input closes every session; their carts give stock back.
+        sessions.clear();
+        checkpoint();
     }
 
     void run() {
@@ -1343,6 +2335,7 @@ public:
                 continue;
             }
             if (choice == 0) {
+                checkpoint();
                 cout << "Exiting..." << endl;
                 break;
             }
@@ -1363,12 +2356,75 @@ public:
 };
 
 // Initialize static members
-unsigned long FaminEcommerce::nextOrderId = 1;
-unsigned long FaminEcommerce::nextTrackingId = 1;
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc == 4 && string(argv[1]) == "--products-to-bin")
+        return convertProductsCsvToSnapshot(argv[2], argv[3]) ? 0 : 1;
+    if (argc == 4 && string(argv[1]) == "--products-to-csv")
+        return convertProductsSnapshotToCsv(argv[2], argv[3]) ? 0 : 1;
+    size_t orderMemoryBudget = 4 * 1024 * 1024;
+    bool serve = false;
+    bool startupTimings = false;
+    size_t threads = max(1u, thread::hardware_concurrency());
+    FsyncPolicy fsyncPolicy = FsyncPolicy::Always;
+    uint32_t kdfIterations = Pbkdf2Backend::DEFAULT_ITERATIONS;
+    string importEntity, exportEntity, transferPath, metricsPath;
+    ConflictPolicy importPolicy = ConflictPolicy::Upsert;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--order-memory-mb" && hasValue) {
+            orderMemoryBudget = static_cast<size_t>(max(0L, atol(argv[++i]))) * 1024 * 1024;
+        } else if (arg == "--serve") {
+            serve = true;
+        } else if (arg == "--startup-timings") {
+            startupTimings = true;
+        } else if (arg == "--metrics-out" && hasValue) {
+            metricsPath = argv[++i];
+        } else if ((arg == "--import" || arg == "--export") && i + 2 < argc) {
+            (arg == "--import" ? importEntity : exportEntity) = argv[++i];
+            transferPath = argv[++i];
+            if (arg == "--import" && i + 1 < argc && parseConflictPolicy(argv[i + 1], importPolicy))
+                ++i;
+        } else if (arg == "--kdf-iterations" && hasValue) {
+            kdfIterations = static_cast<uint32_t>(max(1L, atol(argv[++i])));
+        } else if (arg == "--threads" && hasValue) {
+            threads = static_cast<size_t>(max(1L, atol(argv[++i])));
+        } else if (arg == "--fsync" && hasValue) {
+            string policy = argv[++i];
+            fsyncPolicy = policy == "never" ? FsyncPolicy::Never
+                        : policy == "interval" ? FsyncPolicy::Interval : FsyncPolicy::Always;
+        } else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
     srand(time(nullptr));
-    FaminEcommerce ecommerce;
-    ecommerce.run();
-    return 0;
+    if (serve) {
+        // Replies own stdout; every other message goes to stderr.
+        ostream replies(cout.rdbuf());
+        cout.rdbuf(cerr.rdbuf());
+        FaminEcommerce ecommerce(orderMemoryBudget, kdfIterations, threads);
+        if (startupTimings)
+            ecommerce.printStartupTimings(cerr);
+        ecommerce.setFsyncPolicy(fsyncPolicy);
+        ecommerce.serve(threads, replies);
+        if (!metricsPath.empty())
+            FaminEcommerce::writeMetrics(metricsPath);
+        return 0;
+    }
+    FaminEcommerce ecommerce(orderMemoryBudget, kdfIterations, threads);
+    if (startupTimings)
+        ecommerce.printStartupTimings(cout);
+    ecommerce.setFsyncPolicy(fsyncPolicy);
+    int status = 0;
+    if (!importEntity.empty())
+        status = ecommerce.runImport(importEntity, transferPath, importPolicy);
+    else if (!exportEntity.empty())
+        status = ecommerce.runExport(exportEntity, transferPath);
+    else
+        ecommerce.run();
+    if (!metricsPath.empty())
+        FaminEcommerce::writeMetrics(metricsPath);
+    return status;
 }